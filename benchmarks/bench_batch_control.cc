@@ -0,0 +1,101 @@
+// remy
+#include <batch_control.h>
+#include <control.h>
+
+// std
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace remy_robot_control;
+
+/** Cost of a control tick per arm: N arms with a Control each versus one
+ * BatchControl (SoA, vectorized), for both control laws, in float.
+ * Usage: ./RemyRobotControl_Bench_BatchControl <path_to_input>
+ */
+
+typedef std::chrono::steady_clock Clock;
+
+struct TickCost {
+  double control_ns; ///< per arm, one Control per arm
+  double batch_ns; ///< per arm, one BatchControl
+};
+
+static TickCost benchTick(const std::vector<Vector4<float>>& waypoints,
+    ControlType type, size_t n) {
+  RemyControlSettings settings;
+  settings.control_type = type;
+  RemyRobotSettings robot;
+  BatchControl batch;
+  batch.setSettings(settings);
+  std::vector<std::unique_ptr<Control>> controls;
+  JointBlock<float> joints(n, robot);
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<float> offset(-1, 1);
+  std::uniform_real_distribution<float> angle(-1.5, 1.5);
+  for (size_t i = 0; i < n; ++i) {
+    std::vector<Vector4<float>> arm;
+    Vector4<float> shift(offset(gen), offset(gen), offset(gen), 0);
+    for (const auto& w : waypoints) {
+      arm.push_back(w + shift);
+    }
+    batch.add(arm);
+    controls.push_back(std::make_unique<Control>(arm));
+    controls.back()->setSettings(settings);
+    joints.set(i, {angle(gen), angle(gen), angle(gen)});
+  }
+
+  // ticks over the trajectory, about 2M arm-ticks per measure
+  const size_t ticks = std::max<size_t>(1, (1 << 21) / n);
+  const float end = waypoints.back()[3];
+  TickCost cost;
+  float sink = 0;
+  auto start = Clock::now();
+  for (size_t k = 0; k < ticks; ++k) {
+    const float t = end * k / ticks;
+    for (size_t i = 0; i < n; ++i) {
+      controls[i]->computeVelocityControl(joints.get(i), t);
+      sink += controls[i]->getControlSignal()[0];
+    }
+  }
+  std::chrono::duration<double, std::nano> d = Clock::now() - start;
+  cost.control_ns = d.count() / (ticks * n);
+
+  start = Clock::now();
+  for (size_t k = 0; k < ticks; ++k) {
+    batch.computeVelocityControl(joints, end * k / ticks);
+    sink += batch.u(0)[k % n];
+  }
+  d = Clock::now() - start;
+  cost.batch_ns = d.count() / (ticks * n);
+  if (sink == 42) std::cout << "";
+  return cost;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    std::cerr << "usage: " << argv[0] << " <path_to_input>\n";
+    return 1;
+  }
+  auto waypoints = Control(argv[1]).getWaypoints();
+  std::cout << std::setw(12) << "law" << std::setw(8) << "arms" 
+    << std::setw(16) << "Control ns/arm" << std::setw(14) << "Batch ns/arm"
+    << std::setw(10) << "speedup" << std::setw(18) << "Batch arms/s\n";
+  for (ControlType type : {ControlType::feedfoward, ControlType::analytical}) {
+    for (size_t n : {1, 16, 256, 4096}) {
+      TickCost c = benchTick(waypoints, type, n);
+      std::cout << std::setw(12) << (type == ControlType::analytical ? 
+        "analytical" : "feedforward") << std::setw(8) << n << std::fixed 
+        << std::setprecision(1) << std::setw(16) << c.control_ns 
+        << std::setw(14) << c.batch_ns << std::setw(10) 
+        << c.control_ns / c.batch_ns << std::setw(17) << std::scientific 
+        << std::setprecision(2) << 1e9 / c.batch_ns << "\n" 
+        << std::defaultfloat;
+    }
+  }
+  return 0;
+}
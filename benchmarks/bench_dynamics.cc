@@ -0,0 +1,125 @@
+// remy
+#include <dynamics.h>
+#include <robot_system.h>
+#include <utils.h>
+#include <alloc_scope.h>
+
+// std
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace remy_robot_control;
+
+/** Cost of the rigid-body dynamics: RNEA, CRBA and forward dynamics per call
+ * (float and double), then the cost of a step of the dynamic plant at 1 and
+ * 10 kHz with each integrator, and the resulting real-time factor. The
+ * timed plant steps must not allocate: they are counted (\sa AllocScope).
+ * Usage: ./RemyRobotControl_Bench_Dynamics
+ */
+
+typedef std::chrono::steady_clock Clock;
+
+static double nsPerOp(Clock::time_point start, size_t n) {
+  std::chrono::duration<double, std::nano> d = Clock::now() - start;
+  return d.count() / n;
+}
+
+struct DynamicsResult {
+  double rnea_ns;
+  double crba_ns;
+  double forward_ns;
+};
+
+template <class T>
+DynamicsResult benchDynamics(size_t n) {
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<T> u(-2, 2);
+  std::vector<Vector3<T>> x(n);
+  for (auto& v : x) {
+    v = {u(gen), u(gen), u(gen)};
+  }
+  DynamicsT<T> dynamics;
+  DynamicsResult result;
+  T sink = 0;
+  auto start = Clock::now();
+  for (size_t i = 0; i + 2 < n; ++i) {
+    sink += dynamics.inverseDynamics(x[i], x[i + 1], x[i + 2])[0];
+  }
+  result.rnea_ns = nsPerOp(start, n - 2);
+
+  start = Clock::now();
+  for (size_t i = 0; i < n; ++i) {
+    sink += dynamics.massMatrix(x[i])(0, 1);
+  }
+  result.crba_ns = nsPerOp(start, n);
+
+  start = Clock::now();
+  for (size_t i = 0; i + 2 < n; ++i) {
+    sink += dynamics.forwardDynamics(x[i], x[i + 1], x[i + 2])[0];
+  }
+  result.forward_ns = nsPerOp(start, n - 2);
+  if (sink == 42) std::cout << "";
+  return result;
+}
+
+static double benchPlant(IntegratorType type, double dt, double seconds,
+    size_t& allocations) {
+  RobotSystem system;
+  system.save_run = false;
+  RemySystemSettings settings;
+  settings.plant = PlantModel::dynamic;
+  settings.integrator = type;
+  system.setSettings(settings);
+  system.setControl(eigen3fToUchar3(Eigen::Vector3f(0.5f, 0.2f, -0.3f)));
+  const size_t steps = (size_t) (seconds / dt);
+  std::vector<unsigned char> joints;
+  system.step(dt, joints);
+  AllocScope scope;
+  auto start = Clock::now();
+  for (size_t k = 0; k < steps; ++k) {
+    system.step(dt, joints);
+  }
+  const double ns = nsPerOp(start, steps);
+  allocations += scope.allocations();
+  return ns;
+}
+
+int main() {
+  const size_t n = 1 << 18;
+  auto f = benchDynamics<float>(n);
+  auto d = benchDynamics<double>(n);
+  std::cout << std::setprecision(4)
+    << "                        float        double\n"
+    << "rnea [ns/call]        " << std::setw(8) << f.rnea_ns << "    "
+      << std::setw(8) << d.rnea_ns << "\n"
+    << "crba [ns/call]        " << std::setw(8) << f.crba_ns << "    "
+      << std::setw(8) << d.crba_ns << "\n"
+    << "forward [ns/call]     " << std::setw(8) << f.forward_ns << "    "
+      << std::setw(8) << d.forward_ns << "\n\n";
+
+  const std::vector<std::pair<std::string, IntegratorType>> integrators = {
+    {"euler", IntegratorType::euler},
+    {"semi_implicit", IntegratorType::semi_implicit},
+    {"rk4", IntegratorType::rk4}
+  };
+  std::cout << "plant step [ns] (real-time factor)\n"
+    << std::setw(16) << "" << std::setw(22) << "1 kHz"
+    << std::setw(22) << "10 kHz" << "\n";
+  size_t allocations = 0;
+  for (const auto& integrator : integrators) {
+    std::cout << std::setw(16) << integrator.first;
+    for (double dt : {0.001, 0.0001}) {
+      double ns = benchPlant(integrator.second, dt, 10, allocations);
+      std::cout << std::setw(12) << ns << " (" << std::setw(7)
+        << dt * 1e9 / ns << ")";
+    }
+    std::cout << "\n";
+  }
+  if (AllocScope::enabled())
+    std::cout << "\nheap allocations in the plant steps: " << allocations << 
+      "\n";
+}
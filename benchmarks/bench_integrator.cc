@@ -0,0 +1,108 @@
+// remy
+#include <robot_system.h>
+#include <utils.h>
+
+// std
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace remy_robot_control;
+
+/** Accuracy versus cost of the plant integrators: the plant follows a smooth
+ * horizon of velocity setpoints through first order velocity loops, and each
+ * integrator runs it at several plant steps. The error is the max joint
+ * distance to a fine RK4 reference, sampled every 100 ms, and the cost is
+ * the wall time per simulated second.
+ * Usage: ./RemyRobotControl_Bench_Integrator [actuator_tau]
+ */
+
+typedef std::chrono::steady_clock Clock;
+
+static const double kSeconds = 5;
+static const double kSample = 0.1;
+
+struct Config {
+  std::string name;
+  IntegratorType type;
+  double max_step;
+};
+
+static std::vector<Eigen::Vector3f> runPlant(
+    const std::vector<unsigned char>& command, const Config& config,
+    float tau, double dt, double& us_per_second) {
+  RobotSystem system;
+  system.save_run = false;
+  RemySystemSettings settings;
+  settings.actuator_tau = tau;
+  settings.integrator = config.type;
+  settings.integrator_step = config.max_step;
+  system.setSettings(settings);
+  system.setControl(command);
+
+  const int steps = (int) std::lround(kSeconds / dt);
+  const int every = std::max(1, (int) std::lround(kSample / dt));
+  std::vector<Eigen::Vector3f> samples;
+  samples.reserve(steps / every + 1);
+  auto start = Clock::now();
+  for (int k = 1; k <= steps; ++k) {
+    system.step(dt);
+    if (k % every == 0)
+      samples.push_back(system.getJoints());
+  }
+  std::chrono::duration<double, std::micro> d = Clock::now() - start;
+  us_per_second = d.count() / kSeconds;
+  return samples;
+}
+
+int main(int argc, char **argv) {
+  const float tau = (argc > 1) ? std::stof(argv[1]) : 0.02f;
+
+  // smooth joint velocities, well within the joint limits
+  const float h = 0.01f;
+  std::vector<Eigen::Vector3f> setpoints((size_t) (kSeconds / (double) h) + 1);
+  for (size_t k = 0; k < setpoints.size(); ++k) {
+    float t = k * h;
+    setpoints[k] = {std::sin(3 * t), 0.5f * std::cos(2 * t), std::sin(5 * t)};
+  }
+  auto command = horizonToUchar(setpoints, 0, h);
+
+  double cost;
+  auto reference = runPlant(command, {"reference", IntegratorType::rk4, 1e-5},
+    tau, 0.001, cost);
+
+  const std::vector<Config> configs = {
+    {"euler", IntegratorType::euler, 0},
+    {"semi_implicit", IntegratorType::semi_implicit, 0},
+    {"rk4", IntegratorType::rk4, 0},
+    {"euler/1ms", IntegratorType::euler, 0.001},
+    {"semi_implicit/1ms", IntegratorType::semi_implicit, 0.001},
+    {"rk4/5ms", IntegratorType::rk4, 0.005}
+  };
+  const std::vector<double> steps = {0.001, 0.005, 0.01, 0.02, 0.05};
+
+  std::cout << "actuator tau " << tau << " s, max joint error [rad] / "
+    "cost [us per simulated s]\n" << std::setw(18) << "dt [s]";
+  for (auto dt : steps) {
+    std::cout << std::setw(22) << dt;
+  }
+  std::cout << "\n" << std::setprecision(3);
+  for (const auto& config : configs) {
+    std::cout << std::setw(18) << config.name;
+    for (auto dt : steps) {
+      auto samples = runPlant(command, config, tau, dt, cost);
+      double error = 0;
+      for (size_t i = 0; i < std::min(samples.size(), reference.size()); ++i) {
+        double e = (samples[i] - reference[i]).norm();
+        error = std::isfinite(e) ? std::max(error, e) :
+          std::numeric_limits<double>::infinity();
+      }
+      std::cout << std::setw(12) << error << " /" << std::setw(8) << cost;
+    }
+    std::cout << "\n";
+  }
+}
@@ -0,0 +1,151 @@
+// remy
+#include <control.h>
+#include <robot.h>
+
+// std
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <string>
+
+using namespace remy_robot_control;
+
+/** Compares the float and double instantiations of the kinematics stack:
+ * cost per call (FK, Jacobian, damped IK, control law) and accuracy wrt the
+ * double results. Usage: ./RemyRobotControl_Bench_Precision <path_to_input>
+ */
+
+typedef std::chrono::steady_clock Clock;
+
+static double nsPerOp(Clock::time_point start, size_t n) {
+  std::chrono::duration<double, std::nano> d = Clock::now() - start;
+  return d.count() / n;
+}
+
+static std::vector<Eigen::Vector3d> randomJoints(size_t n) {
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> q1(-M_PI, M_PI);
+  std::uniform_real_distribution<double> q2(-M_PI_2, M_PI_2);
+  std::vector<Eigen::Vector3d> joints(n);
+  for (auto& q : joints) {
+    q = {q1(gen), q2(gen), q1(gen)};
+  }
+  return joints;
+}
+
+template <class T>
+struct KinematicsResult {
+  double fk_ns;
+  double jacob_ns;
+  double ik_ns;
+  std::vector<Eigen::Vector3d> fk;
+  double ik_error;
+};
+
+template <class T>
+KinematicsResult<T> benchKinematics(const std::vector<Eigen::Vector3d>& joints,
+    size_t n_ik) {
+  KinematicsResult<T> result;
+  RobotT<T> robot;
+  std::vector<Vector3<T>> q(joints.size());
+  for (size_t i = 0; i < joints.size(); ++i) {
+    q[i] = joints[i].cast<T>();
+  }
+
+  result.fk.resize(q.size());
+  auto start = Clock::now();
+  for (size_t i = 0; i < q.size(); ++i) {
+    result.fk[i] = robot.forwardKinematics(q[i]).template cast<double>();
+  }
+  result.fk_ns = nsPerOp(start, q.size());
+
+  T sink = 0;
+  start = Clock::now();
+  for (size_t i = 0; i < q.size(); ++i) {
+    sink += robot.jacob(q[i])(0, 0);
+  }
+  result.jacob_ns = nsPerOp(start, q.size());
+  if (sink == 42) std::cout << "";
+
+  robot.setIk(IkType::damped);
+  result.ik_error = 0;
+  start = Clock::now();
+  for (size_t i = 0; i < n_ik; ++i) {
+    auto& x = result.fk[i];
+    auto qi = robot.inverseKinematics(static_cast<T>(x[0]),
+      static_cast<T>(x[1]), static_cast<T>(x[2]));
+    Eigen::Vector3d xi = robot.forwardKinematics(qi).template cast<double>();
+    result.ik_error = std::max(result.ik_error, (xi - x).norm());
+  }
+  result.ik_ns = nsPerOp(start, n_ik);
+  return result;
+}
+
+template <class T>
+struct ClosedLoopResult {
+  double step_ns;
+  double rms_error;
+};
+
+template <class T>
+ClosedLoopResult<T> benchClosedLoop(const std::string& input) {
+  ControlT<T> control(input);
+  RobotT<T> robot(0, 0, 0);
+  auto waypoints = control.getWaypoints();
+  TrajectoryT<T> reference(waypoints);
+  const T dt = static_cast<T>(0.001);
+  const int steps = 11000;
+  double sq_error = 0;
+  int samples = 0;
+  auto start = Clock::now();
+  for (int k = 0; k < steps; ++k) {
+    T t = k * dt;
+    control.computeVelocityControl(robot.getJoints(), t);
+    robot.update(control.getControlSignal(), dt);
+    if (reference.update(t)) {
+      auto p = robot.forwardKinematics(robot.getJoints());
+      sq_error += (reference.x - p).template cast<double>().squaredNorm();
+      ++samples;
+    }
+  }
+  ClosedLoopResult<T> result;
+  result.step_ns = nsPerOp(start, steps);
+  result.rms_error = std::sqrt(sq_error / std::max(samples, 1));
+  return result;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    std::cerr << "usage: " << argv[0] << " <path_to_input>\n";
+    return 1;
+  }
+  const size_t n = 1 << 20;
+  const size_t n_ik = 2000;
+  auto joints = randomJoints(n);
+
+  auto kf = benchKinematics<float>(joints, n_ik);
+  auto kd = benchKinematics<double>(joints, n_ik);
+  double fk_error = 0;
+  for (size_t i = 0; i < n; ++i) {
+    fk_error = std::max(fk_error, (kf.fk[i] - kd.fk[i]).norm());
+  }
+  auto cf = benchClosedLoop<float>(argv[1]);
+  auto cd = benchClosedLoop<double>(argv[1]);
+
+  std::cout << std::setprecision(4)
+    << "                       float        double\n"
+    << "fk [ns/call]         " << std::setw(8) << kf.fk_ns << "    "
+      << std::setw(8) << kd.fk_ns << "\n"
+    << "jacobian [ns/call]   " << std::setw(8) << kf.jacob_ns << "    "
+      << std::setw(8) << kd.jacob_ns << "\n"
+    << "damped ik [ns/call]  " << std::setw(8) << kf.ik_ns << "    "
+      << std::setw(8) << kd.ik_ns << "\n"
+    << "control step [ns]    " << std::setw(8) << cf.step_ns << "    "
+      << std::setw(8) << cd.step_ns << "\n"
+    << "ik max error         " << std::setw(8) << kf.ik_error << "    "
+      << std::setw(8) << kd.ik_error << "\n"
+    << "tracking rms error   " << std::setw(8) << cf.rms_error << "    "
+      << std::setw(8) << cd.rms_error << "\n"
+    << "fk max |float - double|: " << fk_error << "\n";
+}
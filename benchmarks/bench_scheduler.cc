@@ -0,0 +1,109 @@
+// remy
+#include <control.h>
+#include <robot_system.h>
+#include <scheduler.h>
+
+// std
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace remy_robot_control;
+
+/** Controller/plant pairs run by threads (two per arm) and by a single 
+ * scheduler thread (\sa Scheduler), in real time: the CPU time they take per
+ * wall-second and the plant steps they achieve, relative to the 1 kHz rate.
+ * Usage: ./RemyRobotControl_Bench_Scheduler <path_to_input> [arms] [seconds]
+ */
+
+struct Arms {
+  std::vector<std::unique_ptr<Control>> controls;
+  std::vector<std::unique_ptr<RobotSystem>> systems;
+
+  Arms(const std::string& input, size_t n) {
+    RemySystemSettings settings;
+    settings.frequency = 1000;
+    settings.recorder_seconds = 1;
+    for (size_t i = 0; i < n; ++i) {
+      controls.push_back(std::make_unique<Control>(input));
+      systems.push_back(std::make_unique<RobotSystem>());
+      systems.back()->setSettings(settings);
+      systems.back()->save_run = false;
+      // the dumps at stop are not needed
+      systems.back()->recorder = nullptr;
+    }
+  }
+
+  void stop() {
+    for (size_t i = 0; i < controls.size(); ++i) {
+      controls[i]->stop();
+      systems[i]->stop();
+    }
+  }
+};
+
+struct RunResult {
+  double cpu_per_second; ///< CPU seconds per wall-second
+  double plant_rate; ///< achieved plant steps over the nominal ones
+};
+
+/** It runs the arms for a while, with threads or with a scheduler */
+static RunResult run(const std::string& input, size_t n, double seconds,
+    bool scheduled) {
+  Arms arms(input, n);
+  Scheduler scheduler;
+  auto cpu = std::clock();
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < n; ++i) {
+    if (scheduled) {
+      arms.systems[i]->start(arms.controls[i]->connection, scheduler);
+      arms.controls[i]->start(arms.systems[i]->connection, scheduler);
+    }
+    else {
+      arms.systems[i]->start(arms.controls[i]->connection);
+      arms.controls[i]->start(arms.systems[i]->connection);
+    }
+  }
+  if (scheduled)
+    scheduler.start();
+  std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+  size_t steps = 0;
+  for (size_t i = 0; i < n; ++i) {
+    steps += arms.systems[i]->connection->sequence();
+  }
+  std::chrono::duration<double> wall = std::chrono::steady_clock::now() - 
+    start;
+  double cpu_seconds = (double) (std::clock() - cpu) / CLOCKS_PER_SEC;
+  arms.stop();
+  scheduler.stop();
+
+  RunResult result;
+  result.cpu_per_second = cpu_seconds / wall.count();
+  result.plant_rate = steps / (n * wall.count() * 1000);
+  return result;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    std::cerr << "usage: " << argv[0] << " <path_to_input> [arms] [seconds]\n";
+    return 1;
+  }
+  const size_t arms = (argc > 2) ? std::stoul(argv[2]) : 100;
+  const double seconds = (argc > 3) ? std::stod(argv[3]) : 3;
+  std::cout << arms << " arms for " << seconds << " s\n"
+    << std::setw(10) << "mode" << std::setw(10) << "threads" 
+    << std::setw(14) << "cpu/wall" << std::setw(14) << "plant rate\n";
+  for (bool scheduled : {false, true}) {
+    RunResult r = run(argv[1], arms, seconds, scheduled);
+    std::cout << std::setw(10) << (scheduled ? "scheduler" : "threads")
+      << std::setw(10) << (scheduled ? 1 : 2 * arms)
+      << std::fixed << std::setprecision(3) 
+      << std::setw(14) << r.cpu_per_second 
+      << std::setw(13) << r.plant_rate << "\n";
+  }
+  return 0;
+}
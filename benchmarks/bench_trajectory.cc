@@ -0,0 +1,94 @@
+// remy
+#include <trajectory.h>
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+/** Cost of Trajectory::update at random seeks and in sequence, from a
+ * thousand to ten million segments of uneven durations, against a binary
+ * search of all the waypoints (the former layout: a vector of Vector4f and
+ * the duplicated times).
+ * Usage: ./RemyRobotControl_Bench_Trajectory
+ */
+
+typedef std::chrono::steady_clock Clock;
+
+static double nsPerOp(Clock::time_point start, size_t n) {
+  std::chrono::duration<double, std::nano> d = Clock::now() - start;
+  return d.count() / n;
+}
+
+/** The former lookup: a binary search of all the segments */
+struct SearchLookup {
+  std::vector<Eigen::Vector4f> waypoints;
+  std::vector<float> times;
+  Eigen::Vector3f x;
+  Eigen::Vector3f v;
+
+  bool update(float t) {
+    auto it = std::lower_bound(times.begin(), times.end(), t);
+    if (it == times.end()) return false;
+    size_t k = it - times.begin();
+    float t0 = (k == 0) ? 0 : times[k - 1];
+    Eigen::Vector3f x0 = (k == 0) ? Eigen::Vector3f::Zero() :
+      Eigen::Vector3f(waypoints[k - 1].head<3>());
+    Eigen::Vector3f xf = waypoints[k].head<3>();
+    v = (times[k] == t0) ? Eigen::Vector3f::Zero() : 
+      Eigen::Vector3f((xf - x0) / (times[k] - t0));
+    x = x0 + v * (t - t0);
+    return true;
+  }
+};
+
+template <class Lookup>
+double benchLookup(Lookup& lookup, const std::vector<float>& queries) {
+  float sink = 0;
+  auto start = Clock::now();
+  for (float t : queries) {
+    if (lookup.update(t))
+      sink += lookup.x[0];
+  }
+  double ns = nsPerOp(start, queries.size());
+  if (sink == 42) std::cout << "";
+  return ns;
+}
+
+int main() {
+  std::cout << std::setw(10) << "segments" << std::setw(16) << "search seek ns"
+    << std::setw(15) << "index seek ns" << std::setw(16) << "search scan ns"
+    << std::setw(15) << "index scan ns\n";
+  for (size_t n : {1000, 100000, 10000000}) {
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> unit(0, 1);
+    SearchLookup search;
+    search.waypoints.reserve(n);
+    float t = 0;
+    for (size_t k = 0; k < n; ++k) {
+      const float u = unit(gen);
+      t += (u < 0.9f) ? u * 1e-3f : u * 1e-2f;
+      search.waypoints.push_back(Eigen::Vector4f(unit(gen), unit(gen), 
+        unit(gen), t));
+      search.times.push_back(t);
+    }
+    Trajectory index(search.waypoints);
+
+    const size_t m = 2000000;
+    std::vector<float> seeks(m);
+    std::vector<float> scan(m);
+    for (size_t i = 0; i < m; ++i) {
+      seeks[i] = unit(gen) * t;
+      scan[i] = t * i / m;
+    }
+    std::cout << std::setw(10) << n << std::fixed << std::setprecision(1) 
+      << std::setw(16) << benchLookup(search, seeks) 
+      << std::setw(15) << benchLookup(index, seeks) 
+      << std::setw(16) << benchLookup(search, scan) 
+      << std::setw(14) << benchLookup(index, scan) << "\n";
+  }
+  return 0;
+}
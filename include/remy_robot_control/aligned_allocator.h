@@ -0,0 +1,56 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace remy_robot_control {
+
+/** Size of a cache line [bytes] */
+constexpr size_t kCacheLine = 64;
+
+/** Allocator of arrays aligned to a cache line (or to Alignment, a power of
+ * two), so that a SoA array starts on a line of its own and the first
+ * elements of several arrays never share one. With std::vector:
+ * std::vector<float, AlignedAllocator<float>>.
+ */
+template <class T, size_t Alignment = kCacheLine>
+struct AlignedAllocator {
+  typedef T value_type;
+
+  template <class U>
+  struct rebind {
+    typedef AlignedAllocator<U, Alignment> other;
+  };
+
+  AlignedAllocator() noexcept {}
+
+  template <class U>
+  AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+  T* allocate(size_t n) {
+    void* p = nullptr;
+    if (posix_memalign(&p, Alignment, n * sizeof(T)) != 0)
+      throw std::bad_alloc();
+    return static_cast<T*>(p);
+  }
+
+  void deallocate(T* p, size_t) noexcept {
+    std::free(p);
+  }
+};
+
+template <class T, class U, size_t Alignment>
+bool operator==(const AlignedAllocator<T, Alignment>&,
+    const AlignedAllocator<U, Alignment>&) {
+  return true;
+}
+
+template <class T, class U, size_t Alignment>
+bool operator!=(const AlignedAllocator<T, Alignment>&,
+    const AlignedAllocator<U, Alignment>&) {
+  return false;
+}
+
+} // end namespace remy_robot_control
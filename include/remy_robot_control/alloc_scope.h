@@ -0,0 +1,69 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <string>
+
+namespace remy_robot_control {
+
+/** Counter of the heap allocations of the calling thread while it lives, to
+ * check that a realtime path does not allocate (e.g. one tick of a loop).
+ * It is opt-in: the executables which link the hooks (src/alloc_hooks.cc, the
+ * ${PROJECT_NAME}_AllocHooks objects) replace the global operator new and
+ * operator delete, and the others count nothing (\sa enabled). The hooks
+ * record the call stack of each allocation within a scope, so report() can
+ * tell where they come from. Allocations that bypass operator new (malloc,
+ * Eigen dynamic matrices, AlignedAllocator) are not seen. \n
+ * Scopes may nest: the counters of a scope are the ones since it opened, and
+ * the call sites are the ones since the outermost scope opened.
+ */
+class AllocScope {
+  size_t allocations_;
+  size_t deallocations_;
+  size_t bytes_;
+
+  public:
+    AllocScope();
+    ~AllocScope();
+
+    AllocScope(const AllocScope&) = delete;
+    AllocScope& operator=(const AllocScope&) = delete;
+
+    /** \return number of operator new calls of this thread in the scope */
+    size_t allocations() const;
+
+    /** \return number of operator delete calls (of non null pointers) */
+    size_t deallocations() const;
+
+    /** \return bytes asked for by the allocations */
+    size_t bytes() const;
+
+    /** It describes the call sites of the allocations, the most frequent
+     * first: count, bytes and call stack of each one (the report itself is
+     * not counted)
+     * \param frames maximum number of frames of each stack
+     */
+    std::string report(int frames = 6) const;
+
+    /** \return true if the hooks are linked, else the counters stay at 0 */
+    static bool enabled();
+};
+
+namespace detail {
+
+/** Called by the hooks on each operator new
+ * \param size bytes
+ * \param caller return address of the operator new 
+ * (__builtin_return_address(0)), where the reported stacks start
+ */
+void recordAllocation(size_t size, const void* caller);
+
+/** Called by the hooks on each operator delete of a non null pointer */
+void recordDeallocation();
+
+/** Called once by the hooks when the executable starts */
+void installAllocHooks();
+
+} // end namespace detail
+
+} // end namespace remy_robot_control
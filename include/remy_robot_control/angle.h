@@ -1,7 +1,59 @@
 #pragma once
 
+// std
+#include <cmath>
+#include <algorithm>
+
 namespace remy_robot_control {
 
+/** \f$\pi\f$ in the scalar type T, so float code does not mix in the 
+ * double M_PI */
+template <class T>
+constexpr T kPi = static_cast<T>(3.14159265358979323846);
+
+/** \f$\pi/2\f$ in the scalar type T */
+template <class T>
+constexpr T kPi_2 = static_cast<T>(1.57079632679489661923);
+
+/** It wraps an angle to \f$[-\pi, \pi]\f$. Generic (slow) path, it uses fmod.
+ * \param value angle
+ * \return the wrapped angle
+*/
+template <class T>
+inline T wrapToPi(T value) {
+  value = std::fmod(value, 2 * kPi<T>);
+  value += (value > kPi<T>) ? - 2 * kPi<T> : 0;
+  value += (value < - kPi<T>) ? 2 * kPi<T> : 0;
+  return value;
+}
+
+/** Fast path of wrapToPi for float: branchless and without fmod, so loops
+ * over arrays of angles vectorize. It subtracts \f$2\pi k\f$, k being the
+ * nearest integer of \f$value / 2\pi\f$, with \f$2\pi\f$ split in two
+ * constants (Cody-Waite) to keep the float precision. Valid for
+ * \f$|value| < 2^{16} \pi\f$.
+ * \param value angle
+ * \return the wrapped angle
+*/
+inline float wrapToPi(float value) {
+  constexpr float kInvTwoPi = 0.15915494309189535f;
+  constexpr float kTwoPiHi = 6.28125f;
+  constexpr float kTwoPiLo = 1.9353071795864769e-3f;
+  float k = (float)(int)(value * kInvTwoPi + std::copysign(0.5f, value));
+  return (value - k * kTwoPiHi) - k * kTwoPiLo;
+}
+
+/** It wraps an angle to \f$[-\pi, \pi]\f$ and clamps it to [min, max]
+ * \param value angle
+ * \param min lower limit
+ * \param max upper limit
+ * \return the wrapped and clamped angle
+*/
+template <class T>
+inline T wrapAndClamp(T value, T min, T max) {
+  return std::min(std::max(wrapToPi(value), min), max);
+}
+
 /** A custom class to handle angles properly \f$(-\pi, \pi)\f$. One may choose the angle
  * Limits.
 */
@@ -10,14 +62,14 @@ class Angle {
   T value_;
   T min_;
   T max_;
-  
-  public: 
-    Angle(T value = T{}, T min = static_cast<T>(-M_PI), 
-      T max = static_cast<T>(M_PI)) : value_(value), max_(max), min_(min)
+
+  public:
+    Angle(T value = T{}, T min = - kPi<T>, T max = kPi<T>) : 
+      value_(value), min_(min), max_(max)
     {
       norm();
     }
-    
+
     T operator()(void){
       return value_;
     }
@@ -28,17 +80,39 @@ class Angle {
       return value_;
     }
 
+    T min() const {
+      return min_;
+    }
+
+    T max() const {
+      return max_;
+    }
+
+    /** It changes the limits, and it wraps and clamps the value to them */
+    void setLimits(T min, T max) {
+      min_ = min;
+      max_ = max;
+      norm();
+    }
+
     Angle& operator+=(const Angle& rhs)
-    { 
+    {
       value_ += rhs.value_;
-      norm();                          
+      norm();
       return *this;
     }
 
-    friend Angle operator+(Angle lhs, const Angle& rhs)
+    /** Same as above without building (and normalizing) a temporary Angle */
+    Angle& operator+=(const T& rhs)
     {
-      lhs.value += rhs.value;
+      value_ += rhs;
       norm();
+      return *this;
+    }
+
+    friend Angle operator+(Angle lhs, const Angle& rhs)
+    {
+      lhs += rhs;
       return lhs;
     }
 
@@ -46,20 +120,19 @@ class Angle {
       value_ = other.value_;
       min_ = other.min_;
       max_ = other.max_;
+      return *this;
     }
 
     Angle& operator=(const T& other) {
       value_ = other;
       norm();
+      return *this;
     }
 
   private:
     void norm() {
-      value_ = fmod(value_, 2 * M_PI);
-      value_ += (value_ > M_PI) ? - 2 * M_PI : 0;
-      value_ += (value_ < - M_PI) ? 2 * M_PI : 0;
-      value_ = std::min(std::max(value_, min_), max_);
+      value_ = wrapAndClamp(value_, min_, max_);
     }
 };
 
-} // end namespace remy_robot_cotrol
\ No newline at end of file
+} // end namespace remy_robot_cotrol
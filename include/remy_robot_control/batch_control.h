@@ -0,0 +1,126 @@
+#pragma once
+
+// remy
+#include <types.h>
+#include <robot.h>
+#include <joint_block.h>
+
+// std
+#include <vector>
+#include <cstddef>
+
+// Eigen
+#include <Eigen/Geometry>
+
+namespace remy_robot_control {
+
+/** One controller for N arms: the batch version of ControlT, for multi-arm
+ * cells. It holds the N trajectories and it computes the control law of all
+ * the arms at once from their joints in a JointBlock, in SoA layout: the
+ * desired positions and velocities of every arm are gathered first (O(1) per
+ * arm, with a cursor per trajectory), then the control law runs as loops
+ * over the arms without branches nor float compares (which GCC does not
+ * vectorize), that the -O3 vectorizer turns into SIMD. The libm calls (and
+ * the branches of the inverse kinematics) run in scalar loops of their own.
+ * The laws are the ones of ControlT: the feedforward DLS law (with the
+ * closed form of the 3x3 damped inverse) and the analytical one (with the
+ * analytical inverse kinematics and the ReachPolicy of the robot settings;
+ * the IK cache and reachability maps are not used).
+ * BatchControl (float) and BatchControld (double) are explicitly
+ * instantiated.
+ */
+template <class T>
+class BatchControlT {
+  typedef remy_robot_control::Vector3<T> Vector3;
+  typedef remy_robot_control::Vector4<T> Vector4;
+
+  ControlType type;
+  T period_;
+  T kp;
+  T damping_w0;
+  T damping_alpha0;
+  T q0dot[3];
+  ReachPolicy reach_policy;
+  T reach_min;
+  T reach_max;
+  Vector3 q_min;
+  Vector3 q_max;
+
+  // waypoints of the arm i are [offsets[i], offsets[i + 1])
+  std::vector<T> times;
+  std::vector<T> waypoints[3];
+  std::vector<size_t> offsets;
+  std::vector<size_t> cursors;
+
+  // desired state at the last time, and the control signals
+  std::vector<T> xd[3];
+  std::vector<T> vd[3];
+  std::vector<T> active;
+  std::vector<T> u_[3];
+  std::vector<T> scratch[8]; ///< per arm temporaries of the laws
+
+  public:
+    BatchControlT();
+
+    /** It sets the control settings, shared by every arm
+     * \param settings \sa RemyControlSettings
+     */
+    void setSettings(const RemyControlSettings& settings);
+
+    /** It sets the robot model settings, shared by every arm
+     * \param settings \sa RemyRobotSettings (limits and reach policy)
+     */
+    void setRobotSettings(const RemyRobotSettings& settings);
+
+    /** It adds an arm
+     * \param waypoints its trajectory (x, y, z, t)
+     * \return its index
+     */
+    size_t add(const std::vector<Vector4>& waypoints);
+
+    /** Number of arms */
+    size_t size() const {
+      return cursors.size();
+    }
+
+    /** It computes the control signal of every arm (\sa
+     * ControlT::computeVelocityControl)
+     * \param joints joints of the arms, in the order they were added
+     * \param t current time, the same for every arm
+     */
+    void computeVelocityControl(const JointBlock<T>& joints, T t);
+
+    /** \return the contiguous control signals of a joint (0, 1 or 2) */
+    const T* u(int joint) const {
+      return u_[joint].data();
+    }
+
+    /** \return the control signal of an arm */
+    Vector3 getControlSignal(size_t arm) const {
+      return {u_[0][arm], u_[1][arm], u_[2][arm]};
+    }
+
+    /** \return the control period [s] (\sa ControlT::period) */
+    T period() const {
+      return period_;
+    }
+
+  private:
+    /** It gathers the desired position and velocity of every arm at t (\sa
+     * TrajectoryT::update) */
+    void sample(T t);
+
+    /** The feedforward DLS law over all the arms */
+    void feedforward(const JointBlock<T>& joints);
+
+    /** The analytical law over all the arms */
+    void analytical(const JointBlock<T>& joints);
+};
+
+extern template class BatchControlT<float>;
+extern template class BatchControlT<double>;
+
+typedef BatchControlT<float> BatchControl;
+typedef BatchControlT<double> BatchControld;
+
+} // end namespace remy_robot_control
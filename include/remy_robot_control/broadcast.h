@@ -0,0 +1,166 @@
+#pragma once
+
+// std
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace remy_robot_control {
+
+/** One writer, many readers channel over a ring of the last Capacity
+ * messages. The writer never waits nor takes a lock: each slot is a seqlock
+ * (its sequence is odd while it is written), and each Reader keeps its own
+ * cursor, so readers do not load the writer nor each other. A reader that
+ * falls more than Capacity messages behind is not able to block the writer: it
+ * detects the overrun, skips to the oldest message still in the ring and
+ * counts the lost ones.
+ * The messages are copied word by word with relaxed atomics, thus T must be
+ * trivially copyable.
+ */
+template <class T, size_t Capacity = 64>
+class BroadcastChannel {
+  static_assert(std::is_trivially_copyable<T>::value,
+    "messages must be trivially copyable");
+  static_assert(Capacity > 0, "empty ring");
+
+  static constexpr size_t kWords = (sizeof(T) + 3) / 4;
+
+  struct Slot {
+    std::atomic<uint64_t> sequence; ///< 2n once message n is written
+    std::array<std::atomic<uint32_t>, kWords> words;
+  };
+
+  std::array<Slot, Capacity> ring;
+  std::atomic<uint64_t> head; ///< number of published messages
+
+  public:
+    BroadcastChannel() : head(0) {
+      for (auto& slot : ring) {
+        slot.sequence.store(0, std::memory_order_relaxed);
+        for (auto& w : slot.words) {
+          w.store(0, std::memory_order_relaxed);
+        }
+      }
+    }
+
+    BroadcastChannel(const BroadcastChannel&) = delete;
+    BroadcastChannel& operator=(const BroadcastChannel&) = delete;
+
+    /** It publishes a message (single writer, wait-free)
+     * \param message
+     */
+    void publish(const T& message) {
+      uint32_t buffer[kWords] = {};
+      std::memcpy(buffer, &message, sizeof(T));
+      const uint64_t n = head.load(std::memory_order_relaxed) + 1;
+      Slot& slot = ring[(n - 1) % Capacity];
+      slot.sequence.store(2 * n - 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      for (size_t i = 0; i < kWords; ++i) {
+        slot.words[i].store(buffer[i], std::memory_order_relaxed);
+      }
+      slot.sequence.store(2 * n, std::memory_order_release);
+      head.store(n, std::memory_order_release);
+    }
+
+    /** \return number of published messages */
+    uint64_t published() const {
+      return head.load(std::memory_order_acquire);
+    }
+
+    /** Outcome of Reader::read */
+    enum class Status {
+      ok, ///< next message read
+      empty, ///< nothing new
+      overrun ///< messages were lost, the oldest one available was read
+    };
+
+    /** A cursor over the channel. Readers are independent and lock-free, but
+     * each one must be used by a single thread. */
+    class Reader {
+      const BroadcastChannel* channel;
+      uint64_t cursor;
+      uint64_t lost_;
+
+      public:
+        /** It starts after the last published message */
+        explicit Reader(const BroadcastChannel& c) : channel(&c),
+          cursor(c.published()), lost_(0) {}
+
+        /** It reads the next message
+         * \param message the message (untouched if empty)
+         * \return \sa Status
+         */
+        Status read(T& message) {
+          bool overrun = false;
+          while (true) {
+            const uint64_t head = channel->published();
+            if (cursor >= head)
+              return Status::empty;
+            if (head - cursor > Capacity) { // overwritten already
+              lost_ += head - cursor - Capacity;
+              cursor = head - Capacity;
+              overrun = true;
+            }
+            if (channel->tryRead(cursor + 1, message)) {
+              ++cursor;
+              return overrun ? Status::overrun : Status::ok;
+            }
+            // overwritten while reading: catch up and retry
+            overrun = true;
+          }
+        }
+
+        /** It skips to the last message and reads it
+         * \param message the message (untouched if empty)
+         * \return false if nothing was published
+         */
+        bool readLatest(T& message) {
+          while (true) {
+            const uint64_t head = channel->published();
+            if (head == 0)
+              return false;
+            if (channel->tryRead(head, message)) {
+              cursor = head;
+              return true;
+            }
+          }
+        }
+
+        /** \return number of messages published and not read yet */
+        uint64_t lag() const {
+          return channel->published() - cursor;
+        }
+
+        /** \return number of messages lost by overruns */
+        uint64_t lost() const {
+          return lost_;
+        }
+    };
+
+    /** \return a new reader, starting after the last published message */
+    Reader subscribe() const {
+      return Reader(*this);
+    }
+
+  private:
+    /** It copies message n, false if the slot holds another one */
+    bool tryRead(uint64_t n, T& message) const {
+      const Slot& slot = ring[(n - 1) % Capacity];
+      if (slot.sequence.load(std::memory_order_acquire) != 2 * n)
+        return false;
+      uint32_t buffer[kWords];
+      for (size_t i = 0; i < kWords; ++i) {
+        buffer[i] = slot.words[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.sequence.load(std::memory_order_relaxed) != 2 * n)
+        return false;
+      std::memcpy(&message, buffer, sizeof(T));
+      return true;
+    }
+};
+
+} // end namespace remy_robot_control
@@ -1,27 +1,61 @@
 #pragma once
 
+#include <trace.h>
+
 #include <vector>
+#include <functional>
 #include <mutex>
 #include <atomic>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
 
+/** Single slot channel between two threads. Every message gets a sequence
+ * number (1, 2, ...) and a time stamp when it is sent, so a reader can tell a
+ * new message from the one it already has and how old it is. Readers may
+ * block until a new message arrives (or the connection opens) instead of
+ * polling: the writer wakes them up through a condition variable, and a
+ * listener, if any (\sa setListener).
+ */
 class Connection
 {
-  std::vector<unsigned char> data_;
-  std::atomic<bool> opened_;
-  std::mutex mutex;
-  
   public:
-    Connection() {
-      data_.reserve(12);
+    typedef std::chrono::steady_clock Clock;
+
+  private:
+    std::vector<unsigned char> data_;
+    std::atomic<bool> opened_;
+    std::mutex mutex;
+    std::condition_variable cv;
+    uint64_t sequence_;
+    Clock::time_point stamp_;
+    std::function<void()> listener_;
+
+  public:
+    /** \param capacity reserved for the messages: sending larger ones
+     * allocates */
+    explicit Connection(size_t capacity = 16) : opened_(false), 
+        sequence_(0) {
+      data_.reserve(capacity);
     }
     ~Connection() {}
 
     int open(){
-      opened_ = true;
+      {
+        std::lock_guard<std::mutex>lock(mutex);
+        opened_ = true;
+      }
+      cv.notify_all();
+      return 0;
     };
-    
+
     int close(){
-      opened_ = false;
+      {
+        std::lock_guard<std::mutex>lock(mutex);
+        opened_ = false;
+      }
+      cv.notify_all();
+      return 0;
     };
 
     bool isOpened() {
@@ -30,13 +64,83 @@ class Connection
 
     //send data to the robot. use explicit pointer convertion
     int send(std::vector<unsigned char> &data){
-      std::lock_guard<std::mutex>lock(mutex);
-      data_ = data;
+      REMY_TRACE_ZONE("connection.send");
+      {
+        std::lock_guard<std::mutex>lock(mutex);
+        data_ = data;
+        ++sequence_;
+        stamp_ = Clock::now();
+        if (listener_)
+          listener_();
+      }
+      cv.notify_all();
+      return 0;
     };
 
+    /** It sets a function called by every send, once the message is in
+     * (sending thread, under the lock of the connection: it must not use the
+     * connection), e.g. to wake up a task which cannot block (\sa 
+     * Scheduler::wake). Once it is reset, it is not running anymore.
+     * \param listener empty to reset it
+     */
+    void setListener(std::function<void()> listener) {
+      std::lock_guard<std::mutex>lock(mutex);
+      listener_ = std::move(listener);
+    }
+
     //receive state of the robot. record to data. use explicit pointer convertion
     int receive(std::vector<unsigned char> &data){
+      REMY_TRACE_ZONE("connection.receive");
       std::lock_guard<std::mutex>lock(mutex);
       data = data_;
+      return 0;
     };
+
+    /** It receives the last message with its stamp
+     * \param data the message
+     * \param stamp when it was sent
+     * \return its sequence number, 0 if nothing was sent yet
+     */
+    uint64_t receive(std::vector<unsigned char> &data, Clock::time_point& stamp){
+      REMY_TRACE_ZONE("connection.receive");
+      std::lock_guard<std::mutex>lock(mutex);
+      data = data_;
+      stamp = stamp_;
+      return sequence_;
+    }
+
+    /** \return the sequence number of the last message (0 if none) */
+    uint64_t sequence() {
+      std::lock_guard<std::mutex>lock(mutex);
+      return sequence_;
+    }
+
+    /** It blocks until the connection is opened
+     * \param timeout maximum wait
+     * \return false on timeout
+     */
+    template <class Rep, class Period>
+    bool waitOpened(const std::chrono::duration<Rep, Period>& timeout) {
+      std::unique_lock<std::mutex>lock(mutex);
+      return cv.wait_for(lock, timeout, [this] { return opened_.load(); });
+    }
+
+    /** It blocks until a message newer than the last one seen is sent, and
+     * it receives it
+     * \param last sequence number of the last message seen
+     * \param data the new message
+     * \param timeout maximum wait
+     * \return its sequence number, 0 on timeout or if the connection closed
+     */
+    template <class Rep, class Period>
+    uint64_t waitNewer(uint64_t last, std::vector<unsigned char> &data,
+        const std::chrono::duration<Rep, Period>& timeout) {
+      REMY_TRACE_ZONE("connection.wait");
+      std::unique_lock<std::mutex>lock(mutex);
+      if (!cv.wait_for(lock, timeout, [this, last] {
+            return sequence_ > last || !opened_; }) || sequence_ <= last)
+        return 0;
+      data = data_;
+      return sequence_;
+    }
 };
@@ -5,6 +5,12 @@
 #include <angle.h>
 #include <connection.h>
 #include <robot.h>
+#include <encoder_table.h>
+#include <workspace.h>
+#include <scheduler.h>
+#include <retiming.h>
+#include <rcu.h>
+#include <live_settings.h>
 
 // std
 #include <vector>
@@ -14,6 +20,9 @@
 #include <chrono>
 #include <thread>
 #include <atomic>
+#include <mutex>
+#include <future>
+#include <cstdint>
 
 // Eigen
 #include <Eigen/Geometry>
@@ -24,46 +33,144 @@ namespace remy_robot_control {
  * This class reads information about the required trajectory of the robot 
  * manipulator from a file .in. It sends control signals over the connection 
  * and receives feedback from the robot.
+ * It is templated on the scalar type of the model and control law; Control 
+ * (float) and Controld (double) are explicitly instantiated. The messages
+ * over the connection are float in both cases.
 */
-class Control {
-  std::unique_ptr<Trajectory> trajectory;
-  Robot model;
-  std::function<Eigen::Vector3f(Eigen::Vector3f, float)> control_;
-  Eigen::Vector3f control_signal;
+template <class T>
+class ControlT {
+  typedef remy_robot_control::Vector3<T> Vector3;
+  typedef remy_robot_control::Vector4<T> Vector4;
+
+  /** A published trajectory */
+  struct Path {
+    TrajectoryT<T> trajectory;
+    uint64_t version;
+    bool starts_on_read; ///< at the first tick which reads it, else at 0
+  };
+  Rcu<const Path> path;
+  uint64_t path_version; ///< the last one read by the control loop
+  T path_start; ///< of that one, in the time of the control loop
+  std::mutex load_mutex; ///< of the loads and of their results
+  std::vector<Vector4> input_waypoints;
+  RetimedPathT<T> retiming;
+  uint64_t versions;
+  std::shared_future<bool> loading;
+  RobotT<T> model;
+  RemyRobotSettings robot_settings;
+  std::shared_ptr<const LiveSettings> live_settings;
+  uint64_t settings_version; ///< of the last snapshot applied
+  std::function<Vector3(Vector3, T)> control_;
+  Vector3 control_signal;
   std::thread thread;
   std::atomic<bool> stop_;
   std::chrono::time_point<std::chrono::system_clock> clock;
   int sleep_ms;
+  std::shared_ptr<const EncoderTable> encoder_table;
+  std::shared_ptr<const EncoderTable> live_encoder_table; ///< of the snapshot
+  Eigen::Vector3f decoded_joints; ///< the last ones decoded
+  std::shared_ptr<const ReachabilityMap> reachability;
+  Vector3 q0dot;
+  T kp;
+  T damping_w0;
+  T damping_alpha0;
+  std::atomic<size_t> stale_count;
+  int horizon;
+  T horizon_dt;
+  std::vector<Eigen::Vector3f> setpoints;
+  std::vector<unsigned char> message; ///< the last control message sent
+  class LoopTask;
+  std::unique_ptr<LoopTask> task;
+  Scheduler* scheduler;
 
   public:
-    Control(const std::string& input);
-    ~Control();
+    ControlT(const std::string& input);
+
+    /** \param waypoints the trajectory (x, y, z, t), instead of a file */
+    explicit ControlT(std::vector<Vector4> waypoints);
+    ~ControlT();
 
     /** It sets the control settings
      * \param settings \sa RemyControlSettings
      */ 
     void setSettings(const RemyControlSettings& settings);
 
-    /** It changes the robot model settings by a given new one
+    /** It changes the robot model settings by a given new one. With a
+     * retiming_step, the waypoints are retimed to the fastest times within
+     * the joint limits (\sa retime).
      * \param settings new settings
      */
     void setRobotSettings(const RemyRobotSettings& settings);
 
+    /** It follows a live configuration: at the start of every step, if its
+     * version changed, the control settings and the robot settings of the
+     * model are applied from it, without allocating (\sa setSettings; the
+     * model keeps its joints, and its IK cache as it is, \sa 
+     * RobotT::updateSettings). The encoder table of the snapshot is used as
+     * soon as the plant sends ticks of its resolution. The current
+     * trajectory is kept, and the next loadAsync retimes with the new robot
+     * settings. It must be set before start.
+     * \param settings null to stop following it
+     */
+    void setLiveSettings(std::shared_ptr<const LiveSettings> settings);
+
     /** It creates a thread to control the arm. */
     void start(std::weak_ptr<Connection> con);
 
-    /** It stops the thread which controls the arm. */
+    /** It controls the arm from a task of the scheduler instead of a thread
+     * of its own: the same loop, as a state machine which yields instead of
+     * sleeping, and which the plant connection wakes up when it sends new
+     * joints (\sa Scheduler::wake).
+     * \param con connection of the plant
+     * \param scheduler it runs the loop, and it must outlive it
+     */
+    void start(std::weak_ptr<Connection> con, Scheduler& scheduler);
+
+    /** It stops the thread (or the task) which controls the arm. */
     void stop();
 
     /** It gets the waypoints of the current trajectory
      \return waypoints
     */
-    std::vector<Eigen::Vector4f> getWaypoints() const;
+    std::vector<Vector4> getWaypoints() const;
+
+    /** \return the retiming of the input waypoints, not solved when the
+     * input timestamps are kept (\sa RemyRobotSettings::retiming_step)
+    */
+    RetimedPathT<T> getRetiming();
+
+    /** It changes the path while the controller runs: a background thread
+     * reads the file, it validates the waypoints (finite, sorted in time,
+     * and reachable with a reachability map), it retimes them and it builds
+     * the trajectory, then it swaps it into the control loop (\sa Rcu). The
+     * loop never blocks nor allocates for it: it starts the new trajectory
+     * at the first tick which reads it, and the old one is freed once no
+     * tick reads it anymore. Loads run one at a time.
+     * \param input file path
+     * \return it becomes false if the waypoints are not valid (the
+     * trajectory is kept)
+    */
+    std::shared_future<bool> loadAsync(const std::string& input);
+
+    /** Same as above, with the waypoints instead of a file
+     * \param waypoints (x, y, z, t)
+    */
+    std::shared_future<bool> loadAsync(std::vector<Vector4> waypoints);
+
+    /** It sets the reachability map used to check the waypoints
+     * \param map \sa ReachabilityMap
+    */
+    void setReachabilityMap(std::shared_ptr<const ReachabilityMap> map);
+
+    /** It checks the waypoints against the reachability map, O(1) each
+     \return indices of the unreachable waypoints (empty without map)
+    */
+    std::vector<size_t> unreachableWaypoints() const;
 
     /** It gets the current control signal
      \return control_signal
     */
-    Eigen::Vector3f getControlSignal() const;
+    Vector3 getControlSignal() const;
 
     /** It sets the type of control. Default is Feedfoward */
     void setControlStrategy(ControlType type);
@@ -75,7 +182,38 @@ class Control {
      * \sa feedforwardControl
      * \sa analyticalControl
     */
-    void computeVelocityControl(const Eigen::Vector3f& joints, float t);
+    void computeVelocityControl(const Vector3& joints, T t);
+
+    /** One period of the controller, without I/O or sleeping: it decodes the
+     * joints message, computes the control signal and encodes it. The main
+     * thread calls it with the wall clock; simulations (\sa Fleet) call it 
+     * with the simulated time. \n
+     * With a horizon (\sa RemyControlSettings), the message holds the 
+     * setpoints for the next horizon_dt steps, computed by rolling the 
+     * control law over the model (\f$q_{k+1} = q_k + u_k\,dt\f$), and the
+     * plant interpolates them at its own rate (\sa horizonToUchar).
+     * \param joints the received joints message
+     * \param t current time (0 means start time)
+     * \return the control message
+    */
+    std::vector<unsigned char> step(const std::vector<unsigned char>& joints,
+      T t);
+
+    /** Same as above, into a buffer whose capacity is reused: once warmed
+     * up, a step does not allocate (the loops use it)
+     * \param joints the received joints message
+     * \param t current time (0 means start time)
+     * \param message output control message
+    */
+    void step(const std::vector<unsigned char>& joints, T t,
+      std::vector<unsigned char>& message);
+
+    /** \return the control period [s] */
+    T period() const;
+
+    /** \return number of periods skipped by the main thread because no new
+     * joints arrived within the period (the last command is kept) */
+    size_t getStaleCount() const;
 
     std::shared_ptr<Connection> connection;
 
@@ -85,10 +223,58 @@ class Control {
     */
     void readInput(const std::string& input);
 
+    /** It makes the trajectory of the input waypoints, retimed if set
+     * \param waypoints input waypoints (x, y, z, t)
+    */
+    void loadTrajectory(std::vector<Vector4> waypoints);
+
+    /** It builds a trajectory and it publishes it (\sa loadAsync)
+     * \param waypoints input waypoints (x, y, z, t)
+     * \param settings of the retiming
+     * \param map it checks the waypoints, if any
+     * \param checked it validates the waypoints
+     * \param starts_on_read \sa Path
+     * \return false if the waypoints are not valid
+    */
+    bool load(std::vector<Vector4> waypoints, const RemyRobotSettings& settings,
+      std::shared_ptr<const ReachabilityMap> map, bool checked, 
+      bool starts_on_read);
+
+    /** It runs a load on the background thread
+     * \param source it gives the waypoints
+    */
+    std::shared_future<bool> launch(std::function<std::vector<Vector4>()> 
+      source);
+
+    /** It applies the live settings if they changed (\sa setLiveSettings) */
+    void updateSettings();
+
+    /** It samples the published trajectory (\sa TrajectoryT::sample)
+     * \param t time of the control loop
+     * \param x desired position
+     * \param v desired velocity
+     * \return false after the last waypoint
+    */
+    bool desired(T t, Vector3& x, Vector3& v);
+
     /** This is the main thread of the controller. It periodically sends control 
      * signals to the robot.
     */
     void main(std::weak_ptr<Connection> con);
+
+    /** It computes the control message of the received joints at the wall
+     * clock and it sends it, with its inputs (one period of main, \sa
+     * appendControlInputs) */
+    void act(const std::vector<unsigned char>& joints);
+
+    /** It converts the received joints message to radians. The message is 
+     * either the float joints or the raw encoder ticks (\sa EncoderOutput), 
+     * the latter decoded with the shared EncoderTable of its resolution 
+     * (the one of the live settings, if it matches). A ticks message of an
+     * invalid resolution keeps the last joints.
+     * \param joints the received message
+    */
+    Eigen::Vector3f decodeJoints(const std::vector<unsigned char>& joints);
   
     /** The robot motion can be described by: \f$\dot{q} = u\f$, where \f$u\f$ 
      * is the velocity control signal (vector) applied to the motor drive of each joint. \n
@@ -106,22 +292,26 @@ class Control {
      * control fails. The solution is to introduce a term belonging to the 
      * nullsapce of \f$J\f$: \n
      * \f$u = J^{-1} * v + (I - J^{-1} * J) * q_0\f$, where \f$q_0\f$ is an 
-     * arbitrary joint velocities to avoid singularities.
+     * arbitrary joint velocities to avoid singularities. \n
+     * \f$\lambda\f$ (kp), \f$q_0\f$ (q0dot) and the damping of \f$J^{-1}\f$
+     * (damping_w0, damping_alpha0) are set by RemyControlSettings.
      * \param joints the current robot joints
      * \param t current time (0 means start time)
     */
-    Eigen::Vector3f feedforwardControl(const Eigen::Vector3f& joints, 
-      float t);
+    Vector3 feedforwardControl(const Vector3& joints, T t);
 
     /** The Analytical Control solution uses the analytical inverse kinematics
      * and it applies \f$u = \frac{dq}{dt} = (q_s - q) / dt\f$
      * \param joints the current robot joints
      * \param t current time (0 means start time)
     */
-    Eigen::Vector3f analyticalControl(const Eigen::Vector3f& joints, 
-      float t);
-
-    
+    Vector3 analyticalControl(const Vector3& joints, T t);
 };
 
+extern template class ControlT<float>;
+extern template class ControlT<double>;
+
+typedef ControlT<float> Control;
+typedef ControlT<double> Controld;
+
 } // end namespace remy_robot_control
\ No newline at end of file
@@ -0,0 +1,113 @@
+#pragma once
+
+// remy
+#include <types.h>
+
+// std
+#include <array>
+
+// Eigen
+#include <Eigen/Dense>
+
+namespace remy_robot_control {
+
+/** Rigid-body dynamics of the R-RR arm of RobotT (same DH chain), with
+ * \f$\tau = M(q)\ddot q + C(q, \dot q)\dot q + g(q) + F\dot q\f$.
+ * The recursive algorithms are specialized for the three revolute joints
+ * and work with fixed-size matrices on the stack, so no call allocates:
+ *  - inverse dynamics by recursive Newton-Euler (RNEA), in the base frame;
+ *  - mass matrix by the composite rigid body algorithm (CRBA);
+ *  - forward dynamics from both, with a 3x3 Cholesky solve.
+ *
+ * By default each link is a slender rod (radius 0.1) of the mass of
+ * RemyDynamicsSettings, centered between its joints; setLink sets any other
+ * inertia. The gravity is along \f$-z_0\f$.
+ * It is templated on the scalar type; Dynamics (float) and Dynamicsd (double)
+ * are explicitly instantiated.
+ */
+template <class T>
+class DynamicsT {
+  typedef remy_robot_control::Vector3<T> Vector3;
+  typedef Eigen::Matrix<T, 3, 3> Matrix3;
+
+  std::array<T, 3> a_; ///< DH link lengths
+  std::array<T, 3> alpha_; ///< DH twists
+  std::array<T, 3> mass_;
+  std::array<Vector3, 3> com_; ///< centers of mass, in the link frames
+  std::array<Matrix3, 3> inertia_; ///< about the centers, in the link frames
+  Vector3 friction_;
+  T gravity_;
+
+  /** The chain at q, in the base frame */
+  struct Frames {
+    std::array<Vector3, 4> p; ///< origins of the frames 0..3
+    std::array<Vector3, 3> z; ///< joint axes (z of the frames 0..2)
+    std::array<Vector3, 3> c; ///< centers of mass
+    std::array<Matrix3, 3> I; ///< inertias about the centers
+  };
+
+  public:
+    DynamicsT(const RemyDynamicsSettings& settings = RemyDynamicsSettings());
+
+    /** It sets the masses (as rods) and the friction of the settings
+     * \param settings \sa RemyDynamicsSettings
+     */
+    void setSettings(const RemyDynamicsSettings& settings);
+
+    /** It sets the inertial parameters of a link
+     * \param i link (0, 1 or 2)
+     * \param mass
+     * \param com center of mass, in the link frame
+     * \param inertia about the center of mass, in the link frame
+     */
+    void setLink(int i, T mass, const Vector3& com, const Matrix3& inertia);
+
+    /** Recursive Newton-Euler
+     * \param q joints
+     * \param qd joint velocities
+     * \param qdd joint accelerations
+     * \return the joint torques, with gravity and friction
+     */
+    Vector3 inverseDynamics(const Vector3& q, const Vector3& qd,
+      const Vector3& qdd) const;
+
+    /** Composite rigid body algorithm
+     * \param q joints
+     * \return the (symmetric, positive definite) mass matrix M(q)
+     */
+    Matrix3 massMatrix(const Vector3& q) const;
+
+    /** \return \f$C(q, \dot q)\dot q + g(q) + F\dot q\f$, by RNEA */
+    Vector3 bias(const Vector3& q, const Vector3& qd) const;
+
+    /** \return the gravity torques g(q) */
+    Vector3 gravity(const Vector3& q) const;
+
+    /** It solves \f$M(q)\ddot q = \tau - bias(q, \dot q)\f$
+     * \param q joints
+     * \param qd joint velocities
+     * \param tau joint torques
+     * \return the joint accelerations
+     */
+    Vector3 forwardDynamics(const Vector3& q, const Vector3& qd,
+      const Vector3& tau) const;
+
+    /** \return the potential energy at q (zero at the base) */
+    T potentialEnergy(const Vector3& q) const;
+
+    /** \return the kinetic energy \f$\frac{1}{2}\dot q^T M(q) \dot q\f$ */
+    T kineticEnergy(const Vector3& q, const Vector3& qd) const;
+
+  private:
+    void frames(const Vector3& q, Frames& f) const;
+
+    Vector3 rnea(const Frames& f, const Vector3& qd, const Vector3& qdd,
+      T gravity) const;
+
+    Matrix3 crba(const Frames& f) const;
+};
+
+typedef DynamicsT<float> Dynamics;
+typedef DynamicsT<double> Dynamicsd;
+
+} // end namespace remy_robot_control
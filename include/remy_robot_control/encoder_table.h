@@ -0,0 +1,79 @@
+#pragma once
+
+// remy
+#include <utils.h>
+
+// std
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <map>
+#include <algorithm>
+#include <iterator>
+
+// Eigen
+#include <Eigen/Geometry>
+
+namespace remy_robot_control {
+
+/** Lookup table from encoder ticks to joint angles \f$[-\pi, \pi]\f$ for a 
+ * given resolution. Decoding a tick is a single load instead of the float 
+ * math in encoderToJoint (which fills the table), and every consumer of the 
+ * same resolution gets bit-identical angles. Use sharedEncoderTable to get one.
+ */
+class EncoderTable {
+  int resolution_;
+  std::vector<float> angles_;
+
+  public:
+    /** \param encoder_resolution number of ticks per revolution */
+    explicit EncoderTable(int encoder_resolution) : 
+        resolution_(encoder_resolution) {
+      angles_.resize(resolution_ + 1);
+      for (int i = 0; i <= resolution_; ++i) {
+        angles_[i] = encoderToJoint<float>(i, resolution_);
+      }
+    }
+
+    int resolution() const {
+      return resolution_;
+    }
+
+    /** It decodes one tick count. Out of range ticks are saturated. */
+    float operator()(int tick) const {
+      return angles_[std::min(std::max(tick, 0), resolution_)];
+    }
+
+    /** It decodes the three joints */
+    Eigen::Vector3f operator()(const Eigen::Vector3i& ticks) const {
+      return {(*this)(ticks[0]), (*this)(ticks[1]), (*this)(ticks[2])};
+    }
+};
+
+/** It returns the table for a resolution, creating it on first use. Tables are
+ * shared by everyone (plants and controllers) asking for the same resolution,
+ * and they are freed with their last user: the cache only holds the tables
+ * in use. It locks and it may allocate, so the loops get their table before
+ * they run, or when the resolution on the wire changes.
+ * \param encoder_resolution number of ticks per revolution
+ * \return null if the resolution is not within (0, kEncoderResolutionMax]
+ */
+inline std::shared_ptr<const EncoderTable> sharedEncoderTable(
+    int encoder_resolution) {
+  if (encoder_resolution <= 0 || encoder_resolution > kEncoderResolutionMax)
+    return nullptr;
+  static std::mutex mutex;
+  static std::map<int, std::weak_ptr<const EncoderTable>> tables;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto table = tables[encoder_resolution].lock();
+  if (table)
+    return table;
+  for (auto it = tables.begin(); it != tables.end(); ) {
+    it = it->second.expired() ? tables.erase(it) : std::next(it);
+  }
+  table = std::make_shared<const EncoderTable>(encoder_resolution);
+  tables[encoder_resolution] = table;
+  return table;
+}
+
+} // end namespace remy_robot_control
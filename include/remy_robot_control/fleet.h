@@ -0,0 +1,92 @@
+#pragma once
+
+// remy
+#include <control.h>
+#include <robot_system.h>
+#include <simulation.h>
+#include <thread_pool.h>
+
+// std
+#include <vector>
+#include <memory>
+#include <string>
+
+// Eigen
+#include <Eigen/Geometry>
+
+namespace remy_robot_control {
+
+/** Outcome of Fleet::run */
+struct FleetReport {
+  size_t arms;
+  double simulated_seconds; ///< per arm
+  double wall_seconds;
+  size_t plant_steps; ///< over every arm
+  size_t control_steps; ///< over every arm
+
+  /** \return throughput in simulated arm-seconds per wall-second */
+  double armSecondsPerWallSecond() const {
+    return (wall_seconds > 0) ? arms * simulated_seconds / wall_seconds : 0;
+  }
+};
+
+/** The Fleet runs many controller/plant pairs (cells) on a fixed pool of
+ * workers instead of two sleeping threads per arm. The cells are simulated:
+ * there are no connections nor sleeps, the plant steps at its period and the
+ * controller at its own, both in simulated time, and the messages are passed
+ * directly (with the same encoding). Hence the result of a cell does not
+ * depend on the number of workers nor on the load of the machine.
+ */
+class Fleet {
+  struct Cell {
+    std::unique_ptr<Control> control;
+    std::unique_ptr<RobotSystem> system;
+    std::unique_ptr<LockStep> pair;
+    size_t plant_steps;
+  };
+
+  ThreadPool& pool;
+  std::vector<Cell> cells;
+
+  public:
+    /** \param workers pool running the cells */
+    explicit Fleet(ThreadPool& workers);
+
+    /** It adds a cell
+     * \param input path to the trajectory (.in)
+     * \param config path to the configuration (.json)
+     * \return the index of the cell
+     */
+    size_t add(const std::string& input, const std::string& config);
+
+    /** It adds a cell with the given settings (nothing is saved to disk,
+     * \sa offlineSettings)
+     * \param input path to the trajectory (.in)
+     * \param robot robot settings (both controller model and plant)
+     * \param control control settings
+     * \param system plant settings
+     * \return the index of the cell
+     */
+    size_t add(const std::string& input, const RemyRobotSettings& robot,
+      const RemyControlSettings& control, const RemySystemSettings& system);
+
+    /** Number of cells */
+    size_t size() const {
+      return cells.size();
+    }
+
+    /** It simulates every cell for a while (from where it stopped)
+     * \param seconds simulated time per cell
+     * \return the report of this run
+     */
+    FleetReport run(double seconds);
+
+    /** \return the joints of the plant of a cell */
+    Eigen::Vector3f getJoints(size_t cell);
+
+  private:
+    /** It simulates one cell for a while */
+    void runCell(Cell& cell, double seconds);
+};
+
+} // end namespace remy_robot_control
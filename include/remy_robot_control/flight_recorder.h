@@ -0,0 +1,172 @@
+#pragma once
+
+// remy
+#include <types.h>
+
+// std
+#include <vector>
+#include <string>
+#include <ostream>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+
+namespace remy_robot_control {
+
+/** One sample of the flight recorder (one plant step) */
+struct FlightRecord {
+  double t; ///< plant time [s]
+  float joints[3];
+  float velocities[3]; ///< applied joint velocities
+  float command[3]; ///< commanded joint velocities
+  float torques[3]; ///< joint torques (dynamic plant)
+  uint64_t sequence; ///< sequence number of the applied command (0: none)
+  float period_ms; ///< wall time of the plant iteration (0 in simulations)
+  float command_age_ms; ///< age of the applied command (0 in simulations)
+  double input_t; ///< controller time of the applied command (NaN: unknown)
+  float input_joints[3]; ///< the joints it was computed from
+  float control[3]; ///< its control signal (the first setpoint of a horizon)
+};
+
+/** Why the recorder was dumped */
+enum class DumpReason {
+  request, ///< API call
+  signal, ///< \sa FlightRecorder::installSignalHandler
+  stop, ///< the plant thread stopped
+  fault ///< non finite state or stale command
+};
+
+/** Always-on, in-memory recorder of the last samples of a run, in a ring
+ * preallocated at construction: recording a sample is a copy into the ring,
+ * with no allocation, lock or I/O, so it stays on when the csv log is off.
+ * The ring is written by a single thread (the plant). Dumps requested by
+ * other threads, by faults or by a signal are only flagged; the recording 
+ * thread copies the ring into a snapshot (preallocated as well) in 
+ * service(), and a writer thread of the recorder writes the snapshot to a
+ * file, oldest sample first. So the recording thread never does file I/O nor
+ * allocates. A dump flagged while the previous one is still being written 
+ * waits for the next service(). A fault dumps at most once per ring, so a
+ * lasting fault does not flood the disk. \n
+ * The binary format is a 20 bytes header (magic "RFLR", version, record
+ * size, number of records) followed by the raw FlightRecords; the csv one
+ * has a line per record.
+ */
+class FlightRecorder {
+  std::vector<FlightRecord> ring_;
+  uint64_t count_;
+  std::string prefix_;
+  RecorderFormat format_;
+  std::atomic<int> pending_; ///< 1 + DumpReason, 0 if none
+  uint32_t signals_seen_;
+  uint64_t fault_holdoff_; ///< faults before this count do not dump
+  std::atomic<size_t> files_; ///< file names given
+  std::atomic<size_t> dumps_;
+  std::string last_dump_;
+  std::mutex last_dump_mutex_;
+  // the snapshot of service(), owned by the writer while busy
+  std::vector<FlightRecord> snapshot_;
+  size_t snapshot_size_;
+  DumpReason snapshot_reason_;
+  std::atomic<bool> snapshot_busy_;
+  std::mutex mutex_; ///< of the writer
+  std::condition_variable cv_;
+  bool stop_;
+  std::thread writer_;
+
+  public:
+    /** \param capacity number of samples kept
+     * \param prefix of the dumped files: <prefix>_<n>_<reason>.<bin|csv>
+     * \param format of the dumped files
+     */
+    FlightRecorder(size_t capacity, const std::string& prefix =
+      "flight_recorder", RecorderFormat format = RecorderFormat::binary);
+
+    /** It writes the snapshot in progress, if any */
+    ~FlightRecorder();
+
+    FlightRecorder(const FlightRecorder&) = delete;
+    FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+    /** It records a sample, overwriting the oldest one if full */
+    void record(const FlightRecord& record) {
+      ring_[count_ % ring_.size()] = record;
+      ++count_;
+    }
+
+    /** \return number of samples kept */
+    size_t size() const;
+
+    size_t capacity() const;
+
+    /** \return number of samples recorded since the construction */
+    uint64_t recorded() const;
+
+    /** \return the i-th kept sample, from the oldest one */
+    const FlightRecord& operator[](size_t i) const;
+
+    /** It flags a dump, written by the next service() (any thread) */
+    void request(DumpReason reason = DumpReason::request);
+
+    /** It flags a fault dump, unless a fault was dumped within the ring */
+    void fault();
+
+    /** It snapshots the ring for the writer thread if a dump is flagged,
+     * or requested by a signal (recording thread, realtime safe)
+     * \return true if a dump started
+     */
+    bool service();
+
+    /** It waits for the writer thread to finish the dump in progress */
+    void flush();
+
+    /** It dumps now, to the next file, on the calling thread (recording
+     * thread, when it is idle)
+     * \param reason
+     * \return the file name, empty on failure
+     */
+    std::string dump(DumpReason reason);
+
+    /** It writes the kept samples, from the oldest one
+     * \param out the stream (binary mode for RecorderFormat::binary)
+     * \param format
+     * \return false on failure
+     */
+    bool write(std::ostream& out, RecorderFormat format) const;
+
+    /** \return number of files dumped */
+    size_t dumps() const;
+
+    /** \return the last dumped file, empty if none */
+    std::string lastDump();
+
+    /** It makes the signal request a dump of every recorder at its next
+     * service()
+     * \param signal e.g. SIGUSR1
+     */
+    static void installSignalHandler(int signal = SIGUSR1);
+
+  private:
+    /** The loop of the writer thread */
+    void writeSnapshots();
+
+    /** It writes samples to a new file
+     * \param reason
+     * \param first oldest samples
+     * \param n1 number of them
+     * \param second the next ones
+     * \param n2 number of them
+     * \return the file name, empty on failure
+     */
+    std::string dumpRecords(DumpReason reason, const FlightRecord* first,
+      size_t n1, const FlightRecord* second, size_t n2);
+
+    /** It writes samples, in the format of write() */
+    static bool writeRecords(std::ostream& out, RecorderFormat format, 
+      const FlightRecord* first, size_t n1, const FlightRecord* second,
+      size_t n2);
+};
+
+} // end namespace remy_robot_control
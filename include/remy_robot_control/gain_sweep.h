@@ -0,0 +1,77 @@
+#pragma once
+
+// remy
+#include <simulation.h>
+#include <thread_pool.h>
+
+// std
+#include <vector>
+#include <cstdint>
+
+namespace remy_robot_control {
+
+/** Range of a swept parameter */
+struct GainRange {
+  float min;
+  float max;
+};
+
+/** Search space of the feedforward control gains (\sa RemyControlSettings).
+ * The null-space velocity is swept as the same value for the three joints.
+ */
+struct GainSpace {
+  GainRange kp;
+  GainRange q0dot;
+  GainRange damping_w0;
+  GainRange damping_alpha0;
+  GainSpace() :
+    kp{0.5f, 10},
+    q0dot{0, 10},
+    damping_w0{0.0001f, 0.01f},
+    damping_alpha0{0.001f, 0.1f} {}
+};
+
+/** A swept configuration and its simulation */
+struct GainSweepEntry {
+  RemyControlSettings control;
+  SimulationResult result;
+  double score; ///< rms_error + effort_weight * effort
+  bool pareto; ///< no other entry has both less error and less effort
+};
+
+/** It makes a regular grid over the space (steps values per parameter)
+ * \param base settings of everything that is not swept
+ * \param space ranges of the gains
+ * \param steps values per parameter (1 means the middle of the range)
+ * \return steps^4 settings
+ */
+std::vector<RemyControlSettings> gainGrid(const RemyControlSettings& base,
+  const GainSpace& space, int steps);
+
+/** It draws uniform random settings over the space
+ * \param base settings of everything that is not swept
+ * \param space ranges of the gains
+ * \param n number of settings
+ * \param seed random seed (same seed, same settings)
+ * \return n settings
+ */
+std::vector<RemyControlSettings> randomGains(const RemyControlSettings& base,
+  const GainSpace& space, size_t n, uint32_t seed);
+
+/** It simulates every candidate (\sa simulate) on the pool and ranks them by
+ * score, from the best
+ * \param waypoints trajectory (x, y, z, t)
+ * \param simulation settings of the plant, robot and duration (its control
+ * settings are replaced by each candidate)
+ * \param candidates control settings to evaluate
+ * \param pool worker pool
+ * \param effort_weight weight of the control effort in the score
+ * \return the ranked entries
+ */
+std::vector<GainSweepEntry> sweepGains(
+  const std::vector<Vector4<float>>& waypoints,
+  const SimulationCase& simulation,
+  const std::vector<RemyControlSettings>& candidates, ThreadPool& pool,
+  double effort_weight = 0);
+
+} // end namespace remy_robot_control
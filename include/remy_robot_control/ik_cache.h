@@ -0,0 +1,163 @@
+#pragma once
+
+// remy
+#include <types.h>
+
+// std
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+// Eigen
+#include <Eigen/Geometry>
+
+namespace remy_robot_control {
+
+/** Result of an IkCache lookup */
+enum class IkCacheHit {
+  miss, ///< nothing cached near the target
+  warm, ///< a solution of a nearby target (same cell), to use as initial guess
+  exact ///< a solution of this very target
+};
+
+/** A bounded cache of inverse kinematics solutions, keyed on the target
+ * quantized to cells of a given resolution. Each cell keeps the last solved
+ * target and its joints: the same target is an exact hit and any other target
+ * in the cell gets those joints as a warm start. When full, entries are
+ * evicted with the CLOCK policy (second chance), so the memory is bounded by
+ * the capacity and a hit is a hash lookup plus setting a bit.
+ * It is not thread-safe (one cache per Robot).
+ */
+template <class T = float>
+class IkCacheT {
+  typedef remy_robot_control::Vector3<T> Vector3;
+
+  struct Entry {
+    uint64_t key;
+    Vector3 target;
+    Vector3 joints;
+    bool referenced;
+  };
+
+  T resolution_;
+  size_t capacity_;
+  std::vector<Entry> entries_;
+  std::unordered_map<uint64_t, size_t> index_;
+  size_t hand_;
+  size_t hits_;
+  size_t warm_hits_;
+  size_t misses_;
+
+  public:
+    /** \param resolution edge of the cells
+     * \param capacity maximum number of cached solutions
+     */
+    IkCacheT(T resolution, size_t capacity) :
+        resolution_(resolution), capacity_(std::max<size_t>(capacity, 1)),
+        hand_(0), hits_(0), warm_hits_(0), misses_(0) {
+      entries_.reserve(capacity_);
+      index_.reserve(capacity_);
+    }
+
+    /** It looks a target up
+     * \param x
+     * \param y
+     * \param z
+     * \param joints the cached joints, if any
+     * \return \sa IkCacheHit
+     */
+    IkCacheHit find(T x, T y, T z, Vector3& joints) {
+      auto it = index_.find(key(x, y, z));
+      if (it == index_.end()) {
+        ++misses_;
+        return IkCacheHit::miss;
+      }
+      Entry& entry = entries_[it->second];
+      entry.referenced = true;
+      joints = entry.joints;
+      if (entry.target == Vector3(x, y, z)) {
+        ++hits_;
+        return IkCacheHit::exact;
+      }
+      ++warm_hits_;
+      return IkCacheHit::warm;
+    }
+
+    /** It stores the solution of a target, replacing the one of its cell
+     * \param x
+     * \param y
+     * \param z
+     * \param joints
+     */
+    void insert(T x, T y, T z, const Vector3& joints) {
+      const uint64_t k = key(x, y, z);
+      auto it = index_.find(k);
+      if (it != index_.end()) {
+        entries_[it->second] = {k, {x, y, z}, joints, true};
+        return;
+      }
+      if (entries_.size() < capacity_) {
+        index_.emplace(k, entries_.size());
+        entries_.push_back({k, {x, y, z}, joints, false});
+        return;
+      }
+      // CLOCK: skip (and clear) referenced entries, evict the first other
+      while (entries_[hand_].referenced) {
+        entries_[hand_].referenced = false;
+        hand_ = (hand_ + 1) % capacity_;
+      }
+      index_.erase(entries_[hand_].key);
+      index_.emplace(k, hand_);
+      entries_[hand_] = {k, {x, y, z}, joints, false};
+      hand_ = (hand_ + 1) % capacity_;
+    }
+
+    /** It drops every entry and resets the counters */
+    void clear() {
+      entries_.clear();
+      index_.clear();
+      hand_ = hits_ = warm_hits_ = misses_ = 0;
+    }
+
+    T resolution() const {
+      return resolution_;
+    }
+
+    size_t capacity() const {
+      return capacity_;
+    }
+
+    /** Number of cached solutions */
+    size_t size() const {
+      return entries_.size();
+    }
+
+    /** Number of exact hits */
+    size_t hits() const {
+      return hits_;
+    }
+
+    /** Number of warm starts */
+    size_t warmHits() const {
+      return warm_hits_;
+    }
+
+    size_t misses() const {
+      return misses_;
+    }
+
+  private:
+    /** Cell coordinates packed in 21 bits each */
+    uint64_t key(T x, T y, T z) const {
+      const T inv = 1 / resolution_;
+      auto cell = [inv](T v) {
+        return (uint64_t) ((int64_t) std::floor(v * inv) & 0x1FFFFF);
+      };
+      return cell(x) | (cell(y) << 21) | (cell(z) << 42);
+    }
+};
+typedef IkCacheT<float> IkCache;
+
+} // end namespace remy_robot_control
@@ -0,0 +1,119 @@
+#pragma once
+
+// remy
+#include <types.h>
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace remy_robot_control {
+
+/** Fixed-step integrator of the joints, for the two plant models: first order
+ * (the joints follow a velocity field, \f$\dot q = v(t, q)\f$) and second order
+ * (\f$\ddot q = a(t, q, \dot q)\f$). A step longer than max_step is split into
+ * equal sub-steps, so the accuracy does not depend on the step the caller
+ * takes. The fields are functors called with the time relative to the
+ * beginning of the step. The semi-implicit method only differs from Euler on
+ * second order models.
+ */
+template <class T>
+class IntegratorT {
+  typedef remy_robot_control::Vector3<T> Vector3;
+
+  IntegratorType type_;
+  T max_step_;
+
+  public:
+    /** \param type \sa IntegratorType
+     * \param max_step internal step [s], longer steps are split (0: never)
+     */
+    explicit IntegratorT(IntegratorType type = IntegratorType::euler,
+        double max_step = 0) :
+      type_(type),
+      max_step_(static_cast<T>(max_step)) {}
+
+    IntegratorType type() const {
+      return type_;
+    }
+
+    /** \return number of sub-steps for a step of dt */
+    size_t substeps(T dt) const {
+      if (max_step_ <= 0 || dt <= max_step_)
+        return 1;
+      return static_cast<size_t>(std::ceil(dt / max_step_));
+    }
+
+    /** \return field evaluations per sub-step */
+    int evaluations() const {
+      return (type_ == IntegratorType::rk4) ? 4 : 1;
+    }
+
+    /** It integrates a first order model over dt
+     * \param v velocity field v(t, q)
+     * \param dt step [s]
+     * \param q joints, updated
+     */
+    template <class F>
+    void integrate(F&& v, T dt, Vector3& q) const {
+      const size_t n = substeps(dt);
+      const T h = dt / static_cast<T>(n);
+      for (size_t i = 0; i < n; ++i) {
+        const T t = static_cast<T>(i) * h;
+        if (type_ != IntegratorType::rk4) {
+          q += h * v(t, q);
+          continue;
+        }
+        Vector3 k1 = v(t, q);
+        Vector3 k2 = v(t + h / 2, Vector3(q + h / 2 * k1));
+        Vector3 k3 = v(t + h / 2, Vector3(q + h / 2 * k2));
+        Vector3 k4 = v(t + h, Vector3(q + h * k3));
+        q += h / 6 * (k1 + 2 * k2 + 2 * k3 + k4);
+      }
+    }
+
+    /** It integrates a second order model over dt
+     * \param a acceleration field a(t, q, qd)
+     * \param dt step [s]
+     * \param q joints, updated
+     * \param qd joint velocities, updated
+     */
+    template <class F>
+    void integrate(F&& a, T dt, Vector3& q, Vector3& qd) const {
+      const size_t n = substeps(dt);
+      const T h = dt / static_cast<T>(n);
+      for (size_t i = 0; i < n; ++i) {
+        const T t = static_cast<T>(i) * h;
+        switch (type_) {
+          case IntegratorType::euler: {
+            Vector3 acc = a(t, q, qd);
+            q += h * qd;
+            qd += h * acc;
+            break;
+          }
+          case IntegratorType::semi_implicit:
+            qd += h * a(t, q, qd);
+            q += h * qd;
+            break;
+          case IntegratorType::rk4: {
+            Vector3 k1q = qd;
+            Vector3 k1v = a(t, q, qd);
+            Vector3 k2q = qd + h / 2 * k1v;
+            Vector3 k2v = a(t + h / 2, Vector3(q + h / 2 * k1q), k2q);
+            Vector3 k3q = qd + h / 2 * k2v;
+            Vector3 k3v = a(t + h / 2, Vector3(q + h / 2 * k2q), k3q);
+            Vector3 k4q = qd + h * k3v;
+            Vector3 k4v = a(t + h, Vector3(q + h * k3q), k4q);
+            q += h / 6 * (k1q + 2 * k2q + 2 * k3q + k4q);
+            qd += h / 6 * (k1v + 2 * k2v + 2 * k3v + k4v);
+            break;
+          }
+        }
+      }
+    }
+};
+
+typedef IntegratorT<float> Integrator;
+
+} // end namespace remy_robot_control
@@ -0,0 +1,127 @@
+#pragma once
+
+// remy
+#include <angle.h>
+#include <types.h>
+
+// std
+#include <vector>
+#include <cstddef>
+
+// Eigen
+#include <Eigen/Geometry>
+
+namespace remy_robot_control {
+
+/** It wraps and clamps n contiguous angles (\sa wrapAndClamp). With float it
+ * uses the branchless wrapToPi and the loop vectorizes.
+ * \param q array of angles, modified inline
+ * \param n number of angles
+ * \param min lower limit
+ * \param max upper limit
+*/
+template <class T>
+inline void wrapAndClamp(T* q, size_t n, T min, T max) {
+  for (size_t i = 0; i < n; ++i) {
+    q[i] = wrapAndClamp(q[i], min, max);
+  }
+}
+
+/** A SoA container of N configurations of the 3 joints, where all of them
+ * share the same limits. Unlike RemyJoints (one Angle per joint, each one with
+ * its own limits), the joints are stored as three contiguous arrays, thus
+ * batch operations (wrap, clamp, integration) run as vectorized loops.
+ */
+template <class T = float>
+class JointBlock {
+  std::vector<T> q_[3];
+  T min_[3];
+  T max_[3];
+
+  public:
+    /** \param n number of configurations (all joints start at 0, clamped)
+     * \param min lower limits of the 3 joints
+     * \param max upper limits of the 3 joints
+    */
+    JointBlock(size_t n, const T min[3], const T max[3]) {
+      init(n, min, max);
+    }
+
+    /** \param n number of configurations
+     * \param settings robot settings with the joint limits
+    */
+    JointBlock(size_t n, const RemyRobotSettings& settings) {
+      init(n, settings.joints_min, settings.joints_max);
+    }
+
+    size_t size() const {
+      return q_[0].size();
+    }
+
+    /** It returns the contiguous array of a joint (0, 1 or 2) */
+    T* q(int joint) {
+      return q_[joint].data();
+    }
+
+    const T* q(int joint) const {
+      return q_[joint].data();
+    }
+
+    T min(int joint) const {
+      return min_[joint];
+    }
+
+    T max(int joint) const {
+      return max_[joint];
+    }
+
+    /** It gets the i-th configuration */
+    Eigen::Matrix<T, 3, 1> get(size_t i) const {
+      return {q_[0][i], q_[1][i], q_[2][i]};
+    }
+
+    /** It sets the i-th configuration (wrapped and clamped) */
+    void set(size_t i, const Eigen::Matrix<T, 3, 1>& q) {
+      for (int j = 0; j < 3; ++j) {
+        q_[j][i] = wrapAndClamp(q[j], min_[j], max_[j]);
+      }
+    }
+
+    /** It wraps and clamps all the configurations */
+    void normalize() {
+      for (int j = 0; j < 3; ++j) {
+        wrapAndClamp(q_[j].data(), size(), min_[j], max_[j]);
+      }
+    }
+
+    /** The batch version of Robot::update: \f$ q = q + u * dt \f$ for all the
+     * configurations, then wrap and clamp.
+     * \param u joint velocities, 3 arrays (one per joint) of size()
+     * \param dt the integration step
+    */
+    void update(const T* const u[3], T dt) {
+      const size_t n = size();
+      for (int j = 0; j < 3; ++j) {
+        T* q = q_[j].data();
+        const T* dq = u[j];
+        const T min = min_[j];
+        const T max = max_[j];
+        for (size_t i = 0; i < n; ++i) {
+          q[i] = wrapAndClamp(q[i] + dq[i] * dt, min, max);
+        }
+      }
+    }
+
+  private:
+    template <class S>
+    void init(size_t n, const S min[3], const S max[3]) {
+      for (int j = 0; j < 3; ++j) {
+        min_[j] = static_cast<T>(min[j]);
+        max_[j] = static_cast<T>(max[j]);
+        q_[j].assign(n, T{});
+      }
+      normalize();
+    }
+};
+
+} // end namespace remy_robot_control
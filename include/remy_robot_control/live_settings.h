@@ -0,0 +1,81 @@
+#pragma once
+
+// remy
+#include <types.h>
+#include <rcu.h>
+#include <encoder_table.h>
+
+// std
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+namespace remy_robot_control {
+
+/** A version of the whole configuration */
+struct SettingsSnapshot {
+  RemyRobotSettings robot;
+  RemyControlSettings control;
+  RemySystemSettings system;
+  uint64_t version; ///< 1 for the first one, then one more per publish
+  /** of system.encoder_resolution, built by the publisher so that the 
+   * loops never build it (null if the resolution is not valid) */
+  std::shared_ptr<const EncoderTable> encoder_table;
+};
+
+/** The configuration, replaced while the loops run. A loader (any thread but
+ * the loops) parses it and publishes a new snapshot; the loops (\sa
+ * ControlT::setLiveSettings, RobotSystem::setLiveSettings) compare its
+ * version at the start of each tick, and they only apply it when it
+ * changed. Reading is one Rcu read section: no lock, no allocation. What
+ * the loops cannot apply without allocating (the horizon beyond kHorizonMax,
+ * the geometry of the IK cache) needs setSettings.
+ */
+class LiveSettings {
+  Rcu<const SettingsSnapshot> snapshot_;
+  std::mutex writer_;
+  uint64_t version_;
+  /** of the previous snapshots, while a loop may hold them: a loop which
+   * moves on from one never frees it on its tick, a later publish does */
+  std::vector<std::shared_ptr<const EncoderTable>> retired_tables_;
+
+  public:
+    /** \param robot first robot settings
+     * \param control first control settings
+     * \param system first system settings
+     */
+    explicit LiveSettings(const RemyRobotSettings& robot = RemyRobotSettings(),
+      const RemyControlSettings& control = RemyControlSettings(),
+      const RemySystemSettings& system = RemySystemSettings());
+
+    /** It opens a read section of the current snapshot (realtime safe) */
+    Rcu<const SettingsSnapshot>::ReadGuard read() const {
+      return snapshot_.read();
+    }
+
+    /** \return version of the current snapshot */
+    uint64_t version() const;
+
+    /** It publishes a new snapshot, it waits for the ticks which still read
+     * the old one. It frees the encoder tables of the previous snapshots 
+     * that no loop holds anymore.
+     * \param robot new robot settings
+     * \param control new control settings
+     * \param system new system settings
+     * \return its version
+     */
+    uint64_t publish(const RemyRobotSettings& robot, 
+      const RemyControlSettings& control, const RemySystemSettings& system);
+
+    /** It parses a configuration file (\sa parseRobotSetting, 
+     * parseControlSetting, parseSystemSetting) and it publishes it
+     * \param path json file
+     * \return false if the file cannot be read, or if a setting is missing or
+     * not valid (the snapshot is kept)
+     */
+    bool load(const std::string& path);
+};
+
+} // end namespace remy_robot_control
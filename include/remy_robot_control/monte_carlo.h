@@ -0,0 +1,84 @@
+#pragma once
+
+// remy
+#include <simulation.h>
+#include <stats.h>
+#include <thread_pool.h>
+
+// std
+#include <vector>
+#include <ostream>
+#include <cstdint>
+
+namespace remy_robot_control {
+
+/** Perturbations of a Monte Carlo campaign. Each run draws, from its own seed,
+ * uniform values in the ranges and normal noises with the given std
+ * deviations.
+ */
+struct MonteCarloSettings {
+  size_t runs;
+  uint32_t seed; ///< seed of the campaign, run i uses seed + i
+  int encoder_resolution[2]; ///< [min, max]
+  int control_frequency[2]; ///< [min, max]
+  double jitter[2]; ///< [min, max] std deviation of the plant step times [s]
+  float initial_joints_sigma; ///< noise on the initial joints [rad]
+  float waypoint_sigma; ///< noise on the waypoints positions
+  size_t batch; ///< runs simulated (and kept) at once
+  MonteCarloSettings() :
+    runs(1000),
+    seed(0),
+    encoder_resolution{1024, 8192},
+    control_frequency{20, 50},
+    jitter{0, 0.0005},
+    initial_joints_sigma(0.05f),
+    waypoint_sigma(0.1f),
+    batch(256) {}
+};
+
+/** One run of a campaign, without its trajectory */
+struct MonteCarloRun {
+  size_t index;
+  SimulationCase simulation;
+  SimulationResult result;
+};
+
+/** Streaming summary of a campaign */
+struct MonteCarloSummary {
+  size_t runs;
+  size_t diverged; ///< runs with non finite error (not in the statistics)
+  size_t saturated; ///< runs with at least one saturation
+  StreamingStats rms_error;
+  StreamingStats max_error;
+  StreamingStats saturations;
+  MonteCarloSummary() : runs(0), diverged(0), saturated(0) {}
+};
+
+/** It draws the perturbed simulation and waypoints of run i
+ * \param waypoints nominal trajectory
+ * \param base nominal simulation
+ * \param settings perturbations
+ * \param i run index
+ * \param simulation perturbed simulation
+ * \param noisy_waypoints perturbed trajectory
+ */
+void drawMonteCarloRun(const std::vector<Vector4<float>>& waypoints,
+  const SimulationCase& base, const MonteCarloSettings& settings, size_t i,
+  SimulationCase& simulation, std::vector<Vector4<float>>& noisy_waypoints);
+
+/** It runs a seeded Monte Carlo campaign on the pool, by batches: the runs of
+ * a batch are simulated in parallel and then added in order to the summary
+ * (and written to out, if any), so the memory does not depend on the number
+ * of runs and the result does not depend on the number of workers.
+ * \param waypoints nominal trajectory
+ * \param base nominal simulation
+ * \param settings perturbations
+ * \param pool worker pool
+ * \param out optional CSV stream, one line per run
+ * \return the summary
+ */
+MonteCarloSummary runMonteCarlo(const std::vector<Vector4<float>>& waypoints,
+  const SimulationCase& base, const MonteCarloSettings& settings,
+  ThreadPool& pool, std::ostream* out = nullptr);
+
+} // end namespace remy_robot_control
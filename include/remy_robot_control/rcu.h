@@ -0,0 +1,122 @@
+#pragma once
+
+// std
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <cstdint>
+
+namespace remy_robot_control {
+
+/** Read-copy-update cell: a pointer to an immutable object, read by realtime
+ * loops and replaced by other threads. Reading never blocks nor allocates:
+ * a reader counts itself in (one atomic increment, on the counter of the
+ * parity of the epoch) and loads the pointer. A writer swaps the pointer,
+ * then it waits until no reader can still see the old object (it flips the
+ * epoch twice, and it waits for the readers of each parity to leave), and
+ * only then it deletes it. Writers run one at a time and they may block, so
+ * they belong to background threads. \n
+ * A read section must be short (one tick of a loop) and it must not publish.
+ */
+template <class T>
+class Rcu {
+  std::atomic<T*> current_;
+  std::atomic<uint64_t> epoch_;
+  mutable std::atomic<int64_t> readers_[2];
+  std::mutex writer_;
+
+  public:
+    /** A read section: the object stays alive while it exists */
+    class ReadGuard {
+      const Rcu* rcu_;
+      unsigned parity_;
+      T* object_;
+
+      public:
+        explicit ReadGuard(const Rcu& rcu) :
+          rcu_(&rcu),
+          parity_((unsigned) (rcu.epoch_.load() & 1))
+        {
+          // counted in before the load: a writer waiting for this parity
+          // cannot miss it
+          rcu.readers_[parity_].fetch_add(1);
+          object_ = rcu.current_.load();
+        }
+
+        ReadGuard(ReadGuard&& other) :
+          rcu_(other.rcu_),
+          parity_(other.parity_),
+          object_(other.object_)
+        {
+          other.rcu_ = nullptr;
+        }
+
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+        ReadGuard& operator=(ReadGuard&&) = delete;
+
+        ~ReadGuard() {
+          if (rcu_)
+            rcu_->readers_[parity_].fetch_sub(1, std::memory_order_release);
+        }
+
+        /** \return the object, nullptr if none was published */
+        T* get() const {
+          return object_;
+        }
+
+        T* operator->() const {
+          return object_;
+        }
+
+        T& operator*() const {
+          return *object_;
+        }
+    };
+
+    /** \param initial the first object (it may be null) */
+    explicit Rcu(std::unique_ptr<T> initial = nullptr) :
+      current_(initial.release()),
+      epoch_(0)
+    {
+      readers_[0] = 0;
+      readers_[1] = 0;
+    }
+
+    /** It deletes the current object: no read section may remain */
+    ~Rcu() {
+      delete current_.load();
+    }
+
+    Rcu(const Rcu&) = delete;
+    Rcu& operator=(const Rcu&) = delete;
+
+    /** It opens a read section (realtime safe) */
+    ReadGuard read() const {
+      return ReadGuard(*this);
+    }
+
+    /** It replaces the object, and it deletes the old one once no read
+     * section can still see it (it waits for them)
+     * \param next new object
+     */
+    void publish(std::unique_ptr<T> next) {
+      std::lock_guard<std::mutex> lock(writer_);
+      std::unique_ptr<T> old(current_.exchange(next.release()));
+      synchronize();
+    }
+
+  private:
+    /** It waits until every read section open before the call is closed */
+    void synchronize() {
+      for (int phase = 0; phase < 2; ++phase) {
+        const unsigned parity = (unsigned) (epoch_.fetch_add(1) & 1);
+        while (readers_[parity].load() != 0) {
+          std::this_thread::yield();
+        }
+      }
+    }
+};
+
+} // end namespace remy_robot_control
@@ -0,0 +1,110 @@
+#pragma once
+
+// remy
+#include <control.h>
+#include <flight_recorder.h>
+#include <stats.h>
+
+// std
+#include <vector>
+#include <string>
+#include <fstream>
+#include <ostream>
+#include <cstdint>
+
+namespace remy_robot_control {
+
+/** One sample of a recorded joint stream */
+struct ReplaySample {
+  double t; ///< plant time [s]
+  Eigen::Vector3f joints;
+  Eigen::Vector3f control; ///< recorded velocity command
+  uint64_t sequence; ///< of the command (0 if unknown)
+  double input_t; ///< controller time of the command (NaN if unknown)
+  Eigen::Vector3f input_joints; ///< the joints it was computed from
+};
+
+/** Formats of the recorded logs */
+enum class LogFormat {
+  unknown,
+  system_csv, ///< SystemLogger (out.csv)
+  recorder_csv, ///< FlightRecorder dump, csv
+  recorder_binary ///< FlightRecorder dump, binary
+};
+
+/** Streaming reader of a recorded log, whose format is detected from its
+ * first bytes. It reads one sample at a time (the binary dumps by chunks),
+ * so the memory does not depend on the size of the log.
+ */
+class LogReader {
+  std::ifstream file;
+  LogFormat format_;
+  std::string line;
+  uint64_t remaining; ///< records left in a binary dump
+  std::vector<FlightRecord> chunk;
+  size_t chunk_pos;
+
+  public:
+    /** \param path the log */
+    explicit LogReader(const std::string& path);
+
+    /** \return the detected format, unknown if the file is not a log */
+    LogFormat format() const;
+
+    /** It reads the next sample
+     * \param sample
+     * \return false at the end of the log (or on a malformed line)
+     */
+    bool next(ReplaySample& sample);
+};
+
+/** Which samples are fed to the controller */
+enum class ReplayMode {
+  every, ///< every sample, at its time, against its own command
+  on_change ///< the samples before a new command, against that command
+};
+
+struct ReplaySettings {
+  ReplayMode mode;
+  float tolerance; ///< max norm of a difference that is not a mismatch
+  int encoder_resolution; ///< quantization of the joints, as the controller saw them (0: none)
+  ReplaySettings() :
+    mode(ReplayMode::on_change),
+    tolerance(1e-3f),
+    encoder_resolution(0) {}
+};
+
+struct ReplayResult {
+  size_t samples; ///< read from the log
+  size_t replayed; ///< fed to the controller
+  size_t mismatches; ///< differences above the tolerance
+  double first_mismatch; ///< time of the first mismatch (NaN if none)
+  StreamingStats difference; ///< norm of the control differences
+  double wall_seconds;
+  ReplayResult();
+};
+
+/** It feeds a recorded joint stream to the control law, at the recorded
+ * times and as fast as possible, and it diffs the control signals against
+ * the recorded ones. A command recorded with the inputs of the controller
+ * (the flight recorder of a run, \sa appendControlInputs) is computed again
+ * from them: its controller time and the joints it decoded, so the run is
+ * reproduced exactly. Otherwise (out.csv, simulations) a plant log only 
+ * holds the commands it applied: with on_change, a new command is compared
+ * with the control computed from the previous sample, the last joints the
+ * plant published before it, which is exact in lock-step simulations
+ * only. \n
+ * The controller (trajectory, settings) must be the one of the recording, or
+ * the one under test.
+ * \param log the recorded stream
+ * \param control the controller
+ * \param settings \sa ReplaySettings
+ * \param out optional CSV stream, one line per replayed sample
+ * \return the statistics of the differences
+ */
+template <class T>
+ReplayResult replay(LogReader& log, ControlT<T>& control,
+  const ReplaySettings& settings = ReplaySettings(),
+  std::ostream* out = nullptr);
+
+} // end namespace remy_robot_control
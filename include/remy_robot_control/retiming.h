@@ -0,0 +1,65 @@
+#pragma once
+
+// remy
+#include <types.h>
+#include <robot.h>
+
+// std
+#include <vector>
+
+namespace remy_robot_control {
+
+/** A path retimed by retime() */
+template <class T>
+struct RetimedPathT {
+  std::vector<Vector4<T>> waypoints; ///< samples of the path at their times
+  T duration; ///< fastest cycle time [s]
+  T input_duration; ///< of the input timestamps [s]
+  /** largest joint speed demanded by the input timestamps, relative to its
+   * limit (above 1 the input is too fast for the arm) */
+  T input_velocity_ratio;
+  bool solved; ///< false if retiming is off or a sample has no IK solution
+  RetimedPathT() :
+    duration(0),
+    input_duration(0),
+    input_velocity_ratio(0),
+    solved(false) {}
+};
+
+typedef RetimedPathT<float> RetimedPath;
+typedef RetimedPathT<double> RetimedPathd;
+
+/** Time-optimal retiming of a Cartesian path under joint velocity and
+ * acceleration limits (\sa RemyRobotSettings). The piecewise-linear path of
+ * the waypoints (their timestamps are ignored) is sampled every
+ * retiming_step of length and mapped to joint space with the inverse
+ * kinematics of the robot; the joint derivatives along the path,
+ * \f$q'(s)\f$ and \f$q''(s)\f$, are the finite differences of the samples
+ * (they stay finite at the boundary of the workspace, where the Jacobian is
+ * singular). The limits \f$|q' \dot s| \le \dot q_{max}\f$ and
+ * \f$|q' \ddot s + q'' \dot s^2| \le \ddot q_{max}\f$ bound the path speed
+ * \f$\dot s\f$, and its fastest profile is the classic one of the
+ * numerical integration methods: a backward pass of maximum deceleration
+ * from the end, then a forward pass of maximum acceleration from the start,
+ * on the grid of \f$\dot s^2\f$ (constant \f$\ddot s\f$ between samples). The
+ * arm starts and ends at rest, and it stops at the corners of the path,
+ * where its Cartesian direction jumps. \n
+ * Trajectory interpolates the samples linearly, at the mean speed of each
+ * interval.
+ * \param waypoints the path (x, y, z, t)
+ * \param robot its inverse kinematics (and reach policy) map the path
+ * \param settings limits and retiming_step, all of them positive
+ * \return the samples at their times (\sa RetimedPathT::solved)
+ */
+template <class T>
+RetimedPathT<T> retime(const std::vector<Vector4<T>>& waypoints,
+  RobotT<T>& robot, const RemyRobotSettings& settings);
+
+extern template RetimedPathT<float> retime(
+  const std::vector<Vector4<float>>&, RobotT<float>&,
+  const RemyRobotSettings&);
+extern template RetimedPathT<double> retime(
+  const std::vector<Vector4<double>>&, RobotT<double>&,
+  const RemyRobotSettings&);
+
+} // end namespace remy_robot_control
@@ -3,11 +3,15 @@
 // remy
 #include <types.h>
 #include <angle.h>
+#include <workspace.h>
+#include <ik_cache.h>
 
 // std
 #include <vector>
 #include <functional>
 #include <memory>
+#include <array>
+#include <atomic>
 
 // Eigen
 #include <Eigen/Geometry>
@@ -42,36 +46,144 @@ namespace remy_robot_control {
  * |   3   |  -pi  |   pi  |
  * +-------+-------+-------+
  * \endrst
+ *
+ * It is templated on the scalar type; Robot (float) and Robotd (double) are 
+ * explicitly instantiated.
  */
-class Robot {
-  
-  std::function<Eigen::Vector3f(const Eigen::Vector3f& joints)> fk_;
-  std::function<Eigen::Vector3f(float, float, float)> ik_;
-  std::unique_ptr<RemyJoints> joints_;
+template <class T>
+class RobotT {
+  typedef remy_robot_control::Vector3<T> Vector3;
+
+  std::function<Vector3(const Vector3& joints)> fk_;
+  std::function<Vector3(T, T, T, const Vector3& q0)> ik_;
+  std::unique_ptr<RemyJointsT<T>> joints_;
+  ReachPolicy reach_policy_;
+  T reach_min_;
+  T reach_max_;
+  std::shared_ptr<const ReachabilityMap> reachability_;
+  std::shared_ptr<ThreadPool> pool_;
+  size_t random_seeds_;
+  std::shared_ptr<IkCacheT<T>> ik_cache_;
 
   public:
-    Robot();
-    Robot(float q1, float q2, float q3);
-    ~Robot() = default;
+    RobotT();
+    RobotT(T q1, T q2, T q3);
+    ~RobotT() = default;
 
-    /** It sets the robot settings
+    /** It sets the robot settings. The joints keep their values (clamped
+     * to the new limits), and the IK cache is only made again if its 
+     * resolution or capacity changed (else it is cleared).
      * \param settings \sa RemyRobotSettings
      */ 
     void setSettings(const RemyRobotSettings& settings);
 
+    /** Same as setSettings, without allocating, for the loops (\sa 
+     * LiveSettings): the IK cache keeps its resolution and capacity (it is
+     * only cleared), and only setSettings changes them.
+     * \param settings \sa RemyRobotSettings
+     */ 
+    void updateSettings(const RemyRobotSettings& settings);
+
     /**  It returns the foward kinematics for the R-RR robot. 
       * \param joints the current values for robot joints
       * \return the end-effector position (not pose)
     */
-    Eigen::Vector3f forwardKinematics(const Eigen::Vector3f& joints);
+    Vector3 forwardKinematics(const Vector3& joints);
     
     /**  It returns the inverse kinematics for the R-RR (elbow) robot. 
+      * Before running the solver, the target is checked in O(1) against the
+      * reach of the arm (\sa isReachable), and the ReachPolicy decides what
+      * to do with targets out of reach, so the iterative solvers never burn
+      * their whole budget on infeasible targets.
       * \param x
       * \param y
       * \param z
-      * \return the end-effector position (not pose)
+      * \return the end-effector position (not pose), NaN if rejected
+    */
+    Vector3 inverseKinematics(T x, T y, T z);
+
+    /** Constant time reach test. Links 2 and 3 span a spherical shell around
+     * the shoulder (the point at 10 from the base, in the direction of the 
+     * target): \f$d_{min} \leq d \leq d_{max}\f$, with 
+     * \f$d = \sqrt{50 + 50 \cos\theta_3}\f$ over the limits of 
+     * \f$\theta_3\f$. Then one of the two elbow solutions has to be within
+     * the limits of every joint (\sa withinLimits). If a ReachabilityMap is
+     * set, it is checked too.
+     * \param x
+     * \param y
+     * \param z
+     * \return true if (x, y, z) passes the tests
+    */
+    bool isReachable(T x, T y, T z);
+
+    /** Constant time joint limits test: one of the two elbow solutions of
+     * (x, y, z), \f$\theta_1 = atan2(y, x)\f$, 
+     * \f$\theta_3 = \pm acos((d^2 - 50) / 50)\f$ and 
+     * \f$\theta_2 = atan2(z, \rho - 10) - \theta_3 / 2\f$, is within 
+     * [qmin, qmax], up to 1e-4 of displacement of the end-effector (so the
+     * folded arm, where \f$\theta_2\f$ is undetermined, passes). The
+     * distance to the shoulder is clamped to the shell, so it does not test
+     * the reach itself.
+     * \param x
+     * \param y
+     * \param z
+     * \param qmin lower limits of the joints
+     * \param qmax upper limits of the joints
+     * \return true if a solution is within the limits
+    */
+    static bool withinLimits(T x, T y, T z, const Vector3& qmin, 
+      const Vector3& qmax);
+
+    /** \return inner radius of the shell of isReachable */
+    T reachMin() const {
+      return reach_min_;
+    }
+
+    /** \return outer radius of the shell of isReachable */
+    T reachMax() const {
+      return reach_max_;
+    }
+
+    /** It projects a target to the nearest point of the shell of 
+     * isReachable (radially from the shoulder), in constant time.
+     * \param p target
+     * \return p itself if it is within the shell
+    */
+    Vector3 projectToReach(const Vector3& p);
+
+    /** It sets the policy for targets out of reach (default is project)
+     * \param policy \sa ReachPolicy
+    */
+    void setReachPolicy(ReachPolicy policy);
+
+    /** It sets the workers of the multistart inverse kinematics. The pool
+     * must not be the one running the calls to inverseKinematics (the caller
+     * waits for the seeds).
+     * \param pool nullptr to solve the seeds sequentially
+    */
+    void setThreadPool(std::shared_ptr<ThreadPool> pool);
+
+    /** It sets the number of random seeds of the multistart inverse 
+     * kinematics (default is 4)
+     * \param seeds
+    */
+    void setMultiStartSeeds(size_t seeds);
+
+    /** It sets a cache of solutions for inverseKinematics: exact hits are
+     * returned without solving and near hits (same cell) are the initial 
+     * guess of the iterative solvers. Only solutions within the IK error are
+     * cached.
+     * \param cache nullptr to disable it (\sa IkCacheT)
     */
-    Eigen::Vector3f inverseKinematics(float x, float y, float z);
+    void setIkCache(std::shared_ptr<IkCacheT<T>> cache);
+
+    /** \return the IK cache (for its counters), nullptr if disabled */
+    std::shared_ptr<IkCacheT<T>> getIkCache() const;
+
+    /** It sets a precomputed map (\sa ReachabilityMap) for the reach test
+     * \param map nullptr to only use the analytical shell
+    */
+    void setReachabilityMap(std::shared_ptr<const ReachabilityMap> map);
 
     /**  It changes the foward kinematics method 
       * \param type \sa FKType
@@ -87,22 +199,36 @@ class Robot {
      * here)
      * \return robot's joints
     */
-    Eigen::Vector3f getJoints();
+    Vector3 getJoints();
+
+    /** It sets the robot joints (wrapped and clamped to the limits)
+     * \param joints
+    */
+    void setJoints(const Vector3& joints);
 
     /** It is the system model \f$ \dot{q}=u \f$, thus \f$ q=u*dt \f$. It 
      * integrates the input control.
      * \param u the input control
      * \param dt the integration step
     */
-    void update(const Eigen::Vector3f& u, float dt);
+    void update(const Vector3& u, T dt);
   
   private: 
 
+    /** It computes the radii of the reach shell from the limits of 
+     * \f$\theta_3\f$ (\sa isReachable)
+    */
+    void setReach();
+
+    /** It runs the inverse kinematics through the cache, if set 
+     * \param xs reachable target
+    */
+    Vector3 solveIK(const Vector3& xs);
 
     /** The position was analytically calculated and the result was pasted here
      * \param joints the current values for robot joints
     */
-    Eigen::Vector3f fastForwardKinematics(const Eigen::Vector3f& joints);
+    Vector3 fastForwardKinematics(const Vector3& joints);
 
     /** The forward kinematics is computed by the multiplication of the 
      * homogeneous transformations \f$ T_0*T_1*T_2*T_3 \f$, which can be formed 
@@ -120,7 +246,7 @@ class Robot {
      * \endrst
      * \param joints the current values for robot joints
     */
-    Eigen::Vector3f forwardKinematicsGeneric(const Eigen::Vector3f& joints);
+    Vector3 forwardKinematicsGeneric(const Vector3& joints);
 
     /** It uses the Jacobian to iteratively compute the inverse kinematics. The
      * algorithm' steps are: 1) \f$ e = x_g - x \f$, 2) compute \f$ J(q) \f$,
@@ -133,8 +259,8 @@ class Robot {
      * \return the joints to reach (x, y, z)
     */
    // TODO: this should be robot config
-    Eigen::Vector3f jacobTransposeIK(float x, float y, float z, 
-      const Eigen::Vector3f& q0 = {0, 0, 0}, float error = 1e-3);
+    Vector3 jacobTransposeIK(T x, T y, T z, 
+      const Vector3& q0 = {0, 0, 0}, T error = static_cast<T>(1e-3));
 
     /** It uses the Damped least squares method to iteratively compute the 
      * inverse kinematics. The algorithm' steps are: 1) \f$ e = x_g - x \f$, 
@@ -147,8 +273,39 @@ class Robot {
      * \param error the desired error
      * \return the joints to reach (x, y, z)
     */
-    Eigen::Vector3f dampedIK(float x, float y, float z, 
-      const Eigen::Vector3f& q0 = {0, 0, 0}, float error = 1e-3);
+    Vector3 dampedIK(T x, T y, T z, 
+      const Vector3& q0 = {0, 0, 0}, T error = static_cast<T>(1e-3));
+
+    /** It runs the damped least squares from several seeds: both analytical
+     * branches and the current joints (clamped to the joint limits) and 
+     * random joints within the limits. If a seed already meets the error, it 
+     * is returned without iterating. Otherwise the seeds are solved on the 
+     * pool (\sa setThreadPool), the first one to meet the error is returned 
+     * and the others are cancelled.
+     * \param x 
+     * \param y
+     * \param z 
+     * \param q0 initial guess, an extra seed
+     * \param error the desired error
+     * \return the joints to reach (x, y, z), or the seed with the smallest
+     * error if none converged
+    */
+    Vector3 multiStartIK(T x, T y, T z, const Vector3& q0 = {0, 0, 0}, 
+      T error = static_cast<T>(1e-3));
+
+    /** Damped least squares from q that respects the limits of each joint 
+     * and does not touch the robot state, so seeds can run concurrently.
+     * \param xs target
+     * \param q seed, the solution at return
+     * \param error the desired error
+     * \param cancel it stops when set by another seed
+     * \return the final error
+    */
+    T dampedIKSeed(const Vector3& xs, Vector3& q, T error,
+      const std::atomic<bool>& cancel);
+
+    /** \return joints wrapped and clamped to the joint limits */
+    Vector3 clampToLimits(const Vector3& joints) const;
 
     /** It computes the analytical solution for inverse kinematics, for this 
      * specific case by algebric manipulation of the translation vector, and using 
@@ -159,14 +316,39 @@ class Robot {
      * \param z 
      * \return the joints to reach (x, y, z)
     */
-    Eigen::Vector3f analyticalIK(float x, float y, float z);
+    Vector3 analyticalIK(T x, T y, T z);
 
   public:
+    /** It computes, in closed form, both elbow branches of the inverse 
+     * kinematics. In the plane of the arm (\f$\rho = \sqrt{x^2 + y^2}\f$, z)
+     * links 2 and 3 form a planar 2R arm with its base at (10, 0), thus 
+     * \f$\theta_1 = atan2(y, x)\f$, \f$\cos\theta_3 = (d^2 - 50) / 50\f$ and
+     * \f$\theta_2 = atan2(z, \rho - 10) - atan2(5 s_3, 5 + 5 c_3)\f$.
+     * \param x
+     * \param y
+     * \param z
+     * \return the two solutions (\f$\theta_3 \geq 0\f$ first), NaN if 
+     * (x, y, z) is out of reach. The joint limits are not applied.
+    */
+    std::array<Vector3, 2> analyticalIKBranches(T x, T y, T z);
+
+    /** It checks the joints against the robot joint limits
+     * \param joints
+     * \return true if every joint is within its [min, max]
+    */
+    bool withinLimits(const Vector3& joints) const;
+
     /** It calculates the Jacobian (\f$\frac{dP}{d\theta}\f$ only translation) 
     * \param joints the current values for robot joints
     * \return the jacobian as an eigen matrix (3x3)
     */
-    JacobMP jacob(const Eigen::Vector3f& joints);
+    JacobMPT<T> jacob(const Vector3& joints);
 };
 
+extern template class RobotT<float>;
+extern template class RobotT<double>;
+
+typedef RobotT<float> Robot;
+typedef RobotT<double> Robotd;
+
 } // end namespace remy_robot_cotrol
\ No newline at end of file
@@ -4,12 +4,26 @@
 #include <robot.h>
 #include <connection.h>
 #include <system_logger.h>
+#include <broadcast.h>
+#include <integrator.h>
+#include <dynamics.h>
+#include <flight_recorder.h>
+#include <scheduler.h>
+#include <live_settings.h>
 
 // std
 #include <thread>
 #include <atomic>
 
 namespace remy_robot_control {
+
+/** State of the plant, broadcast at every step */
+struct RobotState {
+  double t; ///< elapsed time [s]
+  float joints[3];
+  float control[3]; ///< applied velocities
+};
+typedef BroadcastChannel<RobotState> StateChannel;
   
 class RobotSystem {
   Robot robot;
@@ -19,7 +33,38 @@ class RobotSystem {
   std::chrono::time_point<std::chrono::system_clock> clock;
   int sleep_ms;
   int encoder_resolution;
+  EncoderOutput encoder_output;
   std::unique_ptr<SystemLogger> logger;
+  double elapsed_time;
+  int command_timeout_ms;
+  std::vector<Eigen::Vector3f> setpoints;
+  float setpoints_dt;
+  double setpoints_start;
+  double clock_offset; ///< elapsed time minus controller time, at best
+  float last_t0; ///< controller time of the last horizon
+  Integrator integrator;
+  float actuator_tau;
+  Eigen::Vector3f joint_velocities;
+  PlantModel plant;
+  Dynamics dynamics;
+  Eigen::Vector3f velocity_gain;
+  Eigen::Vector3f torque_max;
+  Eigen::Vector3f joint_torques;
+  size_t torque_saturations;
+  uint64_t command_sequence;
+  float period_ms;
+  float command_age_ms;
+  double input_t; ///< controller time of the last command (NaN: unknown)
+  Eigen::Vector3f input_joints; ///< the joints it was computed from
+  Eigen::Vector3f input_control; ///< its control signal
+  std::atomic<size_t> stale_commands;
+  class LoopTask;
+  std::unique_ptr<LoopTask> task;
+  Scheduler* scheduler;
+  std::shared_ptr<const LiveSettings> live_settings;
+  uint64_t settings_version; ///< of the last snapshot applied
+  std::vector<unsigned char> joints_message; ///< the last one sent
+  std::vector<unsigned char> control_message; ///< the last one received
   
   public:
     RobotSystem();
@@ -35,19 +80,124 @@ class RobotSystem {
      */
     void setRobotSettings(const RemyRobotSettings& settings);
 
+    /** It follows a live configuration: at the start of every step, if its
+     * version changed, the system settings and the robot settings are
+     * applied from it (\sa setSettings, without allocating: the flight
+     * recorder is kept as it is until the next setSettings, and the robot
+     * keeps its joints and its IK cache, \sa RobotT::updateSettings). It
+     * must be set before start.
+     * \param settings null to stop following it
+     */
+    void setLiveSettings(std::shared_ptr<const LiveSettings> settings);
+
     /** It creates a thread to start the robotic system. */
     void start(std::weak_ptr<Connection> con);
 
-    /** It stops the main thread which exchange information with the controller. */
+    /** It runs the plant from a task of the scheduler instead of a thread of
+     * its own: the same loop, as a state machine which yields instead of
+     * sleeping, at a fixed rate.
+     * \param con connection of the controller
+     * \param scheduler it runs the loop, and it must outlive it
+     */
+    void start(std::weak_ptr<Connection> con, Scheduler& scheduler);
+
+    /** It stops the main thread (or the task) which exchange information with the controller. */
     void stop();
 
+    /** One period of the plant, without I/O or sleeping: it integrates the
+     * last control signal over dt (\sa IntegratorT, with the integrator of 
+     * RemySystemSettings) through the plant model (\sa PlantModel), logs
+     * (if save_run), publishes the state
+     * and encodes the joints
+     * (\sa EncoderOutput). The main thread calls it with the wall clock; 
+     * simulations (\sa Fleet) call it with the simulated period.
+     * \param dt elapsed time [s]
+     * \return the joints message
+     */
+    std::vector<unsigned char> step(double dt);
+
+    /** Same as above, into a buffer whose capacity is reused: once warmed
+     * up, a step does not allocate (the loops use it)
+     * \param dt elapsed time [s]
+     * \param message output joints message
+     */
+    void step(double dt, std::vector<unsigned char>& message);
+
+    /** It sets the control signal applied by the next steps. A horizon of
+     * setpoints (\sa horizonToUchar) is interpolated linearly by the next 
+     * steps, from its start time t0 on, and the last setpoint is held after
+     * the horizon. t0 is on the clock of the controller: it is mapped to the
+     * elapsed time by the smallest offset seen so far (the horizon with the
+     * least latency), so the setpoints already due when a delayed horizon
+     * arrives are skipped. The offset is estimated again when t0 goes 
+     * backwards (a new controller) or the elapsed time restarts. The inputs
+     * of the controller, if the message has them (\sa appendControlInputs),
+     * are recorded with the command.
+     * \param control the received control message
+     */
+    void setControl(const std::vector<unsigned char>& control);
+
+    /** \return number of steps whose command was older than the command
+     * timeout (\sa RemySystemSettings), which were run with zero velocity */
+    size_t getStaleCount() const;
+
+    /** \return the plant period [s] */
+    double period() const;
+
+    /** \return the current joint velocities */
+    Eigen::Vector3f getJointVelocities() const;
+
+    /** \return the last joint torques (dynamic plant) */
+    Eigen::Vector3f getJointTorques() const;
+
+    /** \return number of steps that ended with a torque at its limit 
+     * (dynamic plant) */
+    size_t getTorqueSaturations() const;
+
+    /** \return the current joints */
+    Eigen::Vector3f getJoints();
+
+    /** It sets the joints of the plant (e.g. the initial ones)
+     * \param joints
+     */
+    void setJoints(const Eigen::Vector3f& joints);
+
     
     std::shared_ptr<Connection> connection;
+    /** Every step publishes its RobotState here, for any number of readers
+     * (loggers, monitors, supervisors), without locking the plant */
+    std::shared_ptr<StateChannel> state;
+    /** Every step is recorded here (null if off, \sa RemySystemSettings). 
+     * It is dumped when the thread stops, on faults (non finite joints,
+     * command timeouts), on a signal (\sa FlightRecorder::installSignalHandler)
+     * and on request() */
+    std::shared_ptr<FlightRecorder> recorder;
     bool save_run;
   
   private:
+    /** The settings of setSettings but the flight recorder
+     * \param settings \sa RemySystemSettings
+     */
+    void applySettings(const RemySystemSettings& settings);
+
+    /** It applies the live settings if they changed (\sa setLiveSettings) */
+    void updateSettings();
+
+    /** It restarts the elapsed time at the wall clock now */
+    void resetClock();
+
+    /** \return the velocity command at the elapsed time t */
+    Eigen::Vector3f command(double t) const;
+
     /** The main thread sends encoder's outputs and it gets control signals */
     void main(std::weak_ptr<Connection> con);
+
+    /** One period of main: it steps the plant at the wall clock, it sends
+     * the joints and it applies a new command, if any
+     * \param conn connection of the controller
+     * \param last_sequence sequence number of the last applied command
+     */
+    void tick(Connection& conn, uint64_t& last_sequence);
 };
 
 } // end namespace remy_robot_cotrol
\ No newline at end of file
@@ -0,0 +1,118 @@
+#pragma once
+
+// std
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace remy_robot_control {
+
+/** A cooperative task of a Scheduler: a stackless state machine. resume()
+ * runs it until it would block (sleep, wait for a message) and it returns
+ * when it wants to run again, instead of blocking its thread.
+ */
+class ScheduledTask {
+  public:
+    typedef std::chrono::steady_clock Clock;
+
+    virtual ~ScheduledTask() {}
+
+    /** It runs the task until it yields
+     * \param now current time
+     * \return when it resumes next, finished() if it is done
+     */
+    virtual Clock::time_point resume(Clock::time_point now) = 0;
+
+    /** \return the time point of a finished task */
+    static Clock::time_point finished() {
+      return Clock::time_point::max();
+    }
+};
+
+/** Time-ordered scheduler of cooperative tasks on a single thread: the task
+ * due first runs until it yields, and the thread sleeps until the next one is
+ * due. Many controller/plant loops (\sa ControlT::start, RobotSystem::start)
+ * share one thread this way, without context switches between them nor
+ * contention on their connections. Tasks at the same time run in the order
+ * they were scheduled.
+ */
+class Scheduler {
+  struct Entry {
+    ScheduledTask::Clock::time_point wake;
+    uint64_t order;
+    ScheduledTask* task;
+  };
+
+  std::vector<Entry> queue; ///< min-heap on (wake, order)
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::thread thread;
+  std::thread::id thread_id;
+  ScheduledTask* running_;
+  bool running_removed_; ///< the running task removed itself
+  bool running_woken_; ///< the running task was woken up
+  uint64_t order_;
+  bool stop_;
+  std::atomic<uint64_t> resumes_;
+
+  public:
+    Scheduler();
+
+    /** It stops the thread, the tasks stay scheduled */
+    ~Scheduler();
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    /** It runs the tasks on a new thread */
+    void start();
+
+    /** It stops the thread after the running task yields */
+    void stop();
+
+    /** It runs the tasks on the calling thread until a deadline
+     * \param deadline
+     * \return number of resumed tasks
+     */
+    size_t runUntil(ScheduledTask::Clock::time_point deadline);
+
+    /** It schedules a task (thread-safe)
+     * \param task it must outlive its scheduling (\sa remove)
+     * \param when first time it runs
+     */
+    void add(ScheduledTask* task,
+      ScheduledTask::Clock::time_point when = ScheduledTask::Clock::now());
+
+    /** It unschedules a task, waiting for it to yield if it is running
+     * (thread-safe, and callable from a task). It does not run again after.
+     * \param task
+     * \return false if it was not scheduled (e.g. it finished)
+     */
+    bool remove(ScheduledTask* task);
+
+    /** It makes a task due now, e.g. when the message it waits for arrives
+     * (thread-safe, it does not allocate). A running task resumes again as 
+     * soon as it yields.
+     * \param task
+     * \return false if it is not scheduled
+     */
+    bool wake(ScheduledTask* task);
+
+    /** \return number of scheduled tasks */
+    size_t size();
+
+    /** \return number of resumed tasks since construction */
+    uint64_t resumes() const {
+      return resumes_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    /** It runs the due tasks until stopped or the deadline */
+    size_t run(ScheduledTask::Clock::time_point deadline);
+};
+
+} // end namespace remy_robot_control
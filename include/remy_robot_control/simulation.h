@@ -0,0 +1,99 @@
+#pragma once
+
+// remy
+#include <types.h>
+#include <control.h>
+#include <robot_system.h>
+
+// std
+#include <vector>
+#include <cstdint>
+
+namespace remy_robot_control {
+
+/** Settings of a closed-loop simulation (\sa simulate) */
+struct SimulationCase {
+  RemyRobotSettings robot;
+  RemyControlSettings control;
+  RemySystemSettings system;
+  double seconds; ///< simulated time
+  float initial_joints[3]; ///< plant joints at t = 0
+  double jitter; ///< std deviation of the plant step times [s]
+  uint32_t seed; ///< seed of the jitter
+  SimulationCase() : seconds(11), initial_joints{0, 0, 0}, jitter(0),
+    seed(0) {}
+};
+
+/** Outcome of a closed-loop simulation */
+struct SimulationResult {
+  double rms_error; ///< cartesian tracking error, while the trajectory runs
+  double max_error;
+  double effort; ///< \f$\int |u|^2 dt\f$
+  size_t samples; ///< plant steps while the trajectory runs
+  size_t saturations; ///< plant steps with a joint held at its limit
+};
+
+/** It turns off what a system run offline writes to disk: the csv log and
+ * the flight recorder (whose dumps would race between parallel runs, in the
+ * working directory, and whose ring costs memory per run)
+ * \param settings system settings
+ * \return the same settings, with save_output false and no recorder
+ */
+RemySystemSettings offlineSettings(const RemySystemSettings& settings);
+
+/** A controller/plant pair stepped in simulated time, with the same messages
+ * as over the connections (\sa simulate, Fleet): the plant steps to the 
+ * times it is given, and the controller runs at the first plant step of each
+ * of its periods. It does not sleep, so many of them can run in parallel.
+ */
+class LockStep {
+  Control& control;
+  RobotSystem& system;
+  double control_dt;
+  double time_;
+  size_t control_steps;
+  std::vector<unsigned char> joints;
+  std::vector<unsigned char> command;
+
+  public:
+    /** \param controller its period is the one of its settings
+     * \param plant
+     */
+    LockStep(Control& controller, RobotSystem& plant);
+
+    /** It steps the plant to the time t, then the controller if it is due
+     * (with the joints of this step)
+     * \param t simulated time [s], not before time()
+     * \return true if the controller ran
+     */
+    bool stepTo(double t);
+
+    /** \return simulated time of the last step [s] */
+    double time() const {
+      return time_;
+    }
+
+    /** \return number of controller steps */
+    size_t controlSteps() const {
+      return control_steps;
+    }
+};
+
+/** It simulates a controller/plant pair (Control and RobotSystem, with the
+ * same messages as over the connection) in simulated time: the plant steps at
+ * its period and the controller at its own, starting at the initial joints.
+ * With jitter, the k-th plant step happens at \f$k dt + e_k\f$, 
+ * \f$e_k \sim N(0, jitter)\f$ (the error does not accumulate). It is
+ * deterministic (for a seed) and does not sleep, so many of them can run in 
+ * parallel.
+ * The tracking error is the distance between the trajectory and the
+ * forward kinematics of the plant joints. Nothing is saved to disk 
+ * (\sa offlineSettings).
+ * \param waypoints trajectory (x, y, z, t)
+ * \param simulation settings
+ * \return tracking error and control effort
+ */
+SimulationResult simulate(const std::vector<Vector4<float>>& waypoints,
+  const SimulationCase& simulation);
+
+} // end namespace remy_robot_control
@@ -0,0 +1,175 @@
+#pragma once
+
+// std
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstddef>
+
+namespace remy_robot_control {
+
+/** Streaming estimate of a quantile with the P² algorithm (Jain and
+ * Chlamtac, 1985): five markers whose heights are adjusted with a piecewise
+ * parabolic interpolation, so it takes O(1) memory and time per sample,
+ * whatever the number of samples. The first five samples are exact.
+ */
+class P2Quantile {
+  double p_;
+  size_t count_;
+  std::array<double, 5> q_; ///< marker heights
+  std::array<double, 5> n_; ///< marker positions
+  std::array<double, 5> np_; ///< desired positions
+  std::array<double, 5> dn_; ///< increments of the desired positions
+
+  public:
+    /** \param p the quantile, in (0, 1) */
+    explicit P2Quantile(double p) : p_(p), count_(0) {
+      dn_ = {0, p_ / 2, p_, (1 + p_) / 2, 1};
+    }
+
+    void add(double x) {
+      if (count_ < 5) {
+        q_[count_++] = x;
+        if (count_ == 5) {
+          std::sort(q_.begin(), q_.end());
+          for (int i = 0; i < 5; ++i) {
+            n_[i] = i;
+          }
+          np_ = {0, 2 * p_, 4 * p_, 2 + 2 * p_, 4};
+        }
+        return;
+      }
+      ++count_;
+
+      int k;
+      if (x < q_[0]) {
+        q_[0] = x;
+        k = 0;
+      }
+      else if (x >= q_[4]) {
+        q_[4] = x;
+        k = 3;
+      }
+      else {
+        k = 0;
+        while (x >= q_[k + 1]) ++k;
+      }
+      for (int i = k + 1; i < 5; ++i) {
+        n_[i] += 1;
+      }
+      for (int i = 0; i < 5; ++i) {
+        np_[i] += dn_[i];
+      }
+
+      for (int i = 1; i < 4; ++i) {
+        double d = np_[i] - n_[i];
+        if ((d >= 1 && n_[i + 1] - n_[i] > 1) ||
+            (d <= -1 && n_[i - 1] - n_[i] < -1)) {
+          double s = (d >= 0) ? 1 : -1;
+          double q = parabolic(i, s);
+          if (!(q_[i - 1] < q && q < q_[i + 1]))
+            q = linear(i, s);
+          q_[i] = q;
+          n_[i] += s;
+        }
+      }
+    }
+
+    /** \return the estimate (NaN without samples) */
+    double value() const {
+      if (count_ == 0)
+        return std::numeric_limits<double>::quiet_NaN();
+      if (count_ < 5) { // exact, from the sorted samples
+        std::array<double, 5> q = q_;
+        std::sort(q.begin(), q.begin() + count_);
+        size_t i = std::min(count_ - 1, (size_t) std::floor(p_ * count_));
+        return q[i];
+      }
+      return q_[2];
+    }
+
+    double p() const {
+      return p_;
+    }
+
+    size_t count() const {
+      return count_;
+    }
+
+  private:
+    double parabolic(int i, double s) const {
+      return q_[i] + s / (n_[i + 1] - n_[i - 1]) * (
+        (n_[i] - n_[i - 1] + s) * (q_[i + 1] - q_[i]) / (n_[i + 1] - n_[i]) +
+        (n_[i + 1] - n_[i] - s) * (q_[i] - q_[i - 1]) / (n_[i] - n_[i - 1]));
+    }
+
+    double linear(int i, double s) const {
+      int j = i + (int) s;
+      return q_[i] + s * (q_[j] - q_[i]) / (n_[j] - n_[i]);
+    }
+};
+
+/** Streaming summary of a series: count, mean and standard deviation
+ * (Welford), min, max and a set of P² quantiles. It never stores the samples.
+ */
+class StreamingStats {
+  size_t count_;
+  double mean_;
+  double m2_;
+  double min_;
+  double max_;
+  std::vector<P2Quantile> quantiles_;
+
+  public:
+    /** \param quantiles the quantiles to estimate, in (0, 1) */
+    explicit StreamingStats(const std::vector<double>& quantiles =
+        {0.5, 0.9, 0.99}) :
+        count_(0), mean_(0), m2_(0),
+        min_(std::numeric_limits<double>::infinity()),
+        max_(- std::numeric_limits<double>::infinity()) {
+      for (auto p : quantiles) {
+        quantiles_.emplace_back(p);
+      }
+    }
+
+    void add(double x) {
+      ++count_;
+      double delta = x - mean_;
+      mean_ += delta / count_;
+      m2_ += delta * (x - mean_);
+      min_ = std::min(min_, x);
+      max_ = std::max(max_, x);
+      for (auto& q : quantiles_) {
+        q.add(x);
+      }
+    }
+
+    size_t count() const {
+      return count_;
+    }
+
+    double mean() const {
+      return mean_;
+    }
+
+    double stddev() const {
+      return (count_ > 1) ? std::sqrt(m2_ / (count_ - 1)) : 0;
+    }
+
+    double min() const {
+      return min_;
+    }
+
+    double max() const {
+      return max_;
+    }
+
+    /** \return the estimators, in the order of the constructor */
+    const std::vector<P2Quantile>& quantiles() const {
+      return quantiles_;
+    }
+};
+
+} // end namespace remy_robot_control
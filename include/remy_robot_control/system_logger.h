@@ -1,3 +1,6 @@
+// remy
+#include <trace.h>
+
 // std
 #include <string>
 #include <fstream>
@@ -41,6 +44,7 @@ class SystemLogger {
     */
     void save(const Eigen::Vector3f& pos, const Eigen::Vector3f& control, 
         const Eigen::Vector3f& q, double t) {
+      REMY_TRACE_ZONE("logger.save");
       file << std::fixed << std::setprecision(3) << t << "," << pos[0] 
         << "," << pos[1] << "," << pos[2] << "," << control[0] << "," << 
         control[1] << "," << control[2] << "," << q[0] << "," << q[1] << "," << 
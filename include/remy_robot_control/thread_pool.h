@@ -0,0 +1,112 @@
+#pragma once
+
+// std
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <algorithm>
+
+namespace remy_robot_control {
+
+/** A fixed-size pool of worker threads consuming a FIFO of tasks. It is used
+ * by the batch tools (workspace sweeps, parameter sweeps, simulations) to
+ * spread independent jobs over all the cores.
+ */
+class ThreadPool {
+  std::vector<std::thread> workers;
+  std::deque<std::function<void()>> tasks;
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool stop_;
+
+  public:
+    /** \param threads number of workers (0 means one per core) */
+    explicit ThreadPool(size_t threads = 0) : stop_(false) {
+      if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+      workers.reserve(threads);
+      for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back([this] { work(); });
+      }
+    }
+
+    ~ThreadPool() {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop_ = true;
+      }
+      cv.notify_all();
+      for (auto& worker : workers) {
+        worker.join();
+      }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /** Number of workers */
+    size_t size() const {
+      return workers.size();
+    }
+
+    /** It queues a task
+     * \param f callable with no arguments
+     * \return a future to wait for the task (it rethrows its exceptions)
+     */
+    template <class F>
+    std::future<void> submit(F&& f) {
+      auto task = std::make_shared<std::packaged_task<void()>>(
+        std::forward<F>(f));
+      auto future = task->get_future();
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.emplace_back([task] { (*task)(); });
+      }
+      cv.notify_one();
+      return future;
+    }
+
+    /** It splits [0, n) in one contiguous chunk per worker, runs
+     * f(chunk, begin, end) for each of them and waits. The chunk index
+     * (< size()) lets the caller keep per-worker buffers without locks.
+     * \param n number of items
+     * \param f callable (size_t chunk, size_t begin, size_t end)
+     */
+    template <class F>
+    void parallelFor(size_t n, F&& f) {
+      const size_t chunks = std::min(size(), std::max<size_t>(n, 1));
+      const size_t step = (n + chunks - 1) / chunks;
+      std::vector<std::future<void>> futures;
+      futures.reserve(chunks);
+      for (size_t c = 0; c < chunks; ++c) {
+        size_t begin = std::min(n, c * step);
+        size_t end = std::min(n, begin + step);
+        futures.push_back(submit([&f, c, begin, end] { f(c, begin, end); }));
+      }
+      for (auto& future : futures) {
+        future.get();
+      }
+    }
+
+  private:
+    void work() {
+      while (true) {
+        std::function<void()> task;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          cv.wait(lock, [this] { return stop_ || !tasks.empty(); });
+          if (stop_ && tasks.empty())
+            return;
+          task = std::move(tasks.front());
+          tasks.pop_front();
+        }
+        task();
+      }
+    }
+};
+
+} // end namespace remy_robot_control
@@ -0,0 +1,185 @@
+#pragma once
+
+// std
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <ostream>
+#include <cstdint>
+
+namespace remy_robot_control {
+
+namespace detail {
+/** Runtime switch of the tracer, constant-initialized, so a zone tests it
+ * without any static initialization guard */
+extern std::atomic<bool> trace_enabled;
+struct ThreadBuffer;
+} // end namespace detail
+
+/** A traced zone: a name (a string literal) and its begin and end times */
+struct TraceEvent {
+  const char* name;
+  uint64_t begin_ns; ///< since the Tracer epoch
+  uint64_t end_ns;
+};
+
+/** Events of one thread. It has a single writer (its thread), and it is
+ * preallocated: events beyond its capacity are dropped (and counted), so an
+ * export can read it while the thread keeps tracing. */
+struct TraceBuffer {
+  std::vector<TraceEvent> events;
+  std::atomic<size_t> count;
+  std::atomic<size_t> dropped;
+  std::atomic<const char*> name;
+  uint32_t tid;
+  bool in_use; ///< by a running thread (guarded by the Tracer)
+  TraceBuffer(size_t capacity, uint32_t id) : events(capacity), count(0),
+    dropped(0), name(nullptr), tid(id), in_use(true) {}
+};
+
+/** Process-wide tracer of scoped zones (\sa REMY_TRACE_ZONE). Each thread
+ * writes its events into its own buffer, without locks, and the buffers are
+ * exported as a Chrome trace (JSON), which chrome://tracing and Perfetto
+ * open as a timeline per thread. It is off at runtime until enable(): a
+ * disabled zone costs a single branch, and the zones compile to nothing
+ * without REMY_ENABLE_TRACING (CMake option). \n
+ * A buffer outlives its thread, so the events of finished threads are
+ * exported too; it is reused by a new thread once its events are cleared
+ * (or at once if it has none), so threads that come and go do not add up.
+ */
+class Tracer {
+  std::chrono::steady_clock::time_point epoch_;
+  mutable std::mutex mutex; ///< guards the list of buffers
+  std::vector<std::unique_ptr<TraceBuffer>> buffers;
+  std::vector<TraceBuffer*> free_buffers; ///< of finished threads, empty
+  size_t capacity_;
+  uint32_t tids_;
+
+  Tracer();
+
+  public:
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    static Tracer& instance();
+
+    void enable(bool enabled = true) {
+      detail::trace_enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool enabled() const {
+      return detail::trace_enabled.load(std::memory_order_relaxed);
+    }
+
+    /** It sets the capacity of the buffers given from now on (events per
+     * thread, 65536 by default). The free buffers of another capacity are
+     * freed at the next clear(). */
+    void setCapacity(size_t events);
+
+    /** It names the calling thread in the exports
+     * \param name a string literal (only the pointer is kept)
+     */
+    void setThreadName(const char* name);
+
+    /** \return nanoseconds since the epoch of the tracer */
+    uint64_t now() const {
+      return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - epoch_).count();
+    }
+
+    /** It records an event of the calling thread
+     * \param name a string literal (only the pointer is kept)
+     * \param begin_ns
+     * \param end_ns
+     */
+    void record(const char* name, uint64_t begin_ns, uint64_t end_ns) {
+      TraceBuffer& b = buffer();
+      size_t n = b.count.load(std::memory_order_relaxed);
+      if (n < b.events.size()) {
+        b.events[n] = {name, begin_ns, end_ns};
+        b.count.store(n + 1, std::memory_order_release);
+      }
+      else {
+        b.dropped.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+
+    /** \return number of recorded events, over all the threads */
+    size_t events() const;
+
+    /** \return number of events dropped by full buffers */
+    size_t dropped() const;
+
+    /** \return number of buffers, of running and finished threads */
+    size_t bufferCount() const;
+
+    /** It forgets the recorded events (while no thread is tracing), and the
+     * buffers of the finished threads become free */
+    void clear();
+
+    /** It writes the events as a Chrome trace (JSON object format)
+     * \param out
+     * \return false on failure
+     */
+    bool exportChrome(std::ostream& out) const;
+
+    /** Same as above, to a file */
+    bool exportChrome(const std::string& path) const;
+
+  private:
+    friend struct detail::ThreadBuffer;
+
+    /** \return the buffer of the calling thread, a free one or a new one on
+     * first use */
+    TraceBuffer& buffer();
+
+    /** It takes back the buffer of a thread which exits
+     * \param buffer
+     */
+    void release(TraceBuffer& buffer);
+};
+
+/** It records the time between its construction and its destruction, if the
+ * tracer is enabled at construction */
+class TraceZone {
+  const char* name_;
+  uint64_t begin_;
+  bool active_;
+
+  public:
+    explicit TraceZone(const char* name) : name_(name), begin_(0),
+        active_(detail::trace_enabled.load(std::memory_order_relaxed)) {
+      if (active_)
+        begin_ = Tracer::instance().now();
+    }
+
+    ~TraceZone() {
+      if (active_) {
+        Tracer& tracer = Tracer::instance();
+        tracer.record(name_, begin_, tracer.now());
+      }
+    }
+
+    TraceZone(const TraceZone&) = delete;
+    TraceZone& operator=(const TraceZone&) = delete;
+};
+
+} // end namespace remy_robot_control
+
+#define REMY_TRACE_CAT_(a, b) a##b
+#define REMY_TRACE_CAT(a, b) REMY_TRACE_CAT_(a, b)
+
+#ifdef REMY_ENABLE_TRACING
+/** It traces the enclosing scope under name (a string literal) */
+#define REMY_TRACE_ZONE(name) \
+  ::remy_robot_control::TraceZone REMY_TRACE_CAT(remy_trace_zone_, __LINE__)(name)
+/** It names the calling thread in the traces */
+#define REMY_TRACE_THREAD(name) \
+  ::remy_robot_control::Tracer::instance().setThreadName(name)
+#else
+#define REMY_TRACE_ZONE(name) do {} while (0)
+#define REMY_TRACE_THREAD(name) do {} while (0)
+#endif
@@ -1,51 +1,78 @@
 #pragma once
 
+#include <aligned_allocator.h>
+
 #include <Eigen/Geometry>
 #include <vector>
 #include <algorithm>
+#include <cstdint>
 
 /** This is a very simple way to make a piecewise-linear trajectory that computes
- * position and velocity (constant) given time and waypoints. 
- * In a general case, this should be a 3D-Spline, and we would be able to 
- * choose a velocity profile, with accelerations, for instance a trapezoidal 
+ * position and velocity (constant) given time and waypoints.
+ * In a general case, this should be a 3D-Spline, and we would be able to
+ * choose a velocity profile, with accelerations, for instance a trapezoidal
  * profile.
+ * The segments (the one ending at each waypoint) are stored as SoA arrays
+ * aligned to cache lines: end times, end points and velocities. A uniform
+ * index of the time gives the first segment of each bin, so update() scans a
+ * bin instead of searching all the segments: whatever their number (and a
+ * seek anywhere, as in replays), a lookup touches a few cache lines.
+ * It is templated on the scalar type; Trajectory (float) and Trajectoryd
+ * (double) are explicitly instantiated.
  */
-class Trajectory {
-  public: 
-    Eigen::Vector3f x;
-    Eigen::Vector3f v;
-    std::vector<Eigen::Vector4f> waypoints;
-    std::vector<float> times;
-
-    Trajectory(const std::vector<Eigen::Vector4f>& _waypoints) : 
-        waypoints(_waypoints) {
-      times.reserve(waypoints.size());
-      for (auto waypoint : waypoints) {
-        times.push_back(waypoint[3]);
-      }
-    }
-    
-    bool update(float t) {
-      auto it = std::lower_bound(times.begin(), times.end(), t);
-      if (it == times.end()) return false;
-      
-      size_t index = it - times.begin();
-      index = (index >= times.size()) ? times.size() - 1 : index;
-      auto t0 = (index == 0) ? 0 : times[index - 1];
-      auto tf = times[index];
-      auto x0 = (index == 0) ? Eigen::Vector3f::Zero() : 
-        Eigen::Vector3f(waypoints[index - 1].head(3));
-      auto xf = Eigen::Vector3f(waypoints[index].head(3));
-      
-      // x(t) = x0 + v(t-t0)
-      // v = (xf - x0) / (tf - t0)
-      if (tf == t0) {
-        v = Eigen::Vector3f::Zero();
-        x = xf;
-        return true;
-      }
-      v = (xf - x0) / (tf - t0);
-      x = x0 + v * (t - t0);
-      return true;
+template <class T>
+class TrajectoryT {
+  typedef std::vector<T, remy_robot_control::AlignedAllocator<T>> Array;
+
+  Array end_; ///< end time of each segment
+  Array xf_[3]; ///< end point of each segment
+  Array v_[3]; ///< velocity of each segment
+  /** first segment of each time bin, and the number of segments last (up
+   * to 2^32) */
+  std::vector<uint32_t, remy_robot_control::AlignedAllocator<uint32_t>> bins_;
+  T bin_scale_; ///< bins per second
+
+  public:
+    typedef Eigen::Matrix<T, 3, 1> Vector3;
+    typedef Eigen::Matrix<T, 4, 1> Vector4;
+
+    Vector3 x;
+    Vector3 v;
+
+    /** \param waypoints (x, y, z, t), sorted by time (the trajectory starts at
+     * the origin at time 0) */
+    TrajectoryT(const std::vector<Vector4>& waypoints);
+
+    /** It computes the desired position and velocity at time t
+     * \param t time (0 means start time)
+     * \return false if t is after the last waypoint
+    */
+    bool update(T t);
+
+    /** The same as update, without changing the trajectory (it can be read
+     * by several threads)
+     * \param t time (0 means start time)
+     * \param x desired position
+     * \param v desired velocity
+     * \return false if t is after the last waypoint
+    */
+    bool sample(T t, Vector3& x, Vector3& v) const;
+
+    /** \return number of waypoints */
+    size_t size() const {
+      return end_.size();
     }
-};
\ No newline at end of file
+
+    /** \return the waypoints (x, y, z, t) */
+    std::vector<Vector4> getWaypoints() const;
+
+  private:
+    /** \return the time bin of t (bins_.size() - 2 for the last ones) */
+    size_t bin(T t) const;
+};
+
+extern template class TrajectoryT<float>;
+extern template class TrajectoryT<double>;
+
+typedef TrajectoryT<float> Trajectory;
+typedef TrajectoryT<double> Trajectoryd;
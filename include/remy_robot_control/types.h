@@ -4,6 +4,7 @@
 #include <memory>
 #include <algorithm>
 #include <vector>
+#include <string>
 
 // Eigen
 #include <Eigen/Geometry>
@@ -14,8 +15,15 @@
 
 namespace remy_robot_control {
 
+template <class T>
+using Vector3 = Eigen::Matrix<T, 3, 1>;
+template <class T>
+using Vector4 = Eigen::Matrix<T, 4, 1>;
+template <class T>
+using JacobMPT = Eigen::Matrix<T, 3, 3>;
+
 typedef Eigen::Matrix<float, 6, 3> JacobM;
-typedef Eigen::Matrix<float, 3, 3> JacobMP;
+typedef JacobMPT<float> JacobMP;
 typedef Angle<float> Angled;
 
 /** Types of Foward Kinematics */
@@ -28,7 +36,15 @@ enum class FkType {
 enum class IkType {
   transpose, ///< Iterative method that uses the jacobian transpose
   analytical, ///< It explores the translational part of the homogeneous transform
-  damped ///< Damped least squares
+  damped, ///< Damped least squares
+  multistart ///< Damped least squares from several seeds, in parallel
+};
+
+/** What the inverse kinematics does with targets out of reach */
+enum class ReachPolicy {
+  none, ///< no check, the solver runs anyway
+  reject, ///< it returns NaN joints without running the solver
+  project ///< it solves for the nearest point within reach
 };
 
 /** Types of available Kinematics Control */
@@ -37,37 +53,101 @@ enum class ControlType {
   analytical ///< The analytical solution
 };
 
-struct RemyJoints {
-  Angled q1;
-  Angled q2;
-  Angled q3;
-  RemyJoints(float q1mM[2], float q2mM[2], float q3mM[2]) {
-    q1 = Angled(0, q1mM[0], q1mM[1]);
-    q2 = Angled(0, q2mM[0], q2mM[1]);
-    q3 = Angled(0, q3mM[0], q3mM[1]);
+/** What the (mocked) encoders publish over the connection */
+enum class EncoderOutput {
+  angle, ///< quantized joints converted back to float radians
+  ticks ///< raw integer tick counts, with the encoder resolution as metadata
+};
+
+template <class T>
+struct RemyJointsT {
+  Angle<T> q1;
+  Angle<T> q2;
+  Angle<T> q3;
+  RemyJointsT(T q1mM[2], T q2mM[2], T q3mM[2]) {
+    q1 = Angle<T>(0, q1mM[0], q1mM[1]);
+    q2 = Angle<T>(0, q2mM[0], q2mM[1]);
+    q3 = Angle<T>(0, q3mM[0], q3mM[1]);
   }
 };
+typedef RemyJointsT<float> RemyJoints;
 
 /** Remy Robot Settings */ 
 struct RemyRobotSettings {
   IkType iktype;
   FkType fktype;
+  ReachPolicy reach_policy;
   float joints_min[3];
   float joints_max[3];
+  float ik_cache_resolution; ///< 0 disables the IK cache
+  int ik_cache_capacity;
+  float joint_velocity_max[3]; ///< [rad/s] (\sa retime)
+  float joint_acceleration_max[3]; ///< [rad/s^2]
+  float retiming_step; ///< path length between the retiming samples (0: the input timestamps are kept)
   RemyRobotSettings() :
     iktype(IkType::analytical),
     fktype(FkType::fast),
-    joints_min{- M_PI, - M_PI_2, - M_PI},
-    joints_max{ M_PI,  M_PI_2,  M_PI}{}
+    reach_policy(ReachPolicy::project),
+    joints_min{- kPi<float>, - kPi_2<float>, - kPi<float>},
+    joints_max{ kPi<float>,  kPi_2<float>,  kPi<float>},
+    ik_cache_resolution(0),
+    ik_cache_capacity(4096),
+    joint_velocity_max{1.5f, 1.5f, 2},
+    joint_acceleration_max{5, 5, 10},
+    retiming_step(0){}
+};
+
+/** File formats of the flight recorder dumps (\sa FlightRecorder) */
+enum class RecorderFormat {
+  binary, ///< header and raw records
+  csv ///< one line per record
+};
+
+/** Integration methods of the plant (\sa IntegratorT) */
+enum class IntegratorType {
+  euler, ///< explicit (forward) Euler, first order
+  semi_implicit, ///< symplectic Euler: the velocity first, then the position with the new one
+  rk4 ///< classic fourth order Runge-Kutta
 };
 
 /** Remy Control Settings */ 
 struct RemyControlSettings {
   ControlType control_type;
   int frequency;
+  float q0dot[3]; ///< null-space joint velocities (feedforward)
+  float kp; ///< proportional gain of the cartesian error (feedforward)
+  float damping_w0; ///< manipulability below which damping starts
+  float damping_alpha0; ///< damping at zero manipulability
+  int horizon; ///< setpoints per message (1: the plain velocity message, at most kHorizonMax)
+  float horizon_dt; ///< time between setpoints [s]
   RemyControlSettings() :
     control_type(ControlType::feedfoward),
-    frequency(50){}
+    frequency(50),
+    q0dot{5, 5, 5},
+    kp(1),
+    damping_w0(0.001f),
+    damping_alpha0(0.01f),
+    horizon(1),
+    horizon_dt(0.01f){}
+};
+
+/** Models of the plant of RobotSystem */
+enum class PlantModel {
+  kinematic, ///< the joints follow the commanded velocities (\sa RemySystemSettings::actuator_tau)
+  dynamic ///< rigid-body dynamics driven by torque-limited velocity loops (\sa DynamicsT)
+};
+
+/** Rigid-body plant of RobotSystem */
+struct RemyDynamicsSettings {
+  float link_mass[3]; ///< [kg]
+  float viscous_friction[3]; ///< [N m s/rad]
+  float velocity_gain[3]; ///< gains of the joint velocity loops [N m s/rad]
+  float torque_max[3]; ///< joint torque limits [N m]
+  RemyDynamicsSettings() :
+    link_mass{1, 0.5f, 0.5f},
+    viscous_friction{1, 1, 0.5f},
+    velocity_gain{10000, 2000, 250},
+    torque_max{5000, 1000, 200}{}
 };
 
 /** Remy System Settings */ 
@@ -75,10 +155,29 @@ struct RemySystemSettings {
   int frequency;
   bool save_output;
   int encoder_resolution;
+  EncoderOutput encoder_output;
+  int command_timeout_ms; ///< older commands are replaced by zero (0: never)
+  IntegratorType integrator;
+  double integrator_step; ///< internal step [s], longer steps are split (0: never)
+  float actuator_tau; ///< time constant of the joint velocity loops [s] (0: ideal)
+  PlantModel plant;
+  RemyDynamicsSettings dynamics; ///< used by the dynamic plant
+  float recorder_seconds; ///< history of the flight recorder [s] (0: off, default)
+  std::string recorder_prefix; ///< of the flight recorder dumps
+  RecorderFormat recorder_format;
   RemySystemSettings() :
     frequency(50),
     save_output(true),
-    encoder_resolution(4096){}
+    encoder_resolution(4096),
+    encoder_output(EncoderOutput::angle),
+    command_timeout_ms(0),
+    integrator(IntegratorType::euler),
+    integrator_step(0),
+    actuator_tau(0),
+    plant(PlantModel::kinematic),
+    recorder_seconds(0),
+    recorder_prefix("flight_recorder"),
+    recorder_format(RecorderFormat::binary){}
 };
   
 } // end namespace remy_robot_cotrol
\ No newline at end of file
@@ -5,6 +5,11 @@
 
 // std
 #include <vector>
+#include <string>
+#include <utility>
+#include <initializer_list>
+#include <stdexcept>
+#include <cstdint>
 
 // Eigen
 #include <Eigen/Geometry>
@@ -21,8 +26,9 @@ namespace remy_robot_control {
   \param link_length length of the link
   \param offset offset between \f$X_{i-1}\f$ and \f$X_i\f$
 */
-Eigen::Affine3f DHToAffine(float theta, float alpha, float link_length, 
-    float offset = 0);
+template <class T>
+Eigen::Transform<T, 3, Eigen::Affine> DHToAffine(T theta, T alpha, 
+    T link_length, T offset = 0);
 
 /** Explicit pointer conversion char to float 
  * \param buffer char[4]
@@ -31,8 +37,9 @@ float charToFloat(unsigned char buffer[4]);
 
 /** Explicit pointer conversion float to char
  * \param f float
+ * \param buffer char[4], output
 */
-unsigned char* floatToChar(float f);
+void floatToChar(float f, unsigned char buffer[4]);
 
 /** It converts the vector<uchar> to Eigen::Vector3f
  * \param v_uchar vector<uchar> dimension 12 (3*4)
@@ -46,21 +53,146 @@ Eigen::Vector3f uchar3ToEigen3f(const std::vector<unsigned char>& v_uchar);
  */
 std::vector<unsigned char> eigen3fToUchar3(const Eigen::Vector3f& vec3);
 
-/** Encoder output to joint \f$[-\pi, \pi]\f$. The encoder is 12-bit precision.
+/** Same as above, into a buffer whose capacity is reused (the loops encode
+ * their messages without allocating)
+ * \param vec3 Eigen::Vector3f 
+ * \param v_uchar output, dimension 12 (3*4)
+ */
+void eigen3fToUchar3(const Eigen::Vector3f& vec3, 
+  std::vector<unsigned char>& v_uchar);
+
+/** Encoder output to joint \f$[-\pi, \pi]\f$. Default is 12-bit precision.
  * \param joint_int
+ * \param encoder_resolution number of ticks per revolution
  * \return joint_float
 */
-float encoderToJoint(int joint_int);
+template <class T = float>
+T encoderToJoint(int joint_int, int encoder_resolution = 4096);
+
+/** Joint \f$[-\pi, \pi]\f$ to encoder output (truncated tick count).
+ * \param joint
+ * \param encoder_resolution number of ticks per revolution
+ * \return tick count, \f$[0, resolution]\f$ for joints in range
+*/
+template <class T>
+int jointToEncoder(T joint, int encoder_resolution = 4096);
+template <class T>
+Eigen::Vector3i jointToEncoder(const Vector3<T>& joints, 
+  int encoder_resolution = 4096);
 
-/** It mocks the precision lost 12-bit of the encoder and it outputs the new 
+/** It mocks the precision lost of the encoder and it outputs the new 
  * joint \f$[-\pi, \pi]\f$. Inline modification. 
  * \param joint
  * \param encoder_resolution 
 */
-void mockEncoderPrecisionLost(float& joint, int encoder_resolution);
-void mockEncoderPrecisionLost(Eigen::Vector3f& joints, 
+template <class T>
+void mockEncoderPrecisionLost(T& joint, int encoder_resolution);
+template <class T>
+void mockEncoderPrecisionLost(Vector3<T>& joints, 
   int encoder_resolution = 4096);
 
+/** It packs raw encoder ticks into vector<uchar>. The layout is 
+ * [resolution, tick1, tick2, tick3], each one a little-endian int32, so the 
+ * message is the same on every platform.
+ * \param ticks the encoder tick counts
+ * \param encoder_resolution number of ticks per revolution (metadata)
+ * \return vector<uchar> dimension 16 (4*4)
+ */
+std::vector<unsigned char> encoderTicksToUchar(const Eigen::Vector3i& ticks, 
+  int encoder_resolution);
+
+/** Same as above, into a buffer whose capacity is reused
+ * \param ticks the encoder tick counts
+ * \param encoder_resolution number of ticks per revolution (metadata)
+ * \param v_uchar output, dimension 16 (4*4)
+ */
+void encoderTicksToUchar(const Eigen::Vector3i& ticks, int encoder_resolution,
+  std::vector<unsigned char>& v_uchar);
+
+/** It unpacks a message created by encoderTicksToUchar
+ * \param v_uchar vector<uchar> dimension 16 (4*4)
+ * \param ticks output encoder tick counts
+ * \param encoder_resolution output number of ticks per revolution
+ * \return false if v_uchar is not an encoder ticks message, or if its
+ * resolution is not within (0, kEncoderResolutionMax]
+ */
+bool ucharToEncoderTicks(const std::vector<unsigned char>& v_uchar, 
+  Eigen::Vector3i& ticks, int& encoder_resolution);
+
+/** It packs a horizon of future velocity setpoints into vector<uchar>. The
+ * setpoint k is for the time \f$t_0 + k\,dt\f$. The layout is [magic, count,
+ * t0, dt, u_0, ..., u_{count-1}], each field a little-endian int32 (floats by
+ * their bit pattern).
+ * \param setpoints velocities (at least one)
+ * \param t0 time of the first setpoint
+ * \param dt time between setpoints
+ * \return vector<uchar> dimension 16 + 12 * count
+ */
+std::vector<unsigned char> horizonToUchar(
+  const std::vector<Eigen::Vector3f>& setpoints, float t0, float dt);
+
+/** Same as above, into a buffer whose capacity is reused
+ * \param setpoints velocities (at least one)
+ * \param t0 time of the first setpoint
+ * \param dt time between setpoints
+ * \param v_uchar output, dimension 16 + 12 * count
+ */
+void horizonToUchar(const std::vector<Eigen::Vector3f>& setpoints, float t0, 
+  float dt, std::vector<unsigned char>& v_uchar);
+
+/** It unpacks a message created by horizonToUchar
+ * \param v_uchar the message
+ * \param setpoints output velocities (resized, the capacity is reused)
+ * \param t0 output time of the first setpoint
+ * \param dt output time between setpoints
+ * \return false if v_uchar is not a horizon message (of at most kHorizonMax
+ * setpoints)
+ */
+bool ucharToHorizon(const std::vector<unsigned char>& v_uchar, 
+  std::vector<Eigen::Vector3f>& setpoints, float& t0, float& dt);
+
+/** It appends to a control message (a velocity or a horizon) the inputs the
+ * controller computed it from, so the plant can record them and a run can be
+ * replayed exactly (\sa replay). The layout is [magic, t, q1, q2, q3], each
+ * field a little-endian int32 (floats by their bit pattern) but t, a double
+ * in two of them (low bits first). The decoders of the control messages
+ * ignore it.
+ * \param t controller time of the tick
+ * \param joints the joints it decoded
+ * \param v_uchar the control message, kControlInputsSize longer
+ */
+void appendControlInputs(double t, const Eigen::Vector3f& joints,
+  std::vector<unsigned char>& v_uchar);
+
+/** It reads the inputs appended by appendControlInputs
+ * \param v_uchar the control message
+ * \param t output controller time of the tick
+ * \param joints output joints it decoded
+ * \return false if the message has none
+ */
+bool ucharToControlInputs(const std::vector<unsigned char>& v_uchar, 
+  double& t, Eigen::Vector3f& joints);
+
+/** Size of the messages created by eigen3fToUchar3 and encoderTicksToUchar */
+constexpr size_t kJointsMsgSize = 3 * sizeof(float);
+constexpr size_t kTicksMsgSize = 4 * sizeof(int32_t);
+/** Largest encoder resolution of the ticks messages (a decoding table holds
+ * one angle per tick) */
+constexpr int kEncoderResolutionMax = 1 << 20;
+/** Largest count of setpoints of a horizon: the buffers of the loops are
+ * reserved for it, so a live change of the horizon does not allocate */
+constexpr int kHorizonMax = 64;
+/** Size of the largest message created by horizonToUchar */
+constexpr size_t kHorizonMsgMaxSize = 16 + 12 * kHorizonMax;
+/** First field of the messages created by horizonToUchar ("HRZN") */
+constexpr int32_t kHorizonMagic = 0x4e5a5248;
+/** Size of the inputs of appendControlInputs */
+constexpr size_t kControlInputsSize = 24;
+/** Size of the largest control message, a horizon with its inputs */
+constexpr size_t kControlMsgMaxSize = kHorizonMsgMaxSize + kControlInputsSize;
+/** First field of the inputs of appendControlInputs ("CTIN") */
+constexpr int32_t kControlInputsMagic = 0x4e495443;
+
 using json = nlohmann::json;
 
 /** Function to get a value from an attribute given the json file and field
@@ -72,9 +204,50 @@ using json = nlohmann::json;
 template<class T>
 T parseJsonFieldAtt(const json& j, const std::string& field, 
     const std::string& att) {
+  return j.at(field).at(att);
+}
+
+/** Same as above, but it returns default_value if the attribute is missing
+ * \param j the jason file
+ * \param field the field to get attribute from
+ * \param att the attribute
+ * \param default_value value used when field/att is not in the file
+ * \return value
+ */
+template<class T>
+T parseJsonFieldAtt(const json& j, const std::string& field, 
+    const std::string& att, const T& default_value) {
+  if (!j.contains(field) || !j[field].contains(att))
+    return default_value;
   return j[field][att];
 }
 
+/** Function to get an enum from a string attribute given the json file and
+ * field
+ * \param j the jason file
+ * \param field the field to get attribute from
+ * \param att the attribute
+ * \param values the name of each value
+ * \param default_value name used when field/att is not in the file (null:
+ * the attribute is required)
+ * \return value; it throws std::invalid_argument if the name is unknown
+ */
+template<class E>
+E parseJsonEnum(const json& j, const std::string& field, 
+    const std::string& att, 
+    std::initializer_list<std::pair<const char*, E>> values,
+    const char* default_value = nullptr) {
+  const std::string name = default_value ? 
+    parseJsonFieldAtt<std::string>(j, field, att, default_value) :
+    parseJsonFieldAtt<std::string>(j, field, att);
+  for (const auto& value : values) {
+    if (name == value.first)
+      return value.second;
+  }
+  throw std::invalid_argument(field + "." + att + ": unknown value \"" + 
+    name + "\"");
+}
+
 /** Function to retrieve robot settings from json file */ 
 RemyRobotSettings parseRobotSetting(const json& j);
 
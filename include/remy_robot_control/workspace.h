@@ -0,0 +1,178 @@
+#pragma once
+
+// remy
+#include <types.h>
+#include <thread_pool.h>
+
+// std
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <cmath>
+
+// Eigen
+#include <Eigen/Geometry>
+
+namespace remy_robot_control {
+
+/** A voxel map of the workspace of the arm. Each voxel holds one byte: 0 means
+ * unreachable and 1..255 the (quantized) best manipulability
+ * \f$|det(J)|\f$ found in the voxel, so queries are a single O(1) load.
+ * It is built by the sweeps below and it can be saved to disk and
+ * memory-mapped later (no parsing, no copy). The file has the following
+ * format (native endianness):
+ * \rst
+ * +-------+---------+------+--------+------------+-------+--------+
+ * | magic | version | dims | origin | resolution | scale | voxels |
+ * +-------+---------+------+--------+------------+-------+--------+
+ * \endrst
+ */
+class ReachabilityMap {
+  public:
+    /** File header */
+    struct Header {
+      char magic[4];
+      uint32_t version;
+      int32_t dims[3];
+      float origin[3];
+      float resolution;
+      float manipulability_scale; ///< manipulability of the value 255
+    };
+
+    /** Empty map covering [min, max]
+     * \param min lower corner of the map
+     * \param max upper corner of the map
+     * \param resolution edge of the voxels
+     */
+    ReachabilityMap(const Eigen::Vector3f& min, const Eigen::Vector3f& max,
+      float resolution);
+
+    /** Empty map covering the whole workspace of the Remy robot (every point
+     * within 20 of the base) */
+    explicit ReachabilityMap(float resolution);
+
+    ~ReachabilityMap();
+
+    ReachabilityMap(const ReachabilityMap&) = delete;
+    ReachabilityMap& operator=(const ReachabilityMap&) = delete;
+
+    /** It memory-maps a map saved by save()
+     * \param path file path
+     * \return the map (read-only), nullptr if the file is not a valid map
+     */
+    static std::unique_ptr<ReachabilityMap> load(const std::string& path);
+
+    /** It saves the map to a file
+     * \param path file path
+     * \return false on I/O error
+     */
+    bool save(const std::string& path) const;
+
+    /** \return true if (x, y, z) is in a reachable voxel */
+    bool isReachable(float x, float y, float z) const {
+      return value(x, y, z) != 0;
+    }
+
+    /** \return the best manipulability in the voxel of (x, y, z), 0 if
+     * unreachable */
+    float manipulability(float x, float y, float z) const {
+      uint8_t v = value(x, y, z);
+      return (v == 0) ? 0 : (v - 1) * header_.manipulability_scale / 254;
+    }
+
+    /** \return the raw voxel value of (x, y, z), 0 outside of the map */
+    uint8_t value(float x, float y, float z) const {
+      long i = index(x, y, z);
+      return (i < 0) ? 0 : data_[i];
+    }
+
+    /** \return the linear index of the voxel of (x, y, z), -1 outside */
+    long index(float x, float y, float z) const {
+      const float inv = 1 / header_.resolution;
+      long i = (long) std::floor((x - header_.origin[0]) * inv);
+      long j = (long) std::floor((y - header_.origin[1]) * inv);
+      long k = (long) std::floor((z - header_.origin[2]) * inv);
+      if (i < 0 || j < 0 || k < 0 || i >= header_.dims[0] ||
+          j >= header_.dims[1] || k >= header_.dims[2])
+        return -1;
+      return (k * header_.dims[1] + j) * header_.dims[0] + i;
+    }
+
+    /** \return the center of the voxel of a linear index */
+    Eigen::Vector3f center(size_t index) const;
+
+    /** \return total number of voxels */
+    size_t size() const {
+      return (size_t) header_.dims[0] * header_.dims[1] * header_.dims[2];
+    }
+
+    /** \return number of reachable voxels */
+    size_t reachableCount() const;
+
+    const Header& header() const {
+      return header_;
+    }
+
+    /** Raw voxels, writable only for maps that are not memory-mapped */
+    const uint8_t* data() const {
+      return data_;
+    }
+    uint8_t* mutableData() {
+      return owned_.empty() ? nullptr : owned_.data();
+    }
+
+  private:
+    ReachabilityMap() = default;
+
+    Header header_;
+    std::vector<uint8_t> owned_;
+    const uint8_t* data_ = nullptr;
+    void* mapped_ = nullptr;
+    size_t mapped_size_ = 0;
+};
+
+/** It builds a ReachabilityMap by evaluating the forward kinematics over a
+ * dense grid of joints within the limits of the settings. The grid is split
+ * by \f$\theta_1\f$ over the pool workers, each one with its own buffer,
+ * merged at the end.
+ * \param settings robot settings (joint limits, fk)
+ * \param resolution edge of the voxels
+ * \param samples number of samples per joint
+ * \param pool worker pool
+ * \return the map
+ */
+std::unique_ptr<ReachabilityMap> sweepJointGrid(
+  const RemyRobotSettings& settings, float resolution, int samples,
+  ThreadPool& pool);
+
+/** It builds a ReachabilityMap by solving the inverse kinematics (both
+ * analytical elbow branches) at the center and corners of every voxel, 
+ * keeping the solutions within the joint limits of the settings. The voxels are split
+ * over the pool workers.
+ * \param settings robot settings (joint limits)
+ * \param resolution edge of the voxels
+ * \param pool worker pool
+ * \return the map
+ */
+std::unique_ptr<ReachabilityMap> sweepCartesianGrid(
+  const RemyRobotSettings& settings, float resolution, ThreadPool& pool);
+
+/** It checks the waypoints of a trajectory against a map
+ * \param map reachability map
+ * \param waypoints (x, y, z, t)
+ * \return indices of the unreachable waypoints
+ */
+template <class T>
+std::vector<size_t> unreachableWaypoints(const ReachabilityMap& map,
+    const std::vector<Vector4<T>>& waypoints) {
+  std::vector<size_t> indices;
+  for (size_t i = 0; i < waypoints.size(); ++i) {
+    const auto& w = waypoints[i];
+    if (!map.isReachable((float)w[0], (float)w[1], (float)w[2]))
+      indices.push_back(i);
+  }
+  return indices;
+}
+
+} // end namespace remy_robot_control
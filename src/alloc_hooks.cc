@@ -0,0 +1,89 @@
+// Replacement of the global operator new and operator delete, which reports
+// them to AllocScope. Only the executables which compile this file in (tests,
+// benchmarks) are affected: it must not be part of the library.
+
+// remy
+#include <alloc_scope.h>
+
+// std
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+const bool installed = (remy_robot_control::detail::installAllocHooks(), 
+  true);
+
+/** As the default operator new: on failure, it calls the new_handler until
+ * one is not installed, then it throws bad_alloc
+ * \param caller return address of the operator new
+ */
+void* allocate(std::size_t size, const void* caller) {
+  void* p;
+  while (!(p = std::malloc(size ? size : 1))) {
+    std::new_handler handler = std::get_new_handler();
+    if (!handler)
+      throw std::bad_alloc();
+    handler();
+  }
+  remy_robot_control::detail::recordAllocation(size, caller);
+  return p;
+}
+
+void* allocateNoThrow(std::size_t size, const void* caller) noexcept {
+  try {
+    return allocate(size, caller);
+  }
+  catch (const std::bad_alloc&) {
+    return nullptr;
+  }
+}
+
+void deallocate(void* p) noexcept {
+  if (!p)
+    return;
+  remy_robot_control::detail::recordDeallocation();
+  std::free(p);
+}
+
+} // end namespace
+
+void* operator new(std::size_t size) {
+  return allocate(size, __builtin_return_address(0));
+}
+
+void* operator new[](std::size_t size) {
+  return allocate(size, __builtin_return_address(0));
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  return allocateNoThrow(size, __builtin_return_address(0));
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return allocateNoThrow(size, __builtin_return_address(0));
+}
+
+void operator delete(void* p) noexcept {
+  deallocate(p);
+}
+
+void operator delete[](void* p) noexcept {
+  deallocate(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+  deallocate(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+  deallocate(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+  deallocate(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+  deallocate(p);
+}
@@ -0,0 +1,183 @@
+// remy
+#include <alloc_scope.h>
+
+// std
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <vector>
+#include <execinfo.h>
+#include <cxxabi.h>
+
+namespace remy_robot_control {
+
+namespace {
+
+constexpr int kMaxFrames = 12;
+constexpr size_t kMaxSites = 32;
+
+/** Frames above the caller of operator new that backtrace may return (the
+ * hooks, and whatever the compiler did not inline) */
+constexpr int kHookFrames = 8;
+
+/** A call stack which allocated, and how often */
+struct AllocSite {
+  void* frames[kMaxFrames];
+  int depth;
+  size_t count;
+  size_t bytes;
+};
+
+/** The counters of a thread: plain data, so that reaching them never
+ * allocates */
+struct ThreadAllocs {
+  int scopes; ///< open scopes
+  bool busy; ///< within the hooks or a report, which are not counted
+  size_t allocations;
+  size_t deallocations;
+  size_t bytes;
+  size_t sites;
+  size_t dropped_sites; ///< allocations of the sites over kMaxSites
+  AllocSite site[kMaxSites];
+};
+
+thread_local ThreadAllocs allocs;
+bool hooks = false;
+
+/** It adds an allocation to its call site (no allocation)
+ * \param size bytes
+ * \param caller return address of operator new: the stack starts there, 
+ * whatever the frames of the hooks (the whole stack if it is not found)
+ */
+void recordSite(size_t size, const void* caller) {
+  void* frames[kMaxFrames + kHookFrames];
+  const int n = backtrace(frames, kMaxFrames + kHookFrames);
+  const int hooks = std::min(n, kHookFrames);
+  const int top = (int) (std::find(frames, frames + hooks, caller) - frames);
+  void** stack = frames + ((top < hooks) ? top : 0);
+  const int depth = std::min(kMaxFrames, (int) (frames + n - stack));
+  for (size_t i = 0; i < allocs.sites; ++i) {
+    AllocSite& s = allocs.site[i];
+    if (s.depth == depth && 
+        std::equal(stack, stack + depth, s.frames)) {
+      ++s.count;
+      s.bytes += size;
+      return;
+    }
+  }
+  if (allocs.sites == kMaxSites) {
+    ++allocs.dropped_sites;
+    return;
+  }
+  AllocSite& s = allocs.site[allocs.sites++];
+  std::copy(stack, stack + depth, s.frames);
+  s.depth = depth;
+  s.count = 1;
+  s.bytes = size;
+}
+
+/** \return the demangled function of a backtrace_symbols line */
+std::string symbolName(const char* line) {
+  // "binary(mangled+0x12) [0x...]"
+  const char* begin = std::strchr(line, '(');
+  const char* end = begin ? std::strpbrk(begin, "+)") : nullptr;
+  if (!begin || !end || end == begin + 1)
+    return line;
+  std::string mangled(begin + 1, end);
+  int status = 0;
+  char* name = abi::__cxa_demangle(mangled.c_str(), nullptr, nullptr, 
+    &status);
+  std::string result = (status == 0 && name) ? name : mangled;
+  std::free(name);
+  return result;
+}
+
+} // end namespace
+
+namespace detail {
+
+void recordAllocation(size_t size, const void* caller) {
+  if (allocs.scopes == 0 || allocs.busy)
+    return;
+  allocs.busy = true;
+  ++allocs.allocations;
+  allocs.bytes += size;
+  recordSite(size, caller);
+  allocs.busy = false;
+}
+
+void recordDeallocation() {
+  if (allocs.scopes > 0 && !allocs.busy)
+    ++allocs.deallocations;
+}
+
+void installAllocHooks() {
+  hooks = true;
+}
+
+} // end namespace detail
+
+AllocScope::AllocScope() {
+  if (allocs.scopes == 0) {
+    // the first backtrace loads the unwinder: not within the scope
+    void* frame;
+    allocs.busy = true;
+    backtrace(&frame, 1);
+    allocs.busy = false;
+    allocs.sites = 0;
+    allocs.dropped_sites = 0;
+  }
+  allocations_ = allocs.allocations;
+  deallocations_ = allocs.deallocations;
+  bytes_ = allocs.bytes;
+  ++allocs.scopes;
+}
+
+AllocScope::~AllocScope() {
+  --allocs.scopes;
+}
+
+size_t AllocScope::allocations() const {
+  return allocs.allocations - allocations_;
+}
+
+size_t AllocScope::deallocations() const {
+  return allocs.deallocations - deallocations_;
+}
+
+size_t AllocScope::bytes() const {
+  return allocs.bytes - bytes_;
+}
+
+std::string AllocScope::report(int frames) const {
+  const bool busy = allocs.busy;
+  allocs.busy = true;
+  std::ostringstream out;
+  std::vector<const AllocSite*> sites;
+  for (size_t i = 0; i < allocs.sites; ++i) {
+    sites.push_back(&allocs.site[i]);
+  }
+  std::stable_sort(sites.begin(), sites.end(), 
+    [](const AllocSite* a, const AllocSite* b) { return a->count > b->count; });
+  for (const AllocSite* s : sites) {
+    out << s->count << " allocation(s), " << s->bytes << " bytes:\n";
+    const int depth = std::min(s->depth, frames);
+    char** lines = backtrace_symbols(s->frames, depth);
+    for (int k = 0; k < depth; ++k) {
+      out << "    " << (lines ? symbolName(lines[k]) : "?") << "\n";
+    }
+    std::free(lines);
+  }
+  if (allocs.dropped_sites > 0)
+    out << allocs.dropped_sites << " allocation(s) of other sites\n";
+  std::string result = out.str();
+  allocs.busy = busy;
+  return result;
+}
+
+bool AllocScope::enabled() {
+  return hooks;
+}
+
+} // end namespace remy_robot_control
@@ -0,0 +1,307 @@
+// remy
+#include <batch_control.h>
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// the arrays of a batch never overlap, and there are too many of them for
+// the vectorizer to check it at runtime
+#if defined(__clang__)
+#define REMY_IVDEP _Pragma("clang loop vectorize(assume_safety)")
+#elif defined(__GNUC__)
+#define REMY_IVDEP _Pragma("GCC ivdep")
+#else
+#define REMY_IVDEP
+#endif
+
+namespace remy_robot_control {
+
+template <class T>
+BatchControlT<T>::BatchControlT() :
+  offsets(1, 0)
+{
+  setSettings(RemyControlSettings());
+  setRobotSettings(RemyRobotSettings());
+}
+
+template <class T>
+void BatchControlT<T>::setSettings(const RemyControlSettings& settings) {
+  type = settings.control_type;
+  // the period of ControlT
+  period_ = (T) std::max(20, (int)(1000.0 / settings.frequency)) / 1000;
+  kp = static_cast<T>(settings.kp);
+  damping_w0 = static_cast<T>(settings.damping_w0);
+  damping_alpha0 = static_cast<T>(settings.damping_alpha0);
+  for (int j = 0; j < 3; ++j) {
+    q0dot[j] = static_cast<T>(settings.q0dot[j]);
+  }
+}
+
+template <class T>
+void BatchControlT<T>::setRobotSettings(const RemyRobotSettings& settings) {
+  RobotT<T> model;
+  model.setSettings(settings);
+  reach_policy = settings.reach_policy;
+  reach_min = model.reachMin();
+  reach_max = model.reachMax();
+  for (int j = 0; j < 3; ++j) {
+    q_min[j] = static_cast<T>(settings.joints_min[j]);
+    q_max[j] = static_cast<T>(settings.joints_max[j]);
+  }
+}
+
+template <class T>
+size_t BatchControlT<T>::add(const std::vector<Vector4>& arm) {
+  for (const auto& w : arm) {
+    times.push_back(w[3]);
+    for (int j = 0; j < 3; ++j) {
+      waypoints[j].push_back(w[j]);
+    }
+  }
+  cursors.push_back(offsets.back());
+  offsets.push_back(times.size());
+  for (int j = 0; j < 3; ++j) {
+    xd[j].push_back(0);
+    vd[j].push_back(0);
+    u_[j].push_back(0);
+  }
+  active.push_back(0);
+  for (auto& v : scratch) {
+    v.push_back(0);
+  }
+  return cursors.size() - 1;
+}
+
+template <class T>
+void BatchControlT<T>::computeVelocityControl(const JointBlock<T>& joints,
+    T t) {
+  sample(t);
+  if (type == ControlType::analytical)
+    analytical(joints);
+  else
+    feedforward(joints);
+}
+
+template <class T>
+void BatchControlT<T>::sample(T t) {
+  const size_t n = size();
+  for (size_t i = 0; i < n; ++i) {
+    const size_t begin = offsets[i];
+    const size_t end = offsets[i + 1];
+    // the first waypoint at or after t, as TrajectoryT::update, moving
+    // forward from the last one (or searched again if the time went back)
+    size_t& c = cursors[i];
+    if (c > begin && times[c - 1] >= t)
+      c = std::lower_bound(times.begin() + begin, times.begin() + end, t) -
+        times.begin();
+    while (c < end && times[c] < t) {
+      ++c;
+    }
+    if (c == end) {
+      active[i] = 0;
+      continue;
+    }
+
+    active[i] = 1;
+    const T t0 = (c == begin) ? 0 : times[c - 1];
+    const T tf = times[c];
+    for (int j = 0; j < 3; ++j) {
+      const T x0 = (c == begin) ? 0 : waypoints[j][c - 1];
+      const T xf = waypoints[j][c];
+      if (tf == t0) {
+        vd[j][i] = 0;
+        xd[j][i] = xf;
+      }
+      else {
+        vd[j][i] = (xf - x0) / (tf - t0);
+        xd[j][i] = x0 + vd[j][i] * (t - t0);
+      }
+    }
+  }
+}
+
+template <class T>
+void BatchControlT<T>::feedforward(const JointBlock<T>& joints) {
+  const size_t n = size();
+  const T* q1 = joints.q(0);
+  const T* q2 = joints.q(1);
+  const T* q3 = joints.q(2);
+  T* s1 = scratch[0].data();
+  T* c1 = scratch[1].data();
+  T* s2 = scratch[2].data();
+  T* c2 = scratch[3].data();
+  T* s23 = scratch[4].data();
+  T* c23 = scratch[5].data();
+  // libm calls do not vectorize: the trigonometry first, in its own loop
+  for (size_t i = 0; i < n; ++i) {
+    s1[i] = std::sin(q1[i]);
+    c1[i] = std::cos(q1[i]);
+    s2[i] = std::sin(q2[i]);
+    c2[i] = std::cos(q2[i]);
+    s23[i] = std::sin(q2[i] + q3[i]);
+    c23[i] = std::cos(q2[i] + q3[i]);
+  }
+
+  const T* x1 = xd[0].data();
+  const T* x2 = xd[1].data();
+  const T* x3 = xd[2].data();
+  const T* v1 = vd[0].data();
+  const T* v2 = vd[1].data();
+  const T* v3 = vd[2].data();
+  const T* on = active.data();
+  T* u1 = u_[0].data();
+  T* u2 = u_[1].data();
+  T* u3 = u_[2].data();
+  const T gain = kp;
+  const T w0 = damping_w0;
+  const T alpha0 = damping_alpha0;
+  const T n1 = q0dot[0], n2 = q0dot[1], n3 = q0dot[2];
+  REMY_IVDEP
+  for (size_t i = 0; i < n; ++i) {
+    // J = [-s1 a, -c1 b, -c1 c; c1 a, -s1 b, -s1 c; 0, d, e] (\sa jacob)
+    const T a = 5 * (c23[i] + c2[i] + 2);
+    const T b = 5 * (s23[i] + s2[i]);
+    const T c = 5 * s23[i];
+    const T d = 5 * (c23[i] + c2[i]);
+    const T e = 5 * c23[i];
+    const T s = s1[i];
+    const T k = c1[i];
+
+    // v = xd' + kp (xd - fk(q))
+    const T v_1 = v1[i] + gain * (x1[i] - k * a);
+    const T v_2 = v2[i] + gain * (x2[i] - s * a);
+    const T v_3 = v3[i] + gain * (x3[i] - b);
+
+    // J J^t, and its damping by the manipulability w = det(J J^t)
+    const T bc = b * b + c * c;
+    const T m11 = s * s * a * a + k * k * bc;
+    const T m12 = s * k * (bc - a * a);
+    const T m13 = - k * (b * d + c * e);
+    const T m22 = k * k * a * a + s * s * bc;
+    const T m23 = - s * (b * d + c * e);
+    const T m33 = d * d + e * e;
+    const T w = m11 * (m22 * m33 - m23 * m23) - m12 * (m12 * m33 - m23 * m13) +
+      m13 * (m12 * m23 - m22 * m13);
+    const T f = std::max<T>(1 - w / w0, 0); // no damping above w0
+    const T alpha = alpha0 * f * f;
+
+    // u = J^t (J J^t + alpha I)^-1 (v - J q0dot) + q0dot, the same as
+    // Ji v + (I - Ji J) q0dot
+    const T r1 = v_1 + s * a * n1 + k * b * n2 + k * c * n3;
+    const T r2 = v_2 - k * a * n1 + s * b * n2 + s * c * n3;
+    const T r3 = v_3 - d * n2 - e * n3;
+    const T a11 = m11 + alpha, a22 = m22 + alpha, a33 = m33 + alpha;
+    const T i11 = a22 * a33 - m23 * m23;
+    const T i12 = m13 * m23 - m12 * a33;
+    const T i13 = m12 * m23 - m13 * a22;
+    const T i22 = a11 * a33 - m13 * m13;
+    const T i23 = m12 * m13 - a11 * m23;
+    const T i33 = a11 * a22 - m12 * m12;
+    const T det = a11 * i11 + m12 * i12 + m13 * i13;
+    const T y1 = (i11 * r1 + i12 * r2 + i13 * r3) / det;
+    const T y2 = (i12 * r1 + i22 * r2 + i23 * r3) / det;
+    const T y3 = (i13 * r1 + i23 * r2 + i33 * r3) / det;
+
+    // a finished trajectory (on = 0) holds the arm
+    u1[i] = on[i] * (- s * a * y1 + k * a * y2 + n1);
+    u2[i] = on[i] * (- k * b * y1 - s * b * y2 + d * y3 + n2);
+    u3[i] = on[i] * (- k * c * y1 - s * c * y2 + e * y3 + n3);
+  }
+}
+
+template <class T>
+void BatchControlT<T>::analytical(const JointBlock<T>& joints) {
+  const size_t n = size();
+  const T* x1 = xd[0].data();
+  const T* x2 = xd[1].data();
+  const T* x3 = xd[2].data();
+  T* px = scratch[0].data();
+  T* py = scratch[1].data();
+  T* pz = scratch[2].data();
+  T* dist = scratch[3].data();
+  const T rmin = reach_min;
+  const T rmax = reach_max;
+  const T project = (reach_policy == ReachPolicy::project) ? 1 : 0;
+  const T tiny = std::numeric_limits<T>::min();
+  // the targets projected within reach (\sa RobotT::projectToReach), with
+  // min/max only: a target within reach is scaled by exactly 1
+  REMY_IVDEP
+  for (size_t i = 0; i < n; ++i) {
+    const T rho = std::sqrt(x1[i] * x1[i] + x2[i] * x2[i]);
+    const T r = rho - 10;
+    const T d = std::sqrt(r * r + x3[i] * x3[i]);
+    const T target = std::min(std::max(d, rmin), rmax);
+    const T s = 1 + project * (target / std::max(d, tiny) - 1);
+    const T rho_p = 10 + r * s;
+    // a target on the z axis goes to the x axis, as atan2(0, 0) = 0
+    const T on_axis = 1 - rho / std::max(rho, tiny);
+    const T scale = rho_p / std::max(rho, tiny);
+    px[i] = x1[i] * scale + rho_p * on_axis;
+    py[i] = x2[i] * scale;
+    pz[i] = x3[i] * s;
+    dist[i] = d;
+  }
+
+  T* qs1 = scratch[4].data();
+  T* qs2 = scratch[5].data();
+  T* qs3 = scratch[6].data();
+  T* valid = scratch[7].data();
+  const bool reject = reach_policy == ReachPolicy::reject;
+  const T tol = static_cast<T>(1e-4);
+  const T half = static_cast<T>(0.5);
+  // the analytical inverse kinematics (\sa RobotT::analyticalIK), with its
+  // libm calls and branches
+  for (size_t i = 0; i < n; ++i) {
+    const T x = px[i], z = pz[i];
+    const T q1 = std::atan2(py[i], x);
+    const T c1 = std::cos(q1);
+    const T c1s = c1 * c1;
+    T q2, q3;
+    if (std::abs(c1s) <= static_cast<T>(1e-5)) { // x ~= 0
+      q3 = std::acos(half * (2 + (z * z / 25)));
+      const T c3 = std::cos(q3);
+      const T s3 = std::sin(q3);
+      q2 = std::asin((1 / (2 + 2 * c3)) * (z * (1 + c3) / 5 + 2 * s3));
+    }
+    else {
+      q3 = std::acos(half * (2 + (1 / (25 * c1s)) * (x * x + z * z * c1s) -
+        4 * x / (5 * c1)));
+      const T c3 = std::cos(q3);
+      const T s3 = std::sin(q3);
+      q2 = std::asin((1 / (2 + 2 * c3)) * (z * (1 + c3) / 5 -
+        x * s3 / (5 * c1) + 2 * s3));
+    }
+    // a rejected or unsolved target (NaN) and a finished trajectory hold the
+    // arm
+    const bool rejected = (reject && !(dist[i] >= rmin - tol &&
+      dist[i] <= rmax + tol)) || (reach_policy != ReachPolicy::none &&
+      !RobotT<T>::withinLimits(x, py[i], z, q_min, q_max));
+    const bool hold = rejected || !(active[i] > 0) ||
+      !std::isfinite(q1 + q2 + q3);
+    qs1[i] = hold ? 0 : q1;
+    qs2[i] = hold ? 0 : q2;
+    qs3[i] = hold ? 0 : q3;
+    valid[i] = hold ? 0 : 1;
+  }
+
+  const T* q1 = joints.q(0);
+  const T* q2 = joints.q(1);
+  const T* q3 = joints.q(2);
+  T* u1 = u_[0].data();
+  T* u2 = u_[1].data();
+  T* u3 = u_[2].data();
+  const T dt = period_;
+  REMY_IVDEP
+  for (size_t i = 0; i < n; ++i) {
+    u1[i] = valid[i] * (qs1[i] - q1[i]) / dt;
+    u2[i] = valid[i] * (qs2[i] - q2[i]) / dt;
+    u3[i] = valid[i] * (qs3[i] - q3[i]) / dt;
+  }
+}
+
+template class BatchControlT<float>;
+template class BatchControlT<double>;
+
+} // end namespace remy_robot_control
@@ -1,6 +1,7 @@
 // remy
 #include <control.h>
 #include <utils.h>
+#include <trace.h>
 
 // std
 #include <fstream>
@@ -8,149 +9,498 @@
 
 namespace remy_robot_control {
 
-Control::Control(const std::string& input) : 
-    connection(std::make_shared<Connection>()),
+/** The loop of main as a state machine of a Scheduler: it waits for the
+ * plant to open, then it acts on fresh joints only, every period. It waits
+ * for them without polling: the plant connection wakes it up when they are
+ * sent (\sa Connection::setListener), or its deadline does. */
+template <class T>
+class ControlT<T>::LoopTask : public ScheduledTask {
+  enum class State { opening, waiting };
+
+  ControlT& control;
+  std::weak_ptr<Connection> con;
+  State state;
+  uint64_t last_sequence;
+  Clock::time_point deadline; ///< of the wait for new joints
+  Clock::time_point ready; ///< of the next act
+  std::atomic<bool> waiting; ///< for new joints, to be woken up
+  std::vector<unsigned char> joints;
+
+  public:
+    LoopTask(ControlT& owner, std::weak_ptr<Connection> plant, 
+        Scheduler& scheduler) :
+      control(owner), con(plant), state(State::opening), last_sequence(0),
+      waiting(false)
+    {
+      joints.reserve(16);
+      if (auto conn = con.lock()) {
+        conn->setListener([this, &scheduler]() {
+          if (waiting.load())
+            scheduler.wake(this);
+        });
+      }
+    }
+
+    /** It stops the wake-ups of the plant connection */
+    void stopListening() {
+      if (auto conn = con.lock())
+        conn->setListener(nullptr);
+    }
+
+    Clock::time_point resume(Clock::time_point now) override {
+      const auto poll = std::chrono::milliseconds(1);
+      const auto period = std::chrono::milliseconds(control.sleep_ms);
+      auto conn = con.lock();
+      if (state == State::opening) {
+        if (!conn)
+          return finish();
+        // woken up as soon as the plant opens
+        if (!conn->isOpened())
+          return now + poll;
+        control.clock = std::chrono::system_clock::now();
+        state = State::waiting;
+        deadline = now + period;
+        ready = now;
+      }
+      if (!conn || !conn->isOpened())
+        return finish();
+
+      // one period at least between two acts, even if woken up
+      if (now < ready)
+        return ready;
+      // a send after the second test wakes it up (\sa Scheduler::wake)
+      if (conn->sequence() <= last_sequence) {
+        waiting = true;
+        if (conn->sequence() <= last_sequence) {
+          if (now >= deadline) {
+            ++control.stale_count;
+            deadline = now + period;
+          }
+          return deadline;
+        }
+      }
+      waiting = false;
+      Connection::Clock::time_point stamp;
+      last_sequence = conn->receive(joints, stamp);
+      control.act(joints);
+      deadline = now + 2 * period;
+      ready = now + period;
+      return ready;
+    }
+
+  private:
+    Clock::time_point finish() {
+      stopListening();
+      control.connection->close();
+      return finished();
+    }
+};
+
+template <class T>
+ControlT<T>::ControlT(const std::string& input) :
+    ControlT(std::vector<Vector4>())
+{
+  readInput(input);
+}
+
+template <class T>
+ControlT<T>::ControlT(std::vector<Vector4> waypoints) :
+    path_version(0),
+    path_start(0),
+    versions(0),
+    settings_version(0),
+    decoded_joints(Eigen::Vector3f::Zero()),
+    connection(std::make_shared<Connection>(kControlMsgMaxSize)),
     stop_(false),
     clock(std::chrono::system_clock::now()),
-    sleep_ms(20) 
+    sleep_ms(20),
+    stale_count(0),
+    horizon(1),
+    horizon_dt(static_cast<T>(0.01)),
+    scheduler(nullptr)
 {
-  readInput(input);
-  setControlStrategy(ControlType::feedfoward);
+  // any horizon fits, so changing it does not allocate
+  setpoints.reserve(kHorizonMax);
+  message.reserve(kControlMsgMaxSize);
+  loadTrajectory(std::move(waypoints));
+  setSettings(RemyControlSettings());
 }
 
-Control::~Control() {
+template <class T>
+ControlT<T>::~ControlT() {
   stop();
+  if (loading.valid())
+    loading.wait();
 }
 
-void Control::setSettings(const RemyControlSettings& settings) {
+template <class T>
+void ControlT<T>::setSettings(const RemyControlSettings& settings) {
   setControlStrategy(settings.control_type);
-  sleep_ms = std::max(20, (int)(1000 * (1.0 / (float)settings.frequency)));
+  sleep_ms = std::max(20, (int)(1000.0 / settings.frequency));
+  q0dot = Eigen::Vector3f(settings.q0dot).template cast<T>();
+  kp = static_cast<T>(settings.kp);
+  damping_w0 = static_cast<T>(settings.damping_w0);
+  damping_alpha0 = static_cast<T>(settings.damping_alpha0);
+  horizon = std::min(std::max(1, settings.horizon), kHorizonMax);
+  horizon_dt = static_cast<T>(settings.horizon_dt);
 }
 
-void Control::setRobotSettings(const RemyRobotSettings& settings) {
+template <class T>
+void ControlT<T>::setRobotSettings(const RemyRobotSettings& settings) {
   model.setSettings(settings);
+  robot_settings = settings;
+  std::vector<Vector4> waypoints;
+  {
+    std::lock_guard<std::mutex> lock(load_mutex);
+    waypoints = input_waypoints;
+  }
+  loadTrajectory(std::move(waypoints));
+}
+
+template <class T>
+void ControlT<T>::setLiveSettings(std::shared_ptr<const LiveSettings> settings) {
+  live_settings = std::move(settings);
+  live_encoder_table.reset();
+  settings_version = 0;
+}
+
+template <class T>
+void ControlT<T>::updateSettings() {
+  if (!live_settings)
+    return;
+  auto snapshot = live_settings->read();
+  if (snapshot->version == settings_version)
+    return;
+  settings_version = snapshot->version;
+  setSettings(snapshot->control);
+  model.updateSettings(snapshot->robot);
+  live_encoder_table = snapshot->encoder_table;
 }
 
-void Control::start(std::weak_ptr<Connection> con) {
+template <class T>
+void ControlT<T>::start(std::weak_ptr<Connection> con) {
   stop();
   stop_ = false;
-  thread = std::thread(&Control::main, this, con);
+  thread = std::thread(&ControlT::main, this, con);
+}
+
+template <class T>
+void ControlT<T>::start(std::weak_ptr<Connection> con, Scheduler& scheduler) {
+  stop();
+  connection->open();
+  this->scheduler = &scheduler;
+  task = std::make_unique<LoopTask>(*this, con, scheduler);
+  scheduler.add(task.get());
 }
 
-void Control::stop() {
+template <class T>
+void ControlT<T>::stop() {
   stop_ = true;
   if (thread.joinable()) thread.join();
+  if (scheduler) {
+    scheduler->remove(task.get());
+    task->stopListening();
+    connection->close();
+    scheduler = nullptr;
+  }
 }
 
-void Control::readInput(const std::string& input) {
-  std::vector<Eigen::Vector4f> waypoints;
+template <class T>
+static std::vector<Vector4<T>> readWaypoints(const std::string& input) {
+  std::vector<Vector4<T>> waypoints;
   std::ifstream file(input);
   std::string line;
   while(std::getline(file, line))
   {
     std::istringstream iss(line);
-    float x, y, z, t;
+    T x, y, z, t;
     if (!(iss >> x >> y >> z >> t)) { break; }
-    waypoints.push_back(Eigen::Vector4f(x, y, z, t)); 
+    waypoints.push_back(Vector4<T>(x, y, z, t));
   }
-  trajectory = std::make_unique<Trajectory>(std::move(waypoints));
+  return waypoints;
+}
+
+template <class T>
+void ControlT<T>::readInput(const std::string& input) {
+  loadTrajectory(readWaypoints<T>(input));
 }
 
-void Control::main(std::weak_ptr<Connection> con) {
+template <class T>
+void ControlT<T>::loadTrajectory(std::vector<Vector4> waypoints) {
+  load(std::move(waypoints), robot_settings, nullptr, false, false);
+}
+
+template <class T>
+std::shared_future<bool> ControlT<T>::loadAsync(const std::string& input) {
+  return launch([input]() {
+    return readWaypoints<T>(input);
+  });
+}
+
+template <class T>
+std::shared_future<bool> ControlT<T>::loadAsync(
+    std::vector<Vector4> waypoints) {
+  return launch([waypoints]() {
+    return waypoints;
+  });
+}
+
+template <class T>
+std::shared_future<bool> ControlT<T>::launch(
+    std::function<std::vector<Vector4>()> source) {
+  if (loading.valid())
+    loading.wait();
+  // the settings when the load was asked for
+  RemyRobotSettings settings = live_settings ? live_settings->read()->robot :
+    robot_settings;
+  std::shared_ptr<const ReachabilityMap> map = reachability;
+  loading = std::async(std::launch::async, [this, source, settings, map]() {
+    return load(source(), settings, map, true, true);
+  }).share();
+  return loading;
+}
+
+template <class T>
+bool ControlT<T>::load(std::vector<Vector4> waypoints, 
+    const RemyRobotSettings& settings, 
+    std::shared_ptr<const ReachabilityMap> map, bool checked, 
+    bool starts_on_read) {
+  if (checked) {
+    if (waypoints.empty())
+      return false;
+    for (size_t i = 0; i < waypoints.size(); ++i) {
+      if (!waypoints[i].allFinite() || 
+          (i > 0 && waypoints[i][3] < waypoints[i - 1][3]))
+        return false;
+    }
+    if (map && !remy_robot_control::unreachableWaypoints(*map, 
+        waypoints).empty())
+      return false;
+  }
+
+  std::lock_guard<std::mutex> lock(load_mutex);
+  RobotT<T> robot;
+  robot.setSettings(settings);
+  retiming = retime(waypoints, robot, settings);
+  input_waypoints = std::move(waypoints);
+  path.publish(std::unique_ptr<const Path>(new Path{TrajectoryT<T>(
+    retiming.solved ? retiming.waypoints : input_waypoints), ++versions, 
+    starts_on_read}));
+  return true;
+}
+
+template <class T>
+bool ControlT<T>::desired(T t, Vector3& x, Vector3& v) {
+  auto p = path.read();
+  if (p->version != path_version) {
+    path_version = p->version;
+    path_start = p->starts_on_read ? t : 0;
+  }
+  return p->trajectory.sample(t - path_start, x, v);
+}
+
+template <class T>
+void ControlT<T>::main(std::weak_ptr<Connection> con) {
+  REMY_TRACE_THREAD("control");
   connection->open();
+  // woken up as soon as the plant opens
   while(auto conn = con.lock()) {
-    if (!conn->isOpened()) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(1));
-    }
-    else break;
+    if (stop_ || conn->waitOpened(std::chrono::milliseconds(1))) break;
   }
 
   clock = std::chrono::system_clock::now();
+  uint64_t last_sequence = 0;
+  std::vector<unsigned char> joints;
+  joints.reserve(kTicksMsgSize);
   while(auto conn = con.lock()) {
+    REMY_TRACE_ZONE("control.loop");
     if (!conn->isOpened()) break;
     if (stop_) {
       break;
     }
-    std::vector<unsigned char> joints;
-    conn->receive(joints);
-    auto q = uchar3ToEigen3f(joints);
-    
-    auto new_clock = std::chrono::system_clock::now();
-    std::chrono::duration<double> diff = new_clock - clock;
-    computeVelocityControl(q, diff.count());
-    auto u_eigen = getControlSignal();
-    auto u = eigen3fToUchar3(u_eigen);
-    connection->send(u);
+    // it acts on fresh joints only, woken up when they are published
+    uint64_t sequence = conn->waitNewer(last_sequence, joints, 
+      std::chrono::milliseconds(sleep_ms));
+    if (sequence == 0) {
+      ++stale_count;
+      continue;
+    }
+    last_sequence = sequence;
+    act(joints);
     std::this_thread::sleep_for(std::chrono::milliseconds(sleep_ms));
   }
   connection->close();
 }
 
-void Control::setControlStrategy(ControlType type) {
+template <class T>
+void ControlT<T>::act(const std::vector<unsigned char>& joints) {
+  auto new_clock = std::chrono::system_clock::now();
+  std::chrono::duration<T> diff = new_clock - clock;
+  {
+    REMY_TRACE_ZONE("control.step");
+    step(joints, diff.count(), message);
+  }
+  // so the plant records what the command was computed from
+  appendControlInputs((double) diff.count(), decoded_joints, message);
+  connection->send(message);
+}
+
+template <class T>
+std::vector<unsigned char> ControlT<T>::step(
+    const std::vector<unsigned char>& joints, T t) {
+  std::vector<unsigned char> u;
+  step(joints, t, u);
+  return u;
+}
+
+template <class T>
+void ControlT<T>::step(const std::vector<unsigned char>& joints, T t,
+    std::vector<unsigned char>& message) {
+  updateSettings();
+  Vector3 q = decodeJoints(joints).template cast<T>();
+  computeVelocityControl(q, t);
+  if (horizon <= 1) {
+    eigen3fToUchar3(getControlSignal().template cast<float>(), message);
+    return;
+  }
+
+  setpoints.resize(horizon);
+  setpoints[0] = control_signal.template cast<float>();
+  Vector3 u = control_signal;
+  for (int k = 1; k < horizon; ++k) {
+    q += u * horizon_dt;
+    u = control_(q, t + k * horizon_dt);
+    setpoints[k] = u.template cast<float>();
+  }
+  horizonToUchar(setpoints, (float) t, (float) horizon_dt, message);
+}
+
+template <class T>
+T ControlT<T>::period() const {
+  return (T)sleep_ms / 1000;
+}
+
+template <class T>
+size_t ControlT<T>::getStaleCount() const {
+  return stale_count;
+}
+
+template <class T>
+Eigen::Vector3f ControlT<T>::decodeJoints(
+    const std::vector<unsigned char>& joints) {
+  Eigen::Vector3i ticks;
+  int resolution;
+  if (!ucharToEncoderTicks(joints, ticks, resolution)) {
+    if (joints.size() != kTicksMsgSize)
+      decoded_joints = uchar3ToEigen3f(joints);
+    return decoded_joints;
+  }
+
+  if (!encoder_table || encoder_table->resolution() != resolution)
+    encoder_table = (live_encoder_table && 
+      live_encoder_table->resolution() == resolution) ? live_encoder_table :
+      sharedEncoderTable(resolution);
+  decoded_joints = (*encoder_table)(ticks);
+  return decoded_joints;
+}
+
+template <class T>
+void ControlT<T>::setControlStrategy(ControlType type) {
   switch (type)
   {
     case ControlType::feedfoward:
-      control_ = [this](const Eigen::Vector3f& joints, float t) {
+      control_ = [this](const Vector3& joints, T t) {
         return feedforwardControl(joints, t);
       };
       break;
 
     case ControlType::analytical:
-      control_ = [this](const Eigen::Vector3f& joints, float t) {
+      control_ = [this](const Vector3& joints, T t) {
         return analyticalControl(joints, t);
       };
       break;
-    
+
     default:
-      control_ = [this](const Eigen::Vector3f& joints, float t) {
+      control_ = [this](const Vector3& joints, T t) {
         return feedforwardControl(joints, t);
       };
       break;
   }
 }
 
-std::vector<Eigen::Vector4f> Control::getWaypoints() const {
-  return trajectory->waypoints;
+template <class T>
+std::vector<Vector4<T>> ControlT<T>::getWaypoints() const {
+  return path.read()->trajectory.getWaypoints();
+}
+
+template <class T>
+RetimedPathT<T> ControlT<T>::getRetiming() {
+  std::lock_guard<std::mutex> lock(load_mutex);
+  return retiming;
+}
+
+template <class T>
+void ControlT<T>::setReachabilityMap(
+    std::shared_ptr<const ReachabilityMap> map) {
+  reachability = map;
 }
 
-Eigen::Vector3f Control::getControlSignal() const {
+template <class T>
+std::vector<size_t> ControlT<T>::unreachableWaypoints() const {
+  if (!reachability)
+    return {};
+  return remy_robot_control::unreachableWaypoints(*reachability, 
+    getWaypoints());
+}
+
+template <class T>
+Vector3<T> ControlT<T>::getControlSignal() const {
   return control_signal;
 }
 
-void Control::computeVelocityControl(const Eigen::Vector3f& joints, 
-    float t) {
+template <class T>
+void ControlT<T>::computeVelocityControl(const Vector3& joints, T t) {
   control_signal = control_(joints, t);
 }
 
-Eigen::Vector3f Control::feedforwardControl(const Eigen::Vector3f& q,
-    float t) {
-  auto q0dot = Eigen::Vector3f(5, 5, 5);
+template <class T>
+Vector3<T> ControlT<T>::feedforwardControl(const Vector3& q, T t) {
+  typedef JacobMPT<T> Matrix3;
+  const T w0 = damping_w0;
+  const T alpha0 = damping_alpha0;
   auto x = model.forwardKinematics(q);
-  if (!trajectory->update(t)) {
-    return Eigen::Vector3f::Zero();
+  Vector3 xd, vd;
+  if (!desired(t, xd, vd)) {
+    return Vector3::Zero();
   }
-  auto dx = trajectory->x - x;
-  auto v = trajectory->v + Eigen::Matrix3f::Identity() * dx;
+  auto dx = xd - x;
+  auto v = vd + Matrix3::Identity() * kp * dx;
   auto J = model.jacob(q);
   auto Jt = J.transpose();
   auto JJt = J * Jt;
   auto w = JJt.determinant();
-  auto alpha = (w >= 0.001) ? 0 : 0.01 * (1 - w / 0.001) * (1 - w / 0.001);
-  auto L = Eigen::Matrix3f::Identity() * alpha;
+  auto alpha = (w >= w0) ? 0 : alpha0 * (1 - w / w0) * (1 - w / w0);
+  auto L = Matrix3::Identity() * alpha;
   auto Ji = Jt * (JJt + L).inverse();
-  return Ji * v + (Eigen::Matrix3f::Identity() - Ji * J) * q0dot;
+  return Ji * v + (Matrix3::Identity() - Ji * J) * q0dot;
 }
 
-Eigen::Vector3f Control::analyticalControl(const Eigen::Vector3f& q,
-    float t) {
-  float dt = (float)sleep_ms / 1000;
-  if (!trajectory->update(t)) {
-    return Eigen::Vector3f::Zero();
+template <class T>
+Vector3<T> ControlT<T>::analyticalControl(const Vector3& q, T t) {
+  T dt = (T)sleep_ms / 1000;
+  Vector3 xd, vd;
+  if (!desired(t, xd, vd)) {
+    return Vector3::Zero();
   }
-  auto xd = trajectory->x;
   auto qd = model.inverseKinematics(xd[0], xd[1], xd[2]);
+  if (!qd.allFinite()) { // rejected target, hold the arm
+    return Vector3::Zero();
+  }
   auto dq = qd - q;
-  return dq / dt; 
+  return dq / dt;
 }
 
-} // end namespace remy_robot_control
\ No newline at end of file
+template class ControlT<float>;
+template class ControlT<double>;
+
+} // end namespace remy_robot_control
@@ -0,0 +1,180 @@
+// remy
+#include <dynamics.h>
+
+// std
+#include <cmath>
+
+namespace remy_robot_control {
+
+template <class T>
+DynamicsT<T>::DynamicsT(const RemyDynamicsSettings& settings) :
+  a_{10, 5, 5},
+  alpha_{kPi_2<T>, 0, 0},
+  gravity_(static_cast<T>(9.81))
+{
+  setSettings(settings);
+}
+
+template <class T>
+void DynamicsT<T>::setSettings(const RemyDynamicsSettings& settings) {
+  const T r = static_cast<T>(0.1);
+  for (int i = 0; i < 3; ++i) {
+    const T m = static_cast<T>(settings.link_mass[i]);
+    const T a = a_[i];
+    Matrix3 I = Matrix3::Zero();
+    I(0, 0) = m * r * r / 2;
+    I(1, 1) = I(2, 2) = m * (3 * r * r + a * a) / 12;
+    setLink(i, m, Vector3(- a / 2, 0, 0), I);
+    friction_[i] = static_cast<T>(settings.viscous_friction[i]);
+  }
+}
+
+template <class T>
+void DynamicsT<T>::setLink(int i, T mass, const Vector3& com,
+    const Matrix3& inertia) {
+  mass_[i] = mass;
+  com_[i] = com;
+  inertia_[i] = inertia;
+}
+
+template <class T>
+void DynamicsT<T>::frames(const Vector3& q, Frames& f) const {
+  Matrix3 R = Matrix3::Identity();
+  f.p[0].setZero();
+  for (int i = 0; i < 3; ++i) {
+    f.z[i] = R.col(2);
+    const T ct = std::cos(q[i]);
+    const T st = std::sin(q[i]);
+    const T ca = std::cos(alpha_[i]);
+    const T sa = std::sin(alpha_[i]);
+    Matrix3 Ri;
+    Ri << ct, -st * ca,  st * sa,
+          st,  ct * ca, -ct * sa,
+           0,       sa,       ca;
+    f.p[i + 1] = f.p[i] + R * Vector3(a_[i] * ct, a_[i] * st, 0);
+    R = R * Ri;
+    f.c[i] = f.p[i + 1] + R * com_[i];
+    f.I[i] = R * inertia_[i] * R.transpose();
+  }
+}
+
+template <class T>
+Vector3<T> DynamicsT<T>::rnea(const Frames& f, const Vector3& qd,
+    const Vector3& qdd, T gravity) const {
+  // forward: velocities and accelerations, the base accelerates upwards to
+  // account for the gravity
+  std::array<Vector3, 3> w, wd, ac;
+  Vector3 wi = Vector3::Zero();
+  Vector3 wdi = Vector3::Zero();
+  Vector3 ai(0, 0, gravity); ///< acceleration of the origin of the joint
+  for (int i = 0; i < 3; ++i) {
+    const Vector3& z = f.z[i];
+    wdi += qdd[i] * z + qd[i] * wi.cross(z);
+    wi += qd[i] * z;
+    const Vector3 rc = f.c[i] - f.p[i];
+    const Vector3 r = f.p[i + 1] - f.p[i];
+    ac[i] = ai + wdi.cross(rc) + wi.cross(wi.cross(rc));
+    ai += wdi.cross(r) + wi.cross(wi.cross(r));
+    w[i] = wi;
+    wd[i] = wdi;
+  }
+
+  // backward: forces and moments (about the joint origins) on each link
+  Vector3 tau;
+  Vector3 f_next = Vector3::Zero();
+  Vector3 n_next = Vector3::Zero();
+  for (int i = 2; i >= 0; --i) {
+    const Vector3 F = mass_[i] * ac[i];
+    const Vector3 N = f.I[i] * wd[i] + w[i].cross(f.I[i] * w[i]);
+    n_next += (f.p[i + 1] - f.p[i]).cross(f_next) +
+      (f.c[i] - f.p[i]).cross(F) + N;
+    f_next += F;
+    tau[i] = n_next.dot(f.z[i]) + friction_[i] * qd[i];
+  }
+  return tau;
+}
+
+template <class T>
+Vector3<T> DynamicsT<T>::inverseDynamics(const Vector3& q, const Vector3& qd,
+    const Vector3& qdd) const {
+  Frames f;
+  frames(q, f);
+  return rnea(f, qd, qdd, gravity_);
+}
+
+template <class T>
+Eigen::Matrix<T, 3, 3> DynamicsT<T>::massMatrix(const Vector3& q) const {
+  Frames f;
+  frames(q, f);
+  return crba(f);
+}
+
+template <class T>
+Eigen::Matrix<T, 3, 3> DynamicsT<T>::crba(const Frames& f) const {
+  Matrix3 M;
+  // composite bodies k..2, from the tip: mass, center and inertia
+  T mc = 0;
+  Vector3 h = Vector3::Zero(); ///< first moment
+  for (int k = 2; k >= 0; --k) {
+    mc += mass_[k];
+    h += mass_[k] * f.c[k];
+    const Vector3 C = h / mc;
+    Matrix3 Ic = Matrix3::Zero();
+    for (int i = k; i < 3; ++i) {
+      const Vector3 d = f.c[i] - C;
+      Ic += f.I[i] + mass_[i] * (d.squaredNorm() * Matrix3::Identity() -
+        d * d.transpose());
+    }
+    // unit acceleration of joint k: force and moment about C
+    const Vector3& z = f.z[k];
+    const Vector3 force = mc * z.cross(C - f.p[k]);
+    const Vector3 moment = Ic * z;
+    for (int j = 0; j <= k; ++j) {
+      M(j, k) = M(k, j) = f.z[j].dot(moment + (C - f.p[j]).cross(force));
+    }
+  }
+  return M;
+}
+
+template <class T>
+Vector3<T> DynamicsT<T>::bias(const Vector3& q, const Vector3& qd) const {
+  Frames f;
+  frames(q, f);
+  return rnea(f, qd, Vector3::Zero(), gravity_);
+}
+
+template <class T>
+Vector3<T> DynamicsT<T>::gravity(const Vector3& q) const {
+  Frames f;
+  frames(q, f);
+  return rnea(f, Vector3::Zero(), Vector3::Zero(), gravity_);
+}
+
+template <class T>
+Vector3<T> DynamicsT<T>::forwardDynamics(const Vector3& q, const Vector3& qd,
+    const Vector3& tau) const {
+  Frames f;
+  frames(q, f);
+  return crba(f).llt().solve(tau - rnea(f, qd, Vector3::Zero(), gravity_));
+}
+
+template <class T>
+T DynamicsT<T>::potentialEnergy(const Vector3& q) const {
+  Frames f;
+  frames(q, f);
+  T v = 0;
+  for (int i = 0; i < 3; ++i) {
+    v += mass_[i] * gravity_ * f.c[i][2];
+  }
+  return v;
+}
+
+template <class T>
+T DynamicsT<T>::kineticEnergy(const Vector3& q, const Vector3& qd) const {
+  return qd.dot(massMatrix(q) * qd) / 2;
+}
+
+template class DynamicsT<float>;
+template class DynamicsT<double>;
+
+} // end namespace remy_robot_control
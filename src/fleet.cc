@@ -0,0 +1,86 @@
+// remy
+#include <fleet.h>
+#include <utils.h>
+
+// std
+#include <fstream>
+#include <chrono>
+
+// 3rdparty
+#include <json.hpp>
+
+using json = nlohmann::json;
+
+namespace remy_robot_control {
+
+Fleet::Fleet(ThreadPool& workers) : pool(workers) {
+}
+
+size_t Fleet::add(const std::string& input, const std::string& config) {
+  std::ifstream i(config);
+  json j;
+  i >> j;
+  return add(input, parseRobotSetting(j), parseControlSetting(j), 
+    parseSystemSetting(j));
+}
+
+size_t Fleet::add(const std::string& input, const RemyRobotSettings& robot,
+    const RemyControlSettings& control, const RemySystemSettings& system) {
+  Cell cell;
+  cell.control = std::make_unique<Control>(input);
+  cell.control->setSettings(control);
+  cell.control->setRobotSettings(robot);
+  cell.system = std::make_unique<RobotSystem>();
+  cell.system->setSettings(offlineSettings(system));
+  cell.system->setRobotSettings(robot);
+  cell.pair = std::make_unique<LockStep>(*cell.control, *cell.system);
+  cell.plant_steps = 0;
+  cells.push_back(std::move(cell));
+  return cells.size() - 1;
+}
+
+FleetReport Fleet::run(double seconds) {
+  FleetReport report;
+  report.arms = cells.size();
+  report.simulated_seconds = seconds;
+  report.plant_steps = 0;
+  report.control_steps = 0;
+  std::vector<size_t> plant_steps(cells.size());
+  std::vector<size_t> control_steps(cells.size());
+  for (size_t i = 0; i < cells.size(); ++i) {
+    plant_steps[i] = cells[i].plant_steps;
+    control_steps[i] = cells[i].pair->controlSteps();
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  pool.parallelFor(cells.size(), [this, seconds](size_t, size_t begin, 
+      size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      runCell(cells[i], seconds);
+    }
+  });
+  std::chrono::duration<double> wall = std::chrono::steady_clock::now() - 
+    start;
+  report.wall_seconds = wall.count();
+
+  for (size_t i = 0; i < cells.size(); ++i) {
+    report.plant_steps += cells[i].plant_steps - plant_steps[i];
+    report.control_steps += cells[i].pair->controlSteps() - control_steps[i];
+  }
+  return report;
+}
+
+Eigen::Vector3f Fleet::getJoints(size_t cell) {
+  return cells[cell].system->getJoints();
+}
+
+void Fleet::runCell(Cell& cell, double seconds) {
+  const double dt = cell.system->period();
+  const double end = cell.pair->time() + seconds;
+  // times are multiples of the periods, so they do not drift
+  while ((cell.plant_steps + 1) * dt <= end + 1e-9) {
+    cell.pair->stepTo(++cell.plant_steps * dt);
+  }
+}
+
+} // end namespace remy_robot_control
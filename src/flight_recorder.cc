@@ -0,0 +1,234 @@
+// remy
+#include <flight_recorder.h>
+#include <trace.h>
+
+// std
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+namespace remy_robot_control {
+
+namespace {
+
+std::atomic<uint32_t> signal_count(0);
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2,
+  "the signal handler needs a lock-free counter");
+
+void onSignal(int) {
+  signal_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+const char* reasonName(DumpReason reason) {
+  switch (reason) {
+    case DumpReason::request: return "request";
+    case DumpReason::signal: return "signal";
+    case DumpReason::stop: return "stop";
+    case DumpReason::fault: return "fault";
+  }
+  return "";
+}
+
+} // end namespace
+
+FlightRecorder::FlightRecorder(size_t capacity, const std::string& prefix,
+    RecorderFormat format) :
+  ring_(std::max<size_t>(capacity, 1)),
+  count_(0),
+  prefix_(prefix),
+  format_(format),
+  pending_(0),
+  signals_seen_(signal_count.load(std::memory_order_relaxed)),
+  fault_holdoff_(0),
+  files_(0),
+  dumps_(0),
+  snapshot_(ring_.size()),
+  snapshot_size_(0),
+  snapshot_reason_(DumpReason::request),
+  snapshot_busy_(false),
+  stop_(false)
+{
+  writer_ = std::thread(&FlightRecorder::writeSnapshots, this);
+}
+
+FlightRecorder::~FlightRecorder() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  writer_.join();
+}
+
+size_t FlightRecorder::size() const {
+  return (size_t) std::min<uint64_t>(count_, ring_.size());
+}
+
+size_t FlightRecorder::capacity() const {
+  return ring_.size();
+}
+
+uint64_t FlightRecorder::recorded() const {
+  return count_;
+}
+
+const FlightRecord& FlightRecorder::operator[](size_t i) const {
+  return ring_[(count_ - size() + i) % ring_.size()];
+}
+
+void FlightRecorder::request(DumpReason reason) {
+  pending_.store(1 + (int) reason, std::memory_order_release);
+}
+
+void FlightRecorder::fault() {
+  if (count_ < fault_holdoff_)
+    return;
+  fault_holdoff_ = count_ + ring_.size();
+  request(DumpReason::fault);
+}
+
+bool FlightRecorder::service() {
+  int pending = pending_.exchange(0, std::memory_order_acquire);
+  uint32_t signals = signal_count.load(std::memory_order_relaxed);
+  if (signals != signals_seen_) {
+    signals_seen_ = signals;
+    if (!pending) pending = 1 + (int) DumpReason::signal;
+  }
+  if (!pending)
+    return false;
+  if (snapshot_busy_.load(std::memory_order_acquire)) {
+    // still writing the previous one: next time
+    int none = 0;
+    pending_.compare_exchange_strong(none, pending);
+    return false;
+  }
+  // oldest sample first, at most two contiguous pieces of the ring
+  const size_t n = size();
+  const size_t first = (count_ - n) % ring_.size();
+  const size_t head = std::min(n, ring_.size() - first);
+  std::copy(ring_.begin() + first, ring_.begin() + first + head, 
+    snapshot_.begin());
+  std::copy(ring_.begin(), ring_.begin() + (n - head), 
+    snapshot_.begin() + head);
+  snapshot_size_ = n;
+  snapshot_reason_ = (DumpReason) (pending - 1);
+  snapshot_busy_.store(true, std::memory_order_release);
+  // no lock: the writer also wakes up on its own (\sa writeSnapshots)
+  cv_.notify_all();
+  return true;
+}
+
+void FlightRecorder::writeSnapshots() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    // a notify may come between the test and the wait: bounded wait
+    cv_.wait_for(lock, std::chrono::milliseconds(50), [this]() {
+      return stop_ || snapshot_busy_.load(std::memory_order_acquire);
+    });
+    if (snapshot_busy_.load(std::memory_order_acquire)) {
+      lock.unlock();
+      dumpRecords(snapshot_reason_, snapshot_.data(), snapshot_size_, 
+        nullptr, 0);
+      lock.lock();
+      snapshot_busy_.store(false, std::memory_order_release);
+      cv_.notify_all();
+    }
+    else if (stop_) {
+      return;
+    }
+  }
+}
+
+void FlightRecorder::flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait(lock, [this]() {
+    return !snapshot_busy_.load(std::memory_order_acquire);
+  });
+}
+
+std::string FlightRecorder::dump(DumpReason reason) {
+  const size_t n = size();
+  const size_t first = (count_ - n) % ring_.size();
+  const size_t head = std::min(n, ring_.size() - first);
+  return dumpRecords(reason, &ring_[first], head, ring_.data(), n - head);
+}
+
+std::string FlightRecorder::dumpRecords(DumpReason reason, 
+    const FlightRecord* first, size_t n1, const FlightRecord* second, 
+    size_t n2) {
+  REMY_TRACE_ZONE("recorder.dump");
+  std::string name = prefix_ + "_" + std::to_string(files_++) + "_" +
+    reasonName(reason) + (format_ == RecorderFormat::binary ? ".bin" : ".csv");
+  std::ofstream file(name, std::ios::binary);
+  if (!file || !writeRecords(file, format_, first, n1, second, n2))
+    return "";
+  {
+    std::lock_guard<std::mutex> lock(last_dump_mutex_);
+    last_dump_ = name;
+  }
+  ++dumps_;
+  return name;
+}
+
+bool FlightRecorder::write(std::ostream& out, RecorderFormat format) const {
+  const size_t n = size();
+  const size_t first = (count_ - n) % ring_.size();
+  const size_t head = std::min(n, ring_.size() - first);
+  return writeRecords(out, format, &ring_[first], head, ring_.data(), 
+    n - head);
+}
+
+bool FlightRecorder::writeRecords(std::ostream& out, RecorderFormat format,
+    const FlightRecord* first, size_t n1, const FlightRecord* second, 
+    size_t n2) {
+  const size_t n = n1 + n2;
+  if (format == RecorderFormat::binary) {
+    const char magic[4] = {'R', 'F', 'L', 'R'};
+    const uint32_t version = 2;
+    const uint32_t record_size = sizeof(FlightRecord);
+    const uint64_t count = n;
+    out.write(magic, 4);
+    out.write(reinterpret_cast<const char*>(&version), 4);
+    out.write(reinterpret_cast<const char*>(&record_size), 4);
+    out.write(reinterpret_cast<const char*>(&count), 8);
+    out.write(reinterpret_cast<const char*>(first), 
+      n1 * sizeof(FlightRecord));
+    out.write(reinterpret_cast<const char*>(second), 
+      n2 * sizeof(FlightRecord));
+    return (bool) out;
+  }
+
+  out << "t,t1,t2,t3,v1,v2,v3,u1,u2,u3,tau1,tau2,tau3,sequence,period_ms,"
+    "command_age_ms,input_t,input_t1,input_t2,input_t3,c1,c2,c3\n";
+  for (size_t i = 0; i < n; ++i) {
+    const auto& r = (i < n1) ? first[i] : second[i - n1];
+    out << std::fixed << std::setprecision(6) << r.t;
+    for (const float* v : {r.joints, r.velocities, r.command, r.torques}) {
+      out << "," << v[0] << "," << v[1] << "," << v[2];
+    }
+    out << "," << r.sequence << "," << r.period_ms << "," << r.command_age_ms;
+    // the inputs of the controller, precise enough to replay them exactly
+    out << std::setprecision(9) << "," << r.input_t;
+    for (const float* v : {r.input_joints, r.control}) {
+      out << "," << v[0] << "," << v[1] << "," << v[2];
+    }
+    out << "\n";
+  }
+  return (bool) out;
+}
+
+size_t FlightRecorder::dumps() const {
+  return dumps_;
+}
+
+std::string FlightRecorder::lastDump() {
+  std::lock_guard<std::mutex> lock(last_dump_mutex_);
+  return last_dump_;
+}
+
+void FlightRecorder::installSignalHandler(int signal) {
+  std::signal(signal, onSignal);
+}
+
+} // end namespace remy_robot_control
@@ -0,0 +1,110 @@
+// remy
+#include <gain_sweep.h>
+
+// std
+#include <algorithm>
+#include <random>
+#include <limits>
+#include <cmath>
+
+namespace remy_robot_control {
+
+namespace {
+
+void setGains(RemyControlSettings& settings, float kp, float q0dot, float w0,
+    float alpha0) {
+  settings.kp = kp;
+  std::fill(settings.q0dot, settings.q0dot + 3, q0dot);
+  settings.damping_w0 = w0;
+  settings.damping_alpha0 = alpha0;
+}
+
+float gridValue(const GainRange& range, int i, int steps) {
+  if (steps <= 1)
+    return (range.min + range.max) / 2;
+  return range.min + (range.max - range.min) * (float) i / (float) (steps - 1);
+}
+
+} // end anonymous namespace
+
+std::vector<RemyControlSettings> gainGrid(const RemyControlSettings& base,
+    const GainSpace& space, int steps) {
+  steps = std::max(steps, 1);
+  std::vector<RemyControlSettings> grid;
+  grid.reserve(steps * steps * steps * steps);
+  for (int a = 0; a < steps; ++a)
+  for (int b = 0; b < steps; ++b)
+  for (int c = 0; c < steps; ++c)
+  for (int d = 0; d < steps; ++d) {
+    RemyControlSettings settings = base;
+    setGains(settings, gridValue(space.kp, a, steps),
+      gridValue(space.q0dot, b, steps), gridValue(space.damping_w0, c, steps),
+      gridValue(space.damping_alpha0, d, steps));
+    grid.push_back(settings);
+  }
+  return grid;
+}
+
+std::vector<RemyControlSettings> randomGains(const RemyControlSettings& base,
+    const GainSpace& space, size_t n, uint32_t seed) {
+  std::mt19937 gen(seed);
+  auto draw = [&gen](const GainRange& range) {
+    return std::uniform_real_distribution<float>(range.min, range.max)(gen);
+  };
+  std::vector<RemyControlSettings> samples(n, base);
+  for (auto& settings : samples) {
+    float kp = draw(space.kp);
+    float q0dot = draw(space.q0dot);
+    float w0 = draw(space.damping_w0);
+    float alpha0 = draw(space.damping_alpha0);
+    setGains(settings, kp, q0dot, w0, alpha0);
+  }
+  return samples;
+}
+
+std::vector<GainSweepEntry> sweepGains(
+    const std::vector<Vector4<float>>& waypoints,
+    const SimulationCase& simulation,
+    const std::vector<RemyControlSettings>& candidates, ThreadPool& pool,
+    double effort_weight) {
+  std::vector<GainSweepEntry> entries(candidates.size());
+  pool.parallelFor(candidates.size(), [&](size_t, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      SimulationCase s = simulation;
+      s.control = candidates[i];
+      entries[i].control = candidates[i];
+      entries[i].result = simulate(waypoints, s);
+      auto& r = entries[i].result;
+      if (!std::isfinite(r.rms_error) || !std::isfinite(r.effort)) { // diverged
+        r.rms_error = r.max_error = r.effort = 
+          std::numeric_limits<double>::infinity();
+      }
+      entries[i].score = r.rms_error + 
+        ((effort_weight > 0) ? effort_weight * r.effort : 0);
+    }
+  });
+
+  // sorted by error, an entry is on the front if it beats the effort of
+  // every entry with less error
+  std::vector<size_t> order(entries.size());
+  for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+  std::sort(order.begin(), order.end(), [&entries](size_t a, size_t b) {
+    const auto& ra = entries[a].result;
+    const auto& rb = entries[b].result;
+    return (ra.rms_error != rb.rms_error) ? ra.rms_error < rb.rms_error :
+      ra.effort < rb.effort;
+  });
+  double best_effort = std::numeric_limits<double>::infinity();
+  for (auto i : order) {
+    entries[i].pareto = entries[i].result.effort < best_effort;
+    best_effort = std::min(best_effort, entries[i].result.effort);
+  }
+
+  std::stable_sort(entries.begin(), entries.end(),
+    [](const GainSweepEntry& a, const GainSweepEntry& b) {
+      return a.score < b.score;
+    });
+  return entries;
+}
+
+} // end namespace remy_robot_control
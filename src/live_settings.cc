@@ -0,0 +1,66 @@
+// remy
+#include <live_settings.h>
+#include <utils.h>
+
+// std
+#include <algorithm>
+#include <fstream>
+
+namespace remy_robot_control {
+
+LiveSettings::LiveSettings(const RemyRobotSettings& robot,
+    const RemyControlSettings& control, const RemySystemSettings& system) :
+  snapshot_(std::unique_ptr<const SettingsSnapshot>(new SettingsSnapshot{
+    robot, control, system, 1, 
+    sharedEncoderTable(system.encoder_resolution)})),
+  version_(1)
+{}
+
+uint64_t LiveSettings::version() const {
+  return read()->version;
+}
+
+uint64_t LiveSettings::publish(const RemyRobotSettings& robot, 
+    const RemyControlSettings& control, const RemySystemSettings& system) {
+  auto encoder_table = sharedEncoderTable(system.encoder_resolution);
+  std::lock_guard<std::mutex> lock(writer_);
+  auto retired = read()->encoder_table;
+  snapshot_.publish(std::unique_ptr<const SettingsSnapshot>(
+    new SettingsSnapshot{robot, control, system, ++version_, 
+    std::move(encoder_table)}));
+  // the old snapshot is freed, so only the loops may still hold its table
+  if (retired && retired != read()->encoder_table)
+    retired_tables_.push_back(std::move(retired));
+  retired_tables_.erase(std::remove_if(retired_tables_.begin(), 
+    retired_tables_.end(), [](const std::shared_ptr<const EncoderTable>& t) {
+      return t.use_count() == 1;
+    }), retired_tables_.end());
+  return version_;
+}
+
+bool LiveSettings::load(const std::string& path) {
+  std::ifstream file(path);
+  if (!file)
+    return false;
+  json j = json::parse(file, nullptr, false);
+  if (j.is_discarded())
+    return false;
+  RemyRobotSettings robot;
+  RemyControlSettings control;
+  RemySystemSettings system;
+  // the parsers throw on missing, mistyped or unknown attributes
+  try {
+    robot = parseRobotSetting(j);
+    control = parseControlSetting(j);
+    system = parseSystemSetting(j);
+  }
+  catch (const std::exception&) {
+    return false;
+  }
+  if (control.frequency <= 0 || system.frequency <= 0)
+    return false;
+  publish(robot, control, system);
+  return true;
+}
+
+} // end namespace remy_robot_control
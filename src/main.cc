@@ -3,32 +3,120 @@
 #include <robot_system.h>
 #include <control.h>
 #include <utils.h>
+#include <trace.h>
+#include <live_settings.h>
 
 // std
+#include <cstdlib>
+#include <cmath>
 #include <fstream>
+#include <iostream>
+#include <sys/stat.h>
 
 // 3rdparty
 #include <json.hpp>
 
 using json = nlohmann::json;
 
+/** \return last modification of a file, 0 if it cannot be read */
+static time_t modificationTime(const char* path) {
+  struct stat info;
+  return (stat(path, &info) == 0) ? info.st_mtime : 0;
+}
+
 int main(int argc, char **argv) {
-  assert(argc == 3);
+  if (argc != 3 && argc != 4) {
+    std::cerr << "usage: " << argv[0] << " <path_to_input> <path_to_config>"
+      " [path_to_reachability_map]\n";
+    return 1;
+  }
   
   remy_robot_control::Control control(argv[1]);
   remy_robot_control::RobotSystem system;
 
-  std::ifstream i(argv[2]);
-  json j;
-  i >> j;
+  if (argc == 4) {
+    std::shared_ptr<const remy_robot_control::ReachabilityMap> map = 
+      remy_robot_control::ReachabilityMap::load(argv[3]);
+    if (!map) {
+      std::cerr << "invalid reachability map: " << argv[3] << "\n";
+      return 1;
+    }
+    control.setReachabilityMap(map);
+    for (auto i : control.unreachableWaypoints()) {
+      std::cerr << "warning: waypoint " << i << " is not reachable\n";
+    }
+  }
+
+  remy_robot_control::RemyRobotSettings robot_settings;
+  remy_robot_control::RemyControlSettings control_settings;
+  remy_robot_control::RemySystemSettings system_settings;
+  try {
+    std::ifstream i(argv[2]);
+    json j;
+    i >> j;
+    robot_settings = remy_robot_control::parseRobotSetting(j);
+    control_settings = remy_robot_control::parseControlSetting(j);
+    system_settings = remy_robot_control::parseSystemSetting(j);
+  }
+  catch (const std::exception& e) {
+    std::cerr << "invalid configuration " << argv[2] << ": " << e.what() << 
+      "\n";
+    return 1;
+  }
   
-  control.setSettings(remy_robot_control::parseControlSetting(j));
-  control.setRobotSettings(remy_robot_control::parseRobotSetting(j));
+  control.setSettings(control_settings);
+  control.setRobotSettings(robot_settings);
+  const auto& retiming = control.getRetiming();
+  if (retiming.solved) {
+    std::cout << "retimed to the joint limits: " << retiming.duration << 
+      " s (input " << retiming.input_duration << " s, at " << 
+      retiming.input_velocity_ratio << " of the joint speed limits)\n";
+  }
   
-  system.setSettings(remy_robot_control::parseSystemSetting(j));
-  system.setRobotSettings(remy_robot_control::parseRobotSetting(j));
+  system.setSettings(system_settings);
+  system.setRobotSettings(robot_settings);
+
+  // the loops follow the configuration file: it is parsed again here when
+  // it changes, and they apply it at their next tick
+  auto live = std::make_shared<remy_robot_control::LiveSettings>(
+    robot_settings, control_settings, system_settings);
+  control.setLiveSettings(live);
+  system.setLiveSettings(live);
 
+  // REMY_TRACE=<path> writes a Chrome trace of the loops at the end
+  const char* trace_path = std::getenv("REMY_TRACE");
+  auto& tracer = remy_robot_control::Tracer::instance();
+  tracer.enable(trace_path != nullptr);
+
+  // kill -USR1 <pid> dumps the flight recorder
+  remy_robot_control::FlightRecorder::installSignalHandler(SIGUSR1);
   system.start(control.connection);
   control.start(system.connection);
-  std::this_thread::sleep_for(std::chrono::milliseconds(11000));
+  // the whole trajectory, then one more second
+  auto waypoints = control.getWaypoints();
+  const float duration = waypoints.empty() ? 10 : waypoints.back()[3];
+  const auto end = std::chrono::steady_clock::now() + 
+    std::chrono::milliseconds((int) std::ceil(1000 * (duration + 1)));
+  time_t config_time = modificationTime(argv[2]);
+  while (std::chrono::steady_clock::now() < end) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    const time_t t = modificationTime(argv[2]);
+    if (t == config_time)
+      continue;
+    config_time = t;
+    if (live->load(argv[2]))
+      std::cout << "configuration reloaded (version " << live->version() << 
+        ")\n";
+    else
+      std::cerr << "invalid configuration " << argv[2] << ", version " << 
+        live->version() << " kept\n";
+  }
+
+  if (trace_path) {
+    tracer.enable(false);
+    if (!tracer.exportChrome(std::string(trace_path)))
+      std::cerr << "cannot write the trace " << trace_path << "\n";
+    else if (tracer.dropped() > 0)
+      std::cerr << "warning: " << tracer.dropped() << " trace events dropped\n";
+  }
 }
\ No newline at end of file
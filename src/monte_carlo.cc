@@ -0,0 +1,91 @@
+// remy
+#include <monte_carlo.h>
+
+// std
+#include <algorithm>
+#include <random>
+#include <cmath>
+
+namespace remy_robot_control {
+
+void drawMonteCarloRun(const std::vector<Vector4<float>>& waypoints,
+    const SimulationCase& base, const MonteCarloSettings& settings, size_t i,
+    SimulationCase& simulation, std::vector<Vector4<float>>& noisy_waypoints) {
+  std::mt19937 gen(settings.seed + (uint32_t) i);
+  auto uniform_int = [&gen](const int range[2]) {
+    return std::uniform_int_distribution<int>(range[0],
+      std::max(range[0], range[1]))(gen);
+  };
+  simulation = base;
+  simulation.seed = gen();
+  simulation.system.encoder_resolution =
+    uniform_int(settings.encoder_resolution);
+  simulation.control.frequency = uniform_int(settings.control_frequency);
+  simulation.jitter = std::uniform_real_distribution<double>(
+    settings.jitter[0], std::max(settings.jitter[0], settings.jitter[1]))(gen);
+
+  // (normal distributions need a positive std deviation)
+  noisy_waypoints = waypoints;
+  if (settings.initial_joints_sigma > 0) {
+    std::normal_distribution<float> noise(0, settings.initial_joints_sigma);
+    for (int j = 0; j < 3; ++j) {
+      simulation.initial_joints[j] = base.initial_joints[j] + noise(gen);
+    }
+  }
+  if (settings.waypoint_sigma > 0) {
+    std::normal_distribution<float> noise(0, settings.waypoint_sigma);
+    for (auto& w : noisy_waypoints) {
+      for (int j = 0; j < 3; ++j) {
+        w[j] += noise(gen);
+      }
+    }
+  }
+}
+
+MonteCarloSummary runMonteCarlo(const std::vector<Vector4<float>>& waypoints,
+    const SimulationCase& base, const MonteCarloSettings& settings,
+    ThreadPool& pool, std::ostream* out) {
+  MonteCarloSummary summary;
+  if (out) {
+    *out << "run,encoder_resolution,control_frequency,jitter,rms_error,"
+      "max_error,effort,saturations\n";
+  }
+  const size_t batch = std::max<size_t>(settings.batch, 1);
+  std::vector<MonteCarloRun> runs(std::min(batch, settings.runs));
+  for (size_t first = 0; first < settings.runs; first += batch) {
+    const size_t n = std::min(batch, settings.runs - first);
+    pool.parallelFor(n, [&](size_t, size_t begin, size_t end) {
+      std::vector<Vector4<float>> noisy_waypoints;
+      for (size_t i = begin; i < end; ++i) {
+        auto& run = runs[i];
+        run.index = first + i;
+        drawMonteCarloRun(waypoints, base, settings, run.index,
+          run.simulation, noisy_waypoints);
+        run.result = simulate(noisy_waypoints, run.simulation);
+      }
+    });
+
+    for (size_t i = 0; i < n; ++i) {
+      const auto& run = runs[i];
+      const auto& r = run.result;
+      ++summary.runs;
+      if (out) {
+        *out << run.index << "," << run.simulation.system.encoder_resolution
+          << "," << run.simulation.control.frequency << ","
+          << run.simulation.jitter << "," << r.rms_error << ","
+          << r.max_error << "," << r.effort << "," << r.saturations << "\n";
+      }
+      if (!std::isfinite(r.rms_error) || !std::isfinite(r.max_error)) {
+        ++summary.diverged;
+        continue;
+      }
+      summary.rms_error.add(r.rms_error);
+      summary.max_error.add(r.max_error);
+      summary.saturations.add((double) r.saturations);
+      summary.saturated += (r.saturations > 0);
+    }
+  }
+  return summary;
+}
+
+} // end namespace remy_robot_control
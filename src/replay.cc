@@ -0,0 +1,190 @@
+// remy
+#include <replay.h>
+#include <utils.h>
+
+// std
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+namespace remy_robot_control {
+
+namespace {
+
+const size_t kChunk = 4096;
+
+/** It parses n comma separated numbers */
+bool parseCsv(const std::string& line, double* values, int n) {
+  const char* c = line.c_str();
+  for (int i = 0; i < n; ++i) {
+    char* end;
+    values[i] = std::strtod(c, &end);
+    if (end == c)
+      return false;
+    c = (*end == ',') ? end + 1 : end;
+  }
+  return true;
+}
+
+} // end namespace
+
+LogReader::LogReader(const std::string& path) :
+  file(path, std::ios::binary),
+  format_(LogFormat::unknown),
+  remaining(0),
+  chunk_pos(0)
+{
+  char magic[4] = {};
+  if (!file.read(magic, 4))
+    return;
+  if (std::memcmp(magic, "RFLR", 4) == 0) {
+    uint32_t version, record_size;
+    file.read(reinterpret_cast<char*>(&version), 4);
+    file.read(reinterpret_cast<char*>(&record_size), 4);
+    file.read(reinterpret_cast<char*>(&remaining), 8);
+    if (file && version == 2 && record_size == sizeof(FlightRecord)) {
+      format_ = LogFormat::recorder_binary;
+      chunk.reserve(kChunk);
+    }
+    return;
+  }
+
+  file.seekg(0);
+  std::getline(file, line);
+  if (line.compare(0, 8, "t,x,y,z,") == 0)
+    format_ = LogFormat::system_csv;
+  else if (line.compare(0, 11, "t,t1,t2,t3,") == 0)
+    format_ = LogFormat::recorder_csv;
+}
+
+LogFormat LogReader::format() const {
+  return format_;
+}
+
+bool LogReader::next(ReplaySample& sample) {
+  switch (format_) {
+    case LogFormat::recorder_binary: {
+      if (chunk_pos == chunk.size()) {
+        if (remaining == 0)
+          return false;
+        chunk.resize((size_t) std::min<uint64_t>(remaining, kChunk));
+        if (!file.read(reinterpret_cast<char*>(chunk.data()),
+            chunk.size() * sizeof(FlightRecord)))
+          return false;
+        remaining -= chunk.size();
+        chunk_pos = 0;
+      }
+      const FlightRecord& r = chunk[chunk_pos++];
+      sample.t = r.t;
+      sample.joints = Eigen::Vector3f(r.joints);
+      sample.sequence = r.sequence;
+      sample.input_t = r.input_t;
+      sample.input_joints = Eigen::Vector3f(r.input_joints);
+      // the command as the controller sent it, if it is known
+      sample.control = std::isnan(r.input_t) ? Eigen::Vector3f(r.command) :
+        Eigen::Vector3f(r.control);
+      return true;
+    }
+
+    case LogFormat::system_csv: { // t,x,y,z,ux,uy,uz,t1,t2,t3
+      double v[10];
+      if (!std::getline(file, line) || !parseCsv(line, v, 10))
+        return false;
+      sample.t = v[0];
+      sample.control = Eigen::Vector3d(v[4], v[5], v[6]).cast<float>();
+      sample.joints = Eigen::Vector3d(v[7], v[8], v[9]).cast<float>();
+      sample.sequence = 0;
+      sample.input_t = std::numeric_limits<double>::quiet_NaN();
+      return true;
+    }
+
+    // t,t1..3,v1..3,u1..3,tau1..3,sequence,period_ms,command_age_ms,
+    // input_t,input_t1..3,c1..3
+    case LogFormat::recorder_csv: {
+      double v[23];
+      if (!std::getline(file, line) || !parseCsv(line, v, 23))
+        return false;
+      sample.t = v[0];
+      sample.joints = Eigen::Vector3d(v[1], v[2], v[3]).cast<float>();
+      sample.sequence = (uint64_t) v[13];
+      sample.input_t = v[16];
+      sample.input_joints = Eigen::Vector3d(v[17], v[18], v[19]).cast<float>();
+      sample.control = std::isnan(v[16]) ? 
+        Eigen::Vector3d(v[7], v[8], v[9]).cast<float>() :
+        Eigen::Vector3d(v[20], v[21], v[22]).cast<float>();
+      return true;
+    }
+
+    default:
+      return false;
+  }
+}
+
+ReplayResult::ReplayResult() :
+  samples(0),
+  replayed(0),
+  mismatches(0),
+  first_mismatch(std::numeric_limits<double>::quiet_NaN()),
+  wall_seconds(0) {}
+
+template <class T>
+ReplayResult replay(LogReader& log, ControlT<T>& control,
+    const ReplaySettings& settings, std::ostream* out) {
+  ReplayResult result;
+  if (out) {
+    *out << "t,t1,t2,t3,recorded_u1,recorded_u2,recorded_u3,u1,u2,u3,"
+      "difference\n";
+  }
+  auto start = std::chrono::steady_clock::now();
+  ReplaySample previous, sample;
+  bool has_previous = false;
+  while (log.next(sample)) {
+    ++result.samples;
+    const ReplaySample* input = &sample;
+    const bool recorded_inputs = !std::isnan(sample.input_t);
+    if (settings.mode == ReplayMode::on_change) {
+      bool changed = has_previous && (sample.sequence != previous.sequence ||
+        sample.control != previous.control);
+      if (!changed) {
+        previous = sample;
+        has_previous = true;
+        continue;
+      }
+      input = &previous;
+    }
+
+    // the joints the controller decoded are already quantized
+    Eigen::Vector3f q = recorded_inputs ? sample.input_joints : input->joints;
+    const double t = recorded_inputs ? sample.input_t : input->t;
+    if (settings.encoder_resolution > 0 && !recorded_inputs)
+      mockEncoderPrecisionLost(q, settings.encoder_resolution);
+    control.computeVelocityControl(q.cast<T>(), (T) t);
+    Eigen::Vector3f u = control.getControlSignal().template cast<float>();
+    const double d = (u - sample.control).norm();
+    ++result.replayed;
+    result.difference.add(d);
+    if (!(d <= (double) settings.tolerance) && result.mismatches++ == 0)
+      result.first_mismatch = sample.t;
+    if (out) {
+      *out << t << "," << q[0] << "," << q[1] << "," << q[2] << ","
+        << sample.control[0] << "," << sample.control[1] << ","
+        << sample.control[2] << "," << u[0] << "," << u[1] << "," << u[2]
+        << "," << d << "\n";
+    }
+    previous = sample;
+    has_previous = true;
+  }
+  std::chrono::duration<double> wall = std::chrono::steady_clock::now() -
+    start;
+  result.wall_seconds = wall.count();
+  return result;
+}
+
+template ReplayResult replay(LogReader&, ControlT<float>&,
+  const ReplaySettings&, std::ostream*);
+template ReplayResult replay(LogReader&, ControlT<double>&,
+  const ReplaySettings&, std::ostream*);
+
+} // end namespace remy_robot_control
@@ -0,0 +1,211 @@
+// remy
+#include <retiming.h>
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace remy_robot_control {
+
+namespace {
+
+/** Bounds of the path acceleration \f$\ddot s\f$ at a sample, from
+ * \f$|q' \ddot s + q'' x| \le \ddot q_{max}\f$ with \f$x = \dot s^2\f$
+ * \param lo lower bound, greater than hi if x is not feasible
+ * \param hi upper bound
+ */
+template <class T>
+void accelerationBounds(const Vector3<T>& qp, const Vector3<T>& qpp, T x,
+    const T amax[3], T& lo, T& hi) {
+  const T inf = std::numeric_limits<T>::infinity();
+  lo = - inf;
+  hi = inf;
+  for (int j = 0; j < 3; ++j) {
+    const T bias = qpp[j] * x;
+    if (std::abs(qp[j]) <= std::numeric_limits<T>::epsilon()) {
+      if (std::abs(bias) > amax[j]) {
+        lo = inf;
+        hi = - inf;
+        return;
+      }
+      continue;
+    }
+    T a = (- amax[j] - bias) / qp[j];
+    T b = (amax[j] - bias) / qp[j];
+    if (a > b)
+      std::swap(a, b);
+    lo = std::max(lo, a);
+    hi = std::min(hi, b);
+  }
+}
+
+}
+
+template <class T>
+RetimedPathT<T> retime(const std::vector<Vector4<T>>& waypoints,
+    RobotT<T>& robot, const RemyRobotSettings& settings) {
+  typedef remy_robot_control::Vector3<T> Vector3;
+  typedef remy_robot_control::Vector4<T> Vector4;
+  RetimedPathT<T> result;
+  if (waypoints.empty())
+    return result;
+  result.input_duration = waypoints.back()[3];
+
+  const T step = static_cast<T>(settings.retiming_step);
+  T vmax[3];
+  T amax[3];
+  for (int j = 0; j < 3; ++j) {
+    vmax[j] = static_cast<T>(settings.joint_velocity_max[j]);
+    amax[j] = static_cast<T>(settings.joint_acceleration_max[j]);
+    if (!(vmax[j] > 0 && amax[j] > 0))
+      return result;
+  }
+  if (!(step > 0))
+    return result;
+
+  // samples of the path, every step at most; the arm is at rest (stop) at
+  // both ends and at the corners
+  std::vector<Vector3> p(1, waypoints.front().template head<3>());
+  std::vector<bool> stop(1, true);
+  std::vector<T> ds;
+  std::vector<size_t> segment; ///< input segment of each interval
+  Vector3 direction = Vector3::Zero();
+  for (size_t k = 1; k < waypoints.size(); ++k) {
+    const Vector3 a = waypoints[k - 1].template head<3>();
+    const Vector3 b = waypoints[k].template head<3>();
+    const T length = (b - a).norm();
+    if (length <= std::numeric_limits<T>::epsilon())
+      continue;
+    const Vector3 d = (b - a) / length;
+    if (p.size() > 1 && direction.dot(d) < 1 - static_cast<T>(1e-6))
+      stop.back() = true;
+    const size_t m = std::max<size_t>(1, (size_t) std::ceil(length / step));
+    for (size_t i = 1; i <= m; ++i) {
+      p.push_back(a + (b - a) * (static_cast<T>(i) / m));
+      stop.push_back(false);
+      ds.push_back(length / m);
+      segment.push_back(k);
+    }
+    direction = d;
+  }
+  stop.back() = true;
+  const size_t n = p.size();
+
+  // the joint path, unwrapped so that it is continuous
+  std::vector<Vector3> q(n);
+  for (size_t k = 0; k < n; ++k) {
+    q[k] = robot.inverseKinematics(p[k][0], p[k][1], p[k][2]);
+    if (!q[k].allFinite())
+      return result;
+    if (k == 0)
+      continue;
+    for (int j = 0; j < 3; ++j) {
+      q[k][j] += 2 * kPi<T> * std::round((q[k - 1][j] - q[k][j]) /
+        (2 * kPi<T>));
+    }
+  }
+
+  // q' of the intervals, then q' and q'' of the samples; the samples at rest
+  // take the q' of the interval they are seen from
+  std::vector<Vector3> qp_interval(n - 1);
+  for (size_t i = 0; i + 1 < n; ++i) {
+    qp_interval[i] = (q[i + 1] - q[i]) / ds[i];
+  }
+  auto derivatives = [&](size_t k, size_t interval, Vector3& qp,
+      Vector3& qpp) {
+    if (stop[k]) {
+      qp = qp_interval[interval];
+      qpp = Vector3::Zero();
+      return;
+    }
+    qp = (qp_interval[k - 1] + qp_interval[k]) / 2;
+    qpp = (qp_interval[k] - qp_interval[k - 1]) * (2 / (ds[k - 1] + ds[k]));
+  };
+
+  // the largest x = sdot^2 of each sample: the velocity limits, then the
+  // acceleration limits (by bisection, the feasible x are an interval [0, c])
+  std::vector<T> xmax(n, 0);
+  Vector3 qp, qpp;
+  T lo, hi;
+  for (size_t k = 1; k + 1 < n; ++k) {
+    if (stop[k])
+      continue;
+    derivatives(k, k, qp, qpp);
+    T x = std::numeric_limits<T>::infinity();
+    for (int j = 0; j < 3; ++j) {
+      if (std::abs(qp[j]) > std::numeric_limits<T>::epsilon())
+        x = std::min(x, (vmax[j] / qp[j]) * (vmax[j] / qp[j]));
+    }
+    accelerationBounds(qp, qpp, x, amax, lo, hi);
+    if (!(lo <= hi)) {
+      T a = 0;
+      T b = std::isfinite(x) ? x : std::numeric_limits<T>::max();
+      for (int i = 0; i < 64; ++i) {
+        const T c = a + (b - a) / 2;
+        accelerationBounds(qp, qpp, c, amax, lo, hi);
+        (lo <= hi ? a : b) = c;
+      }
+      x = a;
+    }
+    xmax[k] = x;
+  }
+
+  // backward pass: the fastest profile that can still stop at the end
+  std::vector<T> x(n, 0);
+  for (size_t k = n - 1; k-- > 0; ) {
+    derivatives(k + 1, k, qp, qpp);
+    accelerationBounds(qp, qpp, x[k + 1], amax, lo, hi);
+    x[k] = std::min(xmax[k], std::max<T>(0, x[k + 1] - 2 * ds[k] * lo));
+  }
+  // forward pass: the fastest profile from rest under it
+  x[0] = 0;
+  for (size_t k = 0; k + 1 < n; ++k) {
+    derivatives(k, k, qp, qpp);
+    accelerationBounds(qp, qpp, x[k], amax, lo, hi);
+    x[k + 1] = std::min(x[k + 1], std::max<T>(0, x[k] + 2 * ds[k] * hi));
+  }
+
+  // the times, at constant sddot between samples
+  result.waypoints.reserve(n);
+  T t = 0;
+  result.waypoints.push_back(Vector4(p[0][0], p[0][1], p[0][2], 0));
+  for (size_t k = 0; k + 1 < n; ++k) {
+    const T speed = std::sqrt(x[k]) + std::sqrt(x[k + 1]);
+    if (speed > 0) {
+      t += 2 * ds[k] / speed;
+    }
+    else { // from rest to rest, at the largest sddot
+      derivatives(k, k, qp, qpp);
+      accelerationBounds(qp, qpp, T(0), amax, lo, hi);
+      if (std::isfinite(hi) && hi > 0)
+        t += 2 * std::sqrt(ds[k] / hi);
+    }
+    result.waypoints.push_back(Vector4(p[k + 1][0], p[k + 1][1],
+      p[k + 1][2], t));
+  }
+  result.duration = t;
+
+  // the joint speeds demanded by the input timestamps
+  for (size_t i = 0; i + 1 < n; ++i) {
+    const size_t k = segment[i];
+    const T dt = waypoints[k][3] - waypoints[k - 1][3];
+    const T speed = (waypoints[k] - waypoints[k - 1]).template head<3>().norm()
+      / dt;
+    for (int j = 0; j < 3; ++j) {
+      const T ratio = (dt > 0) ? std::abs(qp_interval[i][j]) * speed / vmax[j] :
+        std::numeric_limits<T>::infinity();
+      result.input_velocity_ratio = std::max(result.input_velocity_ratio,
+        ratio);
+    }
+  }
+  result.solved = true;
+  return result;
+}
+
+template RetimedPathT<float> retime(const std::vector<Vector4<float>>&,
+  RobotT<float>&, const RemyRobotSettings&);
+template RetimedPathT<double> retime(const std::vector<Vector4<double>>&,
+  RobotT<double>&, const RemyRobotSettings&);
+
+} // end namespace remy_robot_control
@@ -1,123 +1,295 @@
 #include <robot.h>
 #include <utils.h>
+#include <trace.h>
+
+// std
+#include <limits>
+#include <random>
+#include <mutex>
 
 namespace remy_robot_control {
 
-Robot::Robot() {
+template <class T>
+RobotT<T>::RobotT() {
   setFk();
   setIk();
-  float q1mM[2] = {- M_PI, M_PI};
-  float q2mM[2] = {- M_PI_2, M_PI_2};
-  float q3mM[2] = {- M_PI, M_PI};
-  joints_ = std::make_unique<RemyJoints>(q1mM, q2mM, q3mM);
+  T q1mM[2] = {- kPi<T>, kPi<T>};
+  T q2mM[2] = {- kPi_2<T>, kPi_2<T>};
+  T q3mM[2] = {- kPi<T>, kPi<T>};
+  joints_ = std::make_unique<RemyJointsT<T>>(q1mM, q2mM, q3mM);
+  reach_policy_ = ReachPolicy::project;
+  random_seeds_ = 4;
+  setReach();
 }
 
-Robot::Robot(float q1, float q2, float q3) : Robot() {
+template <class T>
+RobotT<T>::RobotT(T q1, T q2, T q3) : RobotT() {
   joints_->q1(q1);
   joints_->q1(q2);
   joints_->q1(q3);
 }
 
-void Robot::setSettings(const RemyRobotSettings& settings) {
+template <class T>
+void RobotT<T>::setSettings(const RemyRobotSettings& settings) {
+  updateSettings(settings);
+  const size_t capacity = (size_t) std::max(settings.ik_cache_capacity, 1);
+  if (settings.ik_cache_resolution <= 0)
+    ik_cache_.reset();
+  else if (!ik_cache_ || ik_cache_->resolution() != 
+      static_cast<T>(settings.ik_cache_resolution) || 
+      ik_cache_->capacity() != capacity)
+    ik_cache_ = std::make_shared<IkCacheT<T>>(settings.ik_cache_resolution,
+      capacity);
+}
+
+template <class T>
+void RobotT<T>::updateSettings(const RemyRobotSettings& settings) {
   setFk(settings.fktype);
   setIk(settings.iktype);
-  float q1mM[2] = {settings.joints_min[0], settings.joints_max[0]};
-  float q2mM[2] = {settings.joints_min[1], settings.joints_max[1]};
-  float q3mM[2] = {settings.joints_min[2], settings.joints_max[2]};
-  joints_ = std::make_unique<RemyJoints>(q1mM, q2mM, q3mM);
+  // in place: the joints keep their values, within the new limits
+  joints_->q1.setLimits(settings.joints_min[0], settings.joints_max[0]);
+  joints_->q2.setLimits(settings.joints_min[1], settings.joints_max[1]);
+  joints_->q3.setLimits(settings.joints_min[2], settings.joints_max[2]);
+  reach_policy_ = settings.reach_policy;
+  setReach();
+  if (ik_cache_)
+    ik_cache_->clear(); // the solutions may not hold with the new settings
+}
+
+template <class T>
+void RobotT<T>::setReach() {
+  // distance from the shoulder to the end-effector: d^2 = 50 + 50 cos(t3)
+  T q3min = joints_->q3.min();
+  T q3max = joints_->q3.max();
+  T cmax = (q3min <= 0 && q3max >= 0) ? 1 :
+    std::max(std::cos(q3min), std::cos(q3max));
+  T cmin = (q3min <= - kPi<T> || q3max >= kPi<T>) ? -1 :
+    std::min(std::cos(q3min), std::cos(q3max));
+  reach_min_ = std::sqrt(std::max<T>(0, 50 + 50 * cmin));
+  reach_max_ = std::sqrt(std::max<T>(0, 50 + 50 * cmax));
+}
+
+template <class T>
+void RobotT<T>::setReachPolicy(ReachPolicy policy) {
+  reach_policy_ = policy;
+}
+
+template <class T>
+void RobotT<T>::setReachabilityMap(
+    std::shared_ptr<const ReachabilityMap> map) {
+  reachability_ = map;
+}
+
+template <class T>
+bool RobotT<T>::isReachable(T x, T y, T z) {
+  const T tol = static_cast<T>(1e-4);
+  T a = std::sqrt(x * x + y * y) - 10;
+  T d = std::sqrt(a * a + z * z);
+  if (!(d >= reach_min_ - tol && d <= reach_max_ + tol))
+    return false;
+  Vector3 qmin(joints_->q1.min(), joints_->q2.min(), joints_->q3.min());
+  Vector3 qmax(joints_->q1.max(), joints_->q2.max(), joints_->q3.max());
+  if (!withinLimits(x, y, z, qmin, qmax))
+    return false;
+  if (reachability_ && !reachability_->isReachable((float) x, (float) y, 
+      (float) z))
+    return false;
+  return true;
+}
+
+template <class T>
+bool RobotT<T>::withinLimits(T x, T y, T z, const Vector3& qmin, 
+    const Vector3& qmax) {
+  const T tol = static_cast<T>(1e-4);
+  const T tiny = std::numeric_limits<T>::min();
+  // tol is a distance: an angle moves the end-effector by its lever arm
+  auto within = [&](int j, T q, T arm) {
+    T slack = tol + tol / std::max(arm, tiny);
+    return q >= qmin[j] - slack && q <= qmax[j] + slack;
+  };
+  T rho = std::sqrt(x * x + y * y);
+  if (!within(0, std::atan2(y, x), rho))
+    return false;
+  T a = rho - 10;
+  T d = std::sqrt(a * a + z * z);
+  T c3 = std::min(std::max((d * d - 50) / 50, T(-1)), T(1));
+  T q3 = std::acos(c3);
+  T phi = std::atan2(z, a);
+  // the elbow solutions of analyticalIKBranches
+  for (T s : {T(1), T(-1)}) {
+    if (within(2, s * q3, 5) && within(1, wrapToPi(phi - s * q3 / 2), d))
+      return true;
+  }
+  return false;
+}
+
+template <class T>
+Vector3<T> RobotT<T>::projectToReach(const Vector3& p) {
+  T q1 = std::atan2(p[1], p[0]);
+  Vector3 shoulder(10 * std::cos(q1), 10 * std::sin(q1), 0);
+  Vector3 r = p - shoulder;
+  T d = r.norm();
+  if (d >= reach_min_ && d <= reach_max_)
+    return p;
+  if (d <= std::numeric_limits<T>::epsilon()) // any direction will do
+    return shoulder + Vector3(std::cos(q1), std::sin(q1), 0) * reach_min_;
+  T target = std::min(std::max(d, reach_min_), reach_max_);
+  return shoulder + r * (target / d);
 }
 
-void Robot::setFk(FkType type) {
+template <class T>
+void RobotT<T>::setFk(FkType type) {
   switch (type)
   {
     case FkType::fast:
-      fk_ = [this](const Eigen::Vector3f& joints) {
+      fk_ = [this](const Vector3& joints) {
         return fastForwardKinematics(joints);
       };
       break;
-    
+
     case FkType::generic:
-      fk_ = [this](const Eigen::Vector3f& joints) {
+      fk_ = [this](const Vector3& joints) {
         return forwardKinematicsGeneric(joints);
       };
       break;
   }
 }
 
-void Robot::setIk(IkType type) {
+template <class T>
+void RobotT<T>::setIk(IkType type) {
   switch (type)
   {
     case IkType::transpose:
-      ik_ = [this](float x, float y, float z) {
-        return jacobTransposeIK(x, y, z);
+      ik_ = [this](T x, T y, T z, const Vector3& q0) {
+        return jacobTransposeIK(x, y, z, q0);
       };
       break;
 
     case IkType::damped:
-      ik_ = [this](float x, float y, float z) {
-        return dampedIK(x, y, z);
+      ik_ = [this](T x, T y, T z, const Vector3& q0) {
+        return dampedIK(x, y, z, q0);
       };
       break;
-    
+
     case IkType::analytical:
-      ik_ = [this](float x, float y, float z) {
+      ik_ = [this](T x, T y, T z, const Vector3&) {
         return analyticalIK(x, y, z);
       };
       break;
+
+    case IkType::multistart:
+      ik_ = [this](T x, T y, T z, const Vector3& q0) {
+        return multiStartIK(x, y, z, q0);
+      };
+      break;
   }
 }
 
-Eigen::Vector3f Robot::forwardKinematics(const Eigen::Vector3f& joints) {
+template <class T>
+void RobotT<T>::setThreadPool(std::shared_ptr<ThreadPool> pool) {
+  pool_ = pool;
+}
+
+template <class T>
+void RobotT<T>::setIkCache(std::shared_ptr<IkCacheT<T>> cache) {
+  ik_cache_ = cache;
+}
+
+template <class T>
+std::shared_ptr<IkCacheT<T>> RobotT<T>::getIkCache() const {
+  return ik_cache_;
+}
+
+template <class T>
+void RobotT<T>::setMultiStartSeeds(size_t seeds) {
+  random_seeds_ = seeds;
+}
+
+template <class T>
+Vector3<T> RobotT<T>::forwardKinematics(const Vector3& joints) {
   return fk_(joints);
 }
 
-Eigen::Vector3f Robot::inverseKinematics(float x, float y, float z) {
-  return ik_(x, y, z);
+template <class T>
+Vector3<T> RobotT<T>::inverseKinematics(T x, T y, T z) {
+  REMY_TRACE_ZONE("ik");
+  if (reach_policy_ == ReachPolicy::none || isReachable(x, y, z))
+    return solveIK({x, y, z});
+
+  if (reach_policy_ == ReachPolicy::project) {
+    Vector3 p = projectToReach({x, y, z});
+    if (isReachable(p[0], p[1], p[2]))
+      return solveIK(p);
+  }
+  return Vector3::Constant(std::numeric_limits<T>::quiet_NaN());
 }
 
-Eigen::Vector3f Robot::forwardKinematicsGeneric(
-    const Eigen::Vector3f& joints) {
-  auto T1 = DHToAffine(joints[0], M_PI_2, 10, 0);
-  auto T2 = DHToAffine(joints[1], 0, 5, 0);
-  auto T3 = DHToAffine(joints[2], 0, 5, 0);
-  Eigen::Vector3f xyz = (T1*T2*T3).translation();
+template <class T>
+Vector3<T> RobotT<T>::solveIK(const Vector3& xs) {
+  if (!ik_cache_)
+    return ik_(xs[0], xs[1], xs[2], Vector3::Zero());
+
+  Vector3 q0;
+  switch (ik_cache_->find(xs[0], xs[1], xs[2], q0)) {
+    case IkCacheHit::exact:
+      return q0;
+    case IkCacheHit::miss:
+      q0 = Vector3::Zero();
+      break;
+    case IkCacheHit::warm:
+      break;
+  }
+  Vector3 q = ik_(xs[0], xs[1], xs[2], q0);
+  if ((forwardKinematics(q) - xs).norm() <= static_cast<T>(1e-3))
+    ik_cache_->insert(xs[0], xs[1], xs[2], q);
+  return q;
+}
+
+template <class T>
+Vector3<T> RobotT<T>::forwardKinematicsGeneric(const Vector3& joints) {
+  auto T1 = DHToAffine<T>(joints[0], kPi_2<T>, 10, 0);
+  auto T2 = DHToAffine<T>(joints[1], 0, 5, 0);
+  auto T3 = DHToAffine<T>(joints[2], 0, 5, 0);
+  Vector3 xyz = (T1*T2*T3).translation();
   return xyz;
 }
 
-Eigen::Vector3f Robot::fastForwardKinematics(
-    const Eigen::Vector3f& joints) {
-  float c1 = cos(joints[0]);
-  float c2 = cos(joints[1]);
-  float c23 = cos(joints[1] + joints[2]);
-  float s1 = sin(joints[0]);
-  float s2 = sin(joints[1]);
-  float s23 = sin(joints[1] + joints[2]);
+template <class T>
+Vector3<T> RobotT<T>::fastForwardKinematics(const Vector3& joints) {
+  T c1 = std::cos(joints[0]);
+  T c2 = std::cos(joints[1]);
+  T c23 = std::cos(joints[1] + joints[2]);
+  T s1 = std::sin(joints[0]);
+  T s2 = std::sin(joints[1]);
+  T s23 = std::sin(joints[1] + joints[2]);
 
-  float x = 5 * c1 * (2 + c2 + c23);
-  float y = 5 * s1 * (2 + c2 + c23);
-  float z = 5 * (s2 + s23);
+  T x = 5 * c1 * (2 + c2 + c23);
+  T y = 5 * s1 * (2 + c2 + c23);
+  T z = 5 * (s2 + s23);
   return {x, y, z};
 }
 
-JacobMP Robot::jacob(const Eigen::Vector3f& joints) {
-  float s1 = sin(joints[0]);
-  float s2 = sin(joints[1]);
-  float c1 = cos(joints[0]);
-  float c2 = cos(joints[1]);
-  float c23 = cos(joints[1] + joints[2]);
-  float s23 = sin(joints[1] + joints[2]);
-  
-  JacobMP m;
+template <class T>
+JacobMPT<T> RobotT<T>::jacob(const Vector3& joints) {
+  T s1 = std::sin(joints[0]);
+  T s2 = std::sin(joints[1]);
+  T c1 = std::cos(joints[0]);
+  T c2 = std::cos(joints[1]);
+  T c23 = std::cos(joints[1] + joints[2]);
+  T s23 = std::sin(joints[1] + joints[2]);
+
+  JacobMPT<T> m;
   m <<  - 5 * s1 * (c23 + c2 + 2), - 5 * c1 * (s23 + s2) , - 5 * s23 * c1,
-        5 * c1 * (c23 + c2 + 2)  , -5 * s1 * (s23 + s2)  , - 5 * s23 * s1, 
+        5 * c1 * (c23 + c2 + 2)  , -5 * s1 * (s23 + s2)  , - 5 * s23 * s1,
         0                        , 5 * (c23 + c2)        , 5 * c23       ;
   return m;
 }
 
-Eigen::Vector3f Robot::jacobTransposeIK(float x, float y, float z, 
-    const Eigen::Vector3f& q0, float error) {
-  Eigen::Vector3f q = q0;
-  Eigen::Vector3f xs = {x, y, z};
+template <class T>
+Vector3<T> RobotT<T>::jacobTransposeIK(T x, T y, T z, const Vector3& q0,
+    T error) {
+  Vector3 q = q0;
+  Vector3 xs = {x, y, z};
   int count = 0;
   while (count < 1e5) {
     auto x_ = forwardKinematics(q);
@@ -127,7 +299,7 @@ Eigen::Vector3f Robot::jacobTransposeIK(float x, float y, float z,
     }
     auto J = jacob(q);
     auto Jt = J.transpose();
-    q += Jt * dx * 0.01; 
+    q += Jt * dx * static_cast<T>(0.01);
     q[0] = joints_->q1(q[0]);
     q[1] = joints_->q1(q[1]);
     q[2] = joints_->q1(q[2]);
@@ -136,10 +308,10 @@ Eigen::Vector3f Robot::jacobTransposeIK(float x, float y, float z,
   return q;
 }
 
-Eigen::Vector3f Robot::dampedIK(float x, float y, float z, 
-    const Eigen::Vector3f& q0, float error) {
-    Eigen::Vector3f q = q0;
-  Eigen::Vector3f xs = {x, y, z};
+template <class T>
+Vector3<T> RobotT<T>::dampedIK(T x, T y, T z, const Vector3& q0, T error) {
+    Vector3 q = q0;
+  Vector3 xs = {x, y, z};
   int count = 0;
   while (count < 1e5) {
     auto x_ = forwardKinematics(q);
@@ -150,8 +322,8 @@ Eigen::Vector3f Robot::dampedIK(float x, float y, float z,
     auto J = jacob(q);
     auto Jt = J.transpose();
     auto JJt = J * Jt;
-    auto L = Eigen::Matrix3f::Identity() * 0.1;
-    q +=  Jt * (JJt + L).inverse() * dx; 
+    auto L = JacobMPT<T>::Identity() * static_cast<T>(0.1);
+    q +=  Jt * (JJt + L).inverse() * dx;
     q[0] = joints_->q1(q[0]);
     q[1] = joints_->q1(q[1]);
     q[2] = joints_->q1(q[2]);
@@ -160,59 +332,195 @@ Eigen::Vector3f Robot::dampedIK(float x, float y, float z,
   return q;
 }
 
-Eigen::Vector3f Robot::analyticalIK(float x, float y, float z)
+template <class T>
+Vector3<T> RobotT<T>::multiStartIK(T x, T y, T z, const Vector3& q0,
+    T error) {
+  const Vector3 xs = {x, y, z};
+  std::vector<Vector3> seeds;
+  seeds.reserve(4 + random_seeds_);
+  seeds.push_back(clampToLimits(q0));
+  for (const auto& q : analyticalIKBranches(x, y, z)) {
+    if (q.allFinite())
+      seeds.push_back(clampToLimits(q));
+  }
+  seeds.push_back(clampToLimits(getJoints()));
+  for (const auto& q : seeds) {
+    if ((xs - forwardKinematics(q)).norm() <= error)
+      return q;
+  }
+
+  // deterministic random seeds, so results do not depend on the call order
+  std::mt19937 gen(1234);
+  const Angle<T>* limits[3] = {&joints_->q1, &joints_->q2, &joints_->q3};
+  for (size_t i = 0; i < random_seeds_; ++i) {
+    Vector3 q;
+    for (int j = 0; j < 3; ++j) {
+      std::uniform_real_distribution<T> d(limits[j]->min(), limits[j]->max());
+      q[j] = d(gen);
+    }
+    seeds.push_back(q);
+  }
+
+  std::atomic<bool> cancel(false);
+  std::mutex mutex;
+  Vector3 best = seeds.front();
+  T best_error = std::numeric_limits<T>::infinity();
+  auto solve = [&](size_t i) {
+    Vector3 q = seeds[i];
+    T e = dampedIKSeed(xs, q, error, cancel);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (best_error <= error) // another seed won
+      return;
+    if (e < best_error) {
+      best_error = e;
+      best = q;
+    }
+    if (e <= error)
+      cancel = true;
+  };
+
+  if (!pool_) {
+    for (size_t i = 0; i < seeds.size() && !cancel; ++i) {
+      solve(i);
+    }
+    return best;
+  }
+  std::vector<std::future<void>> futures;
+  futures.reserve(seeds.size());
+  for (size_t i = 0; i < seeds.size(); ++i) {
+    futures.push_back(pool_->submit([&solve, i] { solve(i); }));
+  }
+  for (auto& future : futures) {
+    future.get();
+  }
+  return best;
+}
+
+template <class T>
+T RobotT<T>::dampedIKSeed(const Vector3& xs, Vector3& q, T error,
+    const std::atomic<bool>& cancel) {
+  const auto L = JacobMPT<T>::Identity() * static_cast<T>(0.1);
+  T e = (xs - forwardKinematics(q)).norm();
+  int count = 0;
+  while (e > error && count < 1e5) {
+    if (cancel.load(std::memory_order_relaxed))
+      break;
+    auto dx = xs - forwardKinematics(q);
+    auto J = jacob(q);
+    auto Jt = J.transpose();
+    q = clampToLimits(q + Jt * (J * Jt + L).inverse() * dx);
+    e = (xs - forwardKinematics(q)).norm();
+    ++count;
+  }
+  return e;
+}
+
+template <class T>
+Vector3<T> RobotT<T>::clampToLimits(const Vector3& joints) const {
+  return {wrapAndClamp(joints[0], joints_->q1.min(), joints_->q1.max()),
+          wrapAndClamp(joints[1], joints_->q2.min(), joints_->q2.max()),
+          wrapAndClamp(joints[2], joints_->q3.min(), joints_->q3.max())};
+}
+
+template <class T>
+Vector3<T> RobotT<T>::analyticalIK(T x, T y, T z)
 {
-  Eigen::Vector3f q;
-  
+  Vector3 q;
+
   // By the fast fk, we have:
   // float x = 5 * c1 * (2 + c2 + c23); [1]
   // float y = 5 * s1 * (2 + c2 + c23); [2]
   // float z = 5 * (s2 + s23); [3]
-  // applying [2] / [1], we get theta1 = atan2(y, x). Note that we can only do 
+  // applying [2] / [1], we get theta1 = atan2(y, x). Note that we can only do
   // that if (2 + c2 + c23) != 0, i.e., theta2 != - pi, and theta3 != 0 (singularity)
   // but that is always the case since -pi/2 < theta2 < pi/2
-  q[0] = atan2(y, x);
+  q[0] = std::atan2(y, x);
 
-  // Now theta2 and theta3 can be find by algebric manipulation of z and x 
+  // Now theta2 and theta3 can be find by algebric manipulation of z and x
   // equations or by using other approaches like Paden-Kahan Subproblems.
   // To solve it, we can do: [2]^2 + [3]^2 * (c1^2) to get:
   // q[2] = acos(0.5 * (2 + (1 / (25 * c1s)) * (xs + zs * c1s) - 4 * x / (5 * c1)));
   // but we should check cos(theta1) consistency first
-  
-  float c1 = cos(q[0]);
-  float zs = z * z;
-  float c1s = c1 * c1;
-  float xs = x * x;
-  
-  if (abs(c1s) <= 1e-5) { // x ~= 0
-    q[2] = acos(0.5 * (2 + (zs / (25))));
-    float c3 = cos(q[2]);
-    float s3 = sin(q[2]);
-    q[1] =  asin((1 / (2 + 2 * c3)) * (z * (1 + c3) / 5 + 2 * s3));
+
+  T c1 = std::cos(q[0]);
+  T zs = z * z;
+  T c1s = c1 * c1;
+  T xs = x * x;
+  const T half = static_cast<T>(0.5);
+
+  if (std::abs(c1s) <= static_cast<T>(1e-5)) { // x ~= 0
+    q[2] = std::acos(half * (2 + (zs / (25))));
+    T c3 = std::cos(q[2]);
+    T s3 = std::sin(q[2]);
+    q[1] =  std::asin((1 / (2 + 2 * c3)) * (z * (1 + c3) / 5 + 2 * s3));
   }
   else {
-    q[2] = acos(0.5 * (2 + (1 / (25 * c1s)) * (xs + zs * c1s) - 4 * x / (5 * c1)));
-    float c3 = cos(q[2]);
-    float s3 = sin(q[2]);
-    q[1] = asin((1 / (2 + 2 * c3)) * (z * (1 + c3) / 5 - x * s3 / (5 * c1) + 
+    q[2] = std::acos(half * (2 + (1 / (25 * c1s)) * (xs + zs * c1s) -
+      4 * x / (5 * c1)));
+    T c3 = std::cos(q[2]);
+    T s3 = std::sin(q[2]);
+    q[1] = std::asin((1 / (2 + 2 * c3)) * (z * (1 + c3) / 5 - x * s3 / (5 * c1) +
       2 * s3));
   }
   return q;
 }
 
-Eigen::Vector3f Robot::getJoints() {
-  Eigen::Vector3f joints;
+template <class T>
+std::array<Vector3<T>, 2> RobotT<T>::analyticalIKBranches(T x, T y, T z) {
+  T q1 = std::atan2(y, x);
+  T a = std::sqrt(x * x + y * y) - 10;
+  T c3 = (a * a + z * z - 50) / 50;
+  T s3s = 1 - c3 * c3;
+  // rounding at the boundary of the workspace
+  if (s3s < 0 && s3s > - 8 * std::numeric_limits<T>::epsilon())
+    s3s = 0;
+  T s3 = std::sqrt(s3s); // NaN when out of reach
+  T phi = std::atan2(z, a);
+
+  std::array<Vector3, 2> q;
+  for (int i = 0; i < 2; ++i) {
+    T s = (i == 0) ? s3 : - s3;
+    q[i][0] = q1;
+    q[i][1] = wrapToPi(phi - std::atan2(5 * s, 5 + 5 * c3));
+    q[i][2] = std::atan2(s, c3);
+  }
+  return q;
+}
+
+template <class T>
+bool RobotT<T>::withinLimits(const Vector3& joints) const {
+  const Angle<T>* q[3] = {&joints_->q1, &joints_->q2, &joints_->q3};
+  for (int i = 0; i < 3; ++i) {
+    if (!(joints[i] >= q[i]->min() && joints[i] <= q[i]->max()))
+      return false;
+  }
+  return true;
+}
+
+template <class T>
+Vector3<T> RobotT<T>::getJoints() {
+  Vector3 joints;
   joints[0] = joints_->q1();
   joints[1] = joints_->q2();
   joints[2] = joints_->q3();
   return joints;
 }
 
-void Robot::update(const Eigen::Vector3f& u, float dt) {
-  joints_->q1 += u[0] * dt; 
-  joints_->q2 += u[1] * dt; 
-  joints_->q3 += u[2] * dt; 
+template <class T>
+void RobotT<T>::setJoints(const Vector3& joints) {
+  joints_->q1(joints[0]);
+  joints_->q2(joints[1]);
+  joints_->q3(joints[2]);
 }
 
-} // end namespace remy_robot_cotrol
+template <class T>
+void RobotT<T>::update(const Vector3& u, T dt) {
+  joints_->q1 += u[0] * dt;
+  joints_->q2 += u[1] * dt;
+  joints_->q3 += u[2] * dt;
+}
 
+template class RobotT<float>;
+template class RobotT<double>;
+
+} // end namespace remy_robot_cotrol
@@ -1,17 +1,102 @@
 #include <robot_system.h>
 #include <utils.h>
+#include <trace.h>
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace remy_robot_control {
 
+static std::shared_ptr<FlightRecorder> makeRecorder(
+    const RemySystemSettings& settings) {
+  if (settings.recorder_seconds <= 0)
+    return nullptr;
+  return std::make_shared<FlightRecorder>(
+    (size_t) std::ceil(settings.recorder_seconds * settings.frequency), 
+    settings.recorder_prefix, settings.recorder_format);
+}
+
+/** The loop of main as a state machine of a Scheduler: it waits for the
+ * controller to open, then it ticks at a fixed rate */
+class RobotSystem::LoopTask : public ScheduledTask {
+  RobotSystem& system;
+  std::weak_ptr<Connection> con;
+  bool opened;
+  uint64_t last_sequence;
+  Clock::time_point wake;
+
+  public:
+    LoopTask(RobotSystem& owner, std::weak_ptr<Connection> controller) :
+      system(owner), con(controller), opened(false), last_sequence(0) {}
+
+    Clock::time_point resume(Clock::time_point now) override {
+      auto conn = con.lock();
+      if (!opened) {
+        if (!conn)
+          return finish();
+        // woken up as soon as the controller opens
+        if (!conn->isOpened())
+          return now + std::chrono::milliseconds(1);
+        system.resetClock();
+        opened = true;
+        wake = now;
+      }
+      if (!conn || !conn->isOpened())
+        return finish();
+      system.tick(*conn, last_sequence);
+      // the rate does not drift with the time spent in the tick, but after
+      // a stall it starts again from now, instead of a burst of late ticks
+      const auto period = std::chrono::milliseconds(system.sleep_ms);
+      if (wake + period < now)
+        wake = now;
+      wake += period;
+      return wake;
+    }
+
+  private:
+    Clock::time_point finish() {
+      system.connection->close();
+      return finished();
+    }
+};
+
 RobotSystem::RobotSystem() :
   connection(std::make_shared<Connection>()),
+  state(std::make_shared<StateChannel>()),
   stop_(false),
   control_signal(Eigen::Vector3f::Zero()),
   clock(std::chrono::system_clock::now()),
   save_run(true),
   sleep_ms(1),
-  encoder_resolution(4096)
+  encoder_resolution(4096),
+  encoder_output(EncoderOutput::angle),
+  elapsed_time(0),
+  command_timeout_ms(0),
+  stale_commands(0),
+  setpoints_dt(0),
+  setpoints_start(0),
+  clock_offset(std::numeric_limits<double>::infinity()),
+  last_t0(0),
+  actuator_tau(0),
+  joint_velocities(Eigen::Vector3f::Zero()),
+  plant(PlantModel::kinematic),
+  joint_torques(Eigen::Vector3f::Zero()),
+  torque_saturations(0),
+  command_sequence(0),
+  period_ms(0),
+  command_age_ms(0),
+  input_t(std::numeric_limits<double>::quiet_NaN()),
+  input_joints(Eigen::Vector3f::Zero()),
+  input_control(Eigen::Vector3f::Zero()),
+  recorder(makeRecorder(RemySystemSettings())),
+  scheduler(nullptr),
+  settings_version(0)
 {
+  setpoints.reserve(kHorizonMax);
+  joints_message.reserve(kTicksMsgSize);
+  control_message.reserve(kControlMsgMaxSize);
 }
 
 RobotSystem::~RobotSystem(){
@@ -19,67 +104,270 @@ RobotSystem::~RobotSystem(){
 };
 
 void RobotSystem::setSettings(const RemySystemSettings& settings) {
-  sleep_ms = (int)(1000 * (1.0 / (float)settings.frequency));
+  applySettings(settings);
+  recorder = makeRecorder(settings);
+}
+
+void RobotSystem::applySettings(const RemySystemSettings& settings) {
+  sleep_ms = (int)(1000.0 / settings.frequency);
   encoder_resolution = settings.encoder_resolution;
+  encoder_output = settings.encoder_output;
+  command_timeout_ms = settings.command_timeout_ms;
+  integrator = Integrator(settings.integrator, settings.integrator_step);
+  actuator_tau = settings.actuator_tau;
+  plant = settings.plant;
+  dynamics.setSettings(settings.dynamics);
+  velocity_gain = Eigen::Vector3f(settings.dynamics.velocity_gain);
+  torque_max = Eigen::Vector3f(settings.dynamics.torque_max);
+  save_run = settings.save_output;
 }
 
 void RobotSystem::setRobotSettings(const RemyRobotSettings& settings) {
   robot.setSettings(settings);
 }
 
+void RobotSystem::setLiveSettings(
+    std::shared_ptr<const LiveSettings> settings) {
+  live_settings = std::move(settings);
+  settings_version = 0;
+}
+
+void RobotSystem::updateSettings() {
+  if (!live_settings)
+    return;
+  auto snapshot = live_settings->read();
+  if (snapshot->version == settings_version)
+    return;
+  settings_version = snapshot->version;
+  applySettings(snapshot->system);
+  robot.updateSettings(snapshot->robot);
+}
+
 void RobotSystem::start(std::weak_ptr<Connection> con) {
   stop();
   stop_ = false;
   thread = std::thread(&RobotSystem::main, this, con);  
 }
 
+void RobotSystem::start(std::weak_ptr<Connection> con, 
+    Scheduler& scheduler) {
+  stop();
+  connection->open();
+  if (save_run)
+    logger = std::make_unique<SystemLogger>("out.csv");
+  this->scheduler = &scheduler;
+  task = std::make_unique<LoopTask>(*this, con);
+  scheduler.add(task.get());
+}
+
 void RobotSystem::stop() {
   stop_ = true;
-  if (thread.joinable()) thread.join();
+  if (thread.joinable()) {
+    thread.join();
+    if (recorder) {
+      recorder->flush();
+      recorder->dump(DumpReason::stop);
+    }
+  }
+  if (scheduler) {
+    scheduler->remove(task.get());
+    connection->close();
+    scheduler = nullptr;
+    if (recorder) {
+      recorder->flush();
+      recorder->dump(DumpReason::stop);
+    }
+  }
 }
 
 void RobotSystem::main(std::weak_ptr<Connection> con) {
+  REMY_TRACE_THREAD("plant");
   connection->open();
   if (save_run)
     logger = std::make_unique<SystemLogger>("out.csv");
   
+  // woken up as soon as the controller opens
   while(auto conn = con.lock()) {
-    if (!conn->isOpened()) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(1));
-    }
-    else break;
+    if (stop_ || conn->waitOpened(std::chrono::milliseconds(1))) break;
   }
 
-  clock = std::chrono::system_clock::now();
-  double elapsed_time;
+  resetClock();
+  uint64_t last_sequence = 0;
   while(auto conn = con.lock()) {
+    REMY_TRACE_ZONE("plant.loop");
     if (!conn->isOpened()) break;
     if (stop_) {
       break;
     }
-    auto new_clock = std::chrono::system_clock::now();
-    std::chrono::duration<double> diff = new_clock - clock;
-    elapsed_time += diff.count();
-
-    robot.update(control_signal, diff.count());
-    auto q = robot.getJoints();
-    
-    if (save_run) {
-      auto p = robot.forwardKinematics(q);
-      logger->save(p, control_signal, q, elapsed_time);
-    }
-
-    mockEncoderPrecisionLost(q, encoder_resolution);
-    auto qc = eigen3fToUchar3(q);
-    connection->send(qc);
-    
-    std::vector<unsigned char> control;
-    conn->receive(control);
-    control_signal = uchar3ToEigen3f(control);
-    clock = new_clock;
+    tick(*conn, last_sequence);
     std::this_thread::sleep_for(std::chrono::milliseconds(sleep_ms));
   }
   connection->close();
 }
 
+void RobotSystem::tick(Connection& conn, uint64_t& last_sequence) {
+  auto new_clock = std::chrono::system_clock::now();
+  std::chrono::duration<double> diff = new_clock - clock;
+  period_ms = (float) (diff.count() * 1000);
+  {
+    REMY_TRACE_ZONE("plant.step");
+    step(diff.count(), joints_message);
+  }
+  connection->send(joints_message);
+  
+  // the plant keeps its rate: it only decodes new commands, and it drops 
+  // the old ones
+  Connection::Clock::time_point stamp;
+  uint64_t sequence = conn.receive(control_message, stamp);
+  if (sequence != last_sequence) {
+    setControl(control_message);
+    last_sequence = sequence;
+    command_sequence = sequence;
+  }
+  const auto age = Connection::Clock::now() - stamp;
+  if (sequence > 0) {
+    command_age_ms = std::chrono::duration<float, std::milli>(age).count();
+  }
+  if (command_timeout_ms > 0 && sequence > 0 && 
+      age > std::chrono::milliseconds(command_timeout_ms)) {
+    control_signal.setZero();
+    setpoints.clear();
+    ++stale_commands;
+    if (recorder) recorder->fault();
+  }
+  clock = new_clock;
+}
+
+std::vector<unsigned char> RobotSystem::step(double dt) {
+  std::vector<unsigned char> message;
+  step(dt, message);
+  return message;
+}
+
+void RobotSystem::step(double dt, std::vector<unsigned char>& message) {
+  updateSettings();
+  const double t0 = elapsed_time;
+  Eigen::Vector3f q = robot.getJoints();
+  if (plant == PlantModel::dynamic) {
+    // velocity loops with gravity compensation, within the torque limits
+    integrator.integrate([&](float t, const Eigen::Vector3f& q, 
+        const Eigen::Vector3f& qd) {
+      joint_torques = (velocity_gain.cwiseProduct(command(t0 + (double) t) - 
+        qd) + dynamics.gravity(q)).cwiseMax(-torque_max).cwiseMin(torque_max);
+      return dynamics.forwardDynamics(q, qd, joint_torques);
+    }, (float) dt, q, joint_velocities);
+    if ((joint_torques.cwiseAbs() - torque_max).maxCoeff() >= 0)
+      ++torque_saturations;
+  }
+  else if (actuator_tau > 0) { // first order velocity loops
+    integrator.integrate([&](float t, const Eigen::Vector3f&, 
+        const Eigen::Vector3f& qd) {
+      return Eigen::Vector3f((command(t0 + (double) t) - qd) / actuator_tau);
+    }, (float) dt, q, joint_velocities);
+  }
+  else {
+    integrator.integrate([&](float t, const Eigen::Vector3f&) {
+      return command(t0 + (double) t);
+    }, (float) dt, q);
+    joint_velocities = command(t0 + dt / 2);
+  }
+  robot.setJoints(q);
+  elapsed_time += dt;
+  q = robot.getJoints();
+  const auto& u = joint_velocities;
+  state->publish({elapsed_time, {q[0], q[1], q[2]}, {u[0], u[1], u[2]}});
+  
+  if (save_run && logger) {
+    auto p = robot.forwardKinematics(q);
+    logger->save(p, u, q, elapsed_time);
+  }
+
+  if (recorder) {
+    const auto c = command(elapsed_time);
+    const auto& tau = joint_torques;
+    const auto& qc = input_joints;
+    const auto& uc = input_control;
+    recorder->record({elapsed_time, {q[0], q[1], q[2]}, {u[0], u[1], u[2]},
+      {c[0], c[1], c[2]}, {tau[0], tau[1], tau[2]}, command_sequence, 
+      period_ms, command_age_ms, input_t, {qc[0], qc[1], qc[2]}, 
+      {uc[0], uc[1], uc[2]}});
+    if (!q.allFinite() || !u.allFinite())
+      recorder->fault();
+    recorder->service();
+  }
+
+  if (encoder_output == EncoderOutput::ticks) {
+    encoderTicksToUchar(jointToEncoder(q, encoder_resolution), 
+      encoder_resolution, message);
+    return;
+  }
+  mockEncoderPrecisionLost(q, encoder_resolution);
+  eigen3fToUchar3(q, message);
+}
+
+void RobotSystem::resetClock() {
+  clock = std::chrono::system_clock::now();
+  elapsed_time = 0;
+  clock_offset = std::numeric_limits<double>::infinity();
+}
+
+Eigen::Vector3f RobotSystem::command(double t) const {
+  if (setpoints.empty())
+    return control_signal;
+  double s = std::max(0., (t - setpoints_start) / (double) setpoints_dt);
+  size_t k = (size_t) s;
+  if (k + 1 >= setpoints.size())
+    return setpoints.back();
+  float a = (float) (s - k);
+  return (1 - a) * setpoints[k] + a * setpoints[k + 1];
+}
+
+Eigen::Vector3f RobotSystem::getJointVelocities() const {
+  return joint_velocities;
+}
+
+Eigen::Vector3f RobotSystem::getJointTorques() const {
+  return joint_torques;
+}
+
+size_t RobotSystem::getTorqueSaturations() const {
+  return torque_saturations;
+}
+
+void RobotSystem::setControl(const std::vector<unsigned char>& control) {
+  if (!ucharToControlInputs(control, input_t, input_joints))
+    input_t = std::numeric_limits<double>::quiet_NaN();
+  float t0;
+  if (ucharToHorizon(control, setpoints, t0, setpoints_dt) && 
+      setpoints_dt > 0) {
+    if (t0 < last_t0)
+      clock_offset = std::numeric_limits<double>::infinity();
+    last_t0 = t0;
+    clock_offset = std::min(clock_offset, elapsed_time - (double) t0);
+    setpoints_start = (double) t0 + clock_offset;
+    control_signal = setpoints.front();
+  }
+  else {
+    setpoints.clear();
+    control_signal = uchar3ToEigen3f(control);
+  }
+  input_control = control_signal;
+}
+
+size_t RobotSystem::getStaleCount() const {
+  return stale_commands;
+}
+
+double RobotSystem::period() const {
+  return sleep_ms / 1000.0;
+}
+
+Eigen::Vector3f RobotSystem::getJoints() {
+  return robot.getJoints();
+}
+
+void RobotSystem::setJoints(const Eigen::Vector3f& joints) {
+  robot.setJoints(joints);
+}
+
 } // end namespace remy_robot_control
\ No newline at end of file
@@ -0,0 +1,157 @@
+// remy
+#include <scheduler.h>
+
+// std
+#include <algorithm>
+
+namespace remy_robot_control {
+
+namespace {
+
+/** Heap order: the earliest (then the first scheduled) on top */
+template <class Entry>
+bool later(const Entry& a, const Entry& b) {
+  return (a.wake != b.wake) ? a.wake > b.wake : a.order > b.order;
+}
+
+} // end namespace
+
+Scheduler::Scheduler() :
+  running_(nullptr),
+  running_removed_(false),
+  running_woken_(false),
+  order_(0),
+  stop_(false),
+  resumes_(0)
+{}
+
+Scheduler::~Scheduler() {
+  stop();
+}
+
+void Scheduler::start() {
+  stop();
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stop_ = false;
+  }
+  thread = std::thread([this] {
+    run(ScheduledTask::Clock::time_point::max());
+  });
+}
+
+void Scheduler::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stop_ = true;
+  }
+  cv.notify_all();
+  if (thread.joinable()) thread.join();
+}
+
+size_t Scheduler::runUntil(ScheduledTask::Clock::time_point deadline) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stop_ = false;
+  }
+  return run(deadline);
+}
+
+void Scheduler::add(ScheduledTask* task, 
+    ScheduledTask::Clock::time_point when) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    queue.push_back({when, order_++, task});
+    std::push_heap(queue.begin(), queue.end(), later<Entry>);
+  }
+  cv.notify_all();
+}
+
+bool Scheduler::remove(ScheduledTask* task) {
+  std::unique_lock<std::mutex> lock(mutex);
+  if (running_ == task) {
+    if (std::this_thread::get_id() == thread_id) {
+      running_removed_ = true;
+      return true;
+    }
+    // it is put back (or not) when it yields
+    cv.wait(lock, [this, task] { return running_ != task; });
+  }
+  auto it = std::find_if(queue.begin(), queue.end(), [task](const Entry& e) {
+    return e.task == task; });
+  if (it == queue.end())
+    return false;
+  queue.erase(it);
+  std::make_heap(queue.begin(), queue.end(), later<Entry>);
+  return true;
+}
+
+bool Scheduler::wake(ScheduledTask* task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running_ == task) {
+      running_woken_ = true;
+    }
+    else {
+      auto it = std::find_if(queue.begin(), queue.end(), 
+        [task](const Entry& e) { return e.task == task; });
+      if (it == queue.end())
+        return false;
+      it->wake = std::min(it->wake, ScheduledTask::Clock::now());
+      std::make_heap(queue.begin(), queue.end(), later<Entry>);
+    }
+  }
+  cv.notify_all();
+  return true;
+}
+
+size_t Scheduler::size() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return queue.size() + (running_ && !running_removed_ ? 1 : 0);
+}
+
+size_t Scheduler::run(ScheduledTask::Clock::time_point deadline) {
+  size_t resumed = 0;
+  std::unique_lock<std::mutex> lock(mutex);
+  thread_id = std::this_thread::get_id();
+  while (!stop_) {
+    auto now = ScheduledTask::Clock::now();
+    if (now >= deadline)
+      break;
+    if (queue.empty() || queue.front().wake > now) {
+      // woken up earlier by add() and stop()
+      auto wake = queue.empty() ? deadline : 
+        std::min(queue.front().wake, deadline);
+      if (wake == ScheduledTask::Clock::time_point::max())
+        cv.wait(lock);
+      else
+        cv.wait_until(lock, wake);
+      continue;
+    }
+
+    std::pop_heap(queue.begin(), queue.end(), later<Entry>);
+    Entry entry = queue.back();
+    queue.pop_back();
+    running_ = entry.task;
+    running_removed_ = false;
+    running_woken_ = false;
+    lock.unlock();
+    auto next = entry.task->resume(now);
+    ++resumed;
+    resumes_.fetch_add(1, std::memory_order_relaxed);
+    lock.lock();
+    if (next != ScheduledTask::finished() && !running_removed_) {
+      if (running_woken_)
+        next = now;
+      // periodic tasks keep their order among the tasks due at once
+      queue.push_back({std::max(next, now), entry.order, entry.task});
+      std::push_heap(queue.begin(), queue.end(), later<Entry>);
+    }
+    running_ = nullptr;
+    cv.notify_all();
+  }
+  thread_id = std::thread::id();
+  return resumed;
+}
+
+} // end namespace remy_robot_control
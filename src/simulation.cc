@@ -0,0 +1,86 @@
+// remy
+#include <simulation.h>
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace remy_robot_control {
+
+RemySystemSettings offlineSettings(const RemySystemSettings& settings) {
+  RemySystemSettings offline = settings;
+  offline.save_output = false;
+  offline.recorder_seconds = 0;
+  return offline;
+}
+
+LockStep::LockStep(Control& controller, RobotSystem& plant) :
+  control(controller),
+  system(plant),
+  control_dt(controller.period()),
+  time_(0),
+  control_steps(0)
+{}
+
+bool LockStep::stepTo(double t) {
+  system.step(t - time_, joints);
+  time_ = t;
+  if (control_steps * control_dt > t + 1e-9)
+    return false;
+  control.step(joints, (float) t, command);
+  system.setControl(command);
+  ++control_steps;
+  return true;
+}
+
+SimulationResult simulate(const std::vector<Vector4<float>>& waypoints,
+    const SimulationCase& simulation) {
+  Control control(waypoints);
+  control.setSettings(simulation.control);
+  control.setRobotSettings(simulation.robot);
+  RobotSystem system;
+  system.setSettings(offlineSettings(simulation.system));
+  system.setRobotSettings(simulation.robot);
+  Robot model;
+  model.setSettings(simulation.robot);
+  Trajectory reference(waypoints);
+  system.setJoints(Eigen::Vector3f(simulation.initial_joints));
+
+  SimulationResult result = {0, 0, 0, 0, 0};
+  double sq_error = 0;
+  const double dt = system.period();
+  const float tol = 1e-6f;
+  std::mt19937 gen(simulation.seed);
+  std::normal_distribution<double> noise(0, (simulation.jitter > 0) ? 
+    simulation.jitter : 1);
+  LockStep pair(control, system);
+  Eigen::Vector3f u = Eigen::Vector3f::Zero();
+  // nominal times are multiples of the periods, so they do not drift
+  for (size_t k = 1; k * dt <= simulation.seconds + 1e-9; ++k) {
+    double t = k * dt;
+    if (simulation.jitter > 0)
+      t = std::max(pair.time(), t + noise(gen));
+    result.effort += (double) u.squaredNorm() * (t - pair.time());
+    if (pair.stepTo(t))
+      u = control.getControlSignal();
+    auto q = system.getJoints();
+    for (int i = 0; i < 3; ++i) {
+      if (q[i] <= simulation.robot.joints_min[i] + tol ||
+          q[i] >= simulation.robot.joints_max[i] - tol) {
+        ++result.saturations;
+        break;
+      }
+    }
+    if (reference.update((float) t)) {
+      double e = (reference.x - model.forwardKinematics(q)).norm();
+      sq_error += e * e;
+      result.max_error = std::max(result.max_error, e);
+      ++result.samples;
+    }
+  }
+  result.rms_error = std::sqrt(sq_error / std::max<size_t>(result.samples, 1));
+  return result;
+}
+
+} // end namespace remy_robot_control
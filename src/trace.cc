@@ -0,0 +1,161 @@
+// remy
+#include <trace.h>
+
+// std
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+namespace remy_robot_control {
+
+namespace detail {
+std::atomic<bool> trace_enabled(false);
+
+/** The buffer of a thread, given back to the tracer when the thread exits */
+struct ThreadBuffer {
+  TraceBuffer* buffer = nullptr;
+  ~ThreadBuffer() {
+    if (buffer)
+      Tracer::instance().release(*buffer);
+  }
+};
+} // end namespace detail
+
+namespace {
+// a thread gets its buffer on its first traced event, so naming a thread
+// allocates nothing while the tracer is off
+thread_local detail::ThreadBuffer thread_buffer;
+thread_local const char* thread_name = nullptr;
+} // end namespace
+
+Tracer::Tracer() :
+  epoch_(std::chrono::steady_clock::now()),
+  capacity_(1 << 16),
+  tids_(0)
+{}
+
+Tracer& Tracer::instance() {
+  static Tracer tracer;
+  return tracer;
+}
+
+void Tracer::setCapacity(size_t events) {
+  std::lock_guard<std::mutex> lock(mutex);
+  capacity_ = events;
+}
+
+void Tracer::setThreadName(const char* name) {
+  thread_name = name;
+  if (thread_buffer.buffer)
+    thread_buffer.buffer->name.store(name, std::memory_order_release);
+}
+
+TraceBuffer& Tracer::buffer() {
+  TraceBuffer*& b = thread_buffer.buffer;
+  if (!b) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto free = std::find_if(free_buffers.begin(), free_buffers.end(),
+      [this](const TraceBuffer* f) { return f->events.size() == capacity_; });
+    if (free != free_buffers.end()) {
+      b = *free;
+      free_buffers.erase(free);
+      b->in_use = true;
+    }
+    else {
+      buffers.push_back(std::make_unique<TraceBuffer>(capacity_, ++tids_));
+      b = buffers.back().get();
+    }
+    b->name.store(thread_name, std::memory_order_release);
+  }
+  return *b;
+}
+
+void Tracer::release(TraceBuffer& buffer) {
+  std::lock_guard<std::mutex> lock(mutex);
+  buffer.in_use = false;
+  // its events are kept until clear()
+  if (buffer.count.load(std::memory_order_relaxed) == 0 && 
+      buffer.dropped.load(std::memory_order_relaxed) == 0) {
+    buffer.name.store(nullptr, std::memory_order_relaxed);
+    free_buffers.push_back(&buffer);
+  }
+}
+
+size_t Tracer::events() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  size_t n = 0;
+  for (const auto& b : buffers) {
+    n += b->count.load(std::memory_order_acquire);
+  }
+  return n;
+}
+
+size_t Tracer::dropped() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  size_t n = 0;
+  for (const auto& b : buffers) {
+    n += b->dropped.load(std::memory_order_relaxed);
+  }
+  return n;
+}
+
+size_t Tracer::bufferCount() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return buffers.size();
+}
+
+void Tracer::clear() {
+  std::lock_guard<std::mutex> lock(mutex);
+  // the buffers of finished threads are freed, or reused if they have the
+  // capacity
+  free_buffers.clear();
+  buffers.erase(std::remove_if(buffers.begin(), buffers.end(), 
+    [this](const std::unique_ptr<TraceBuffer>& b) {
+      return !b->in_use && b->events.size() != capacity_;
+    }), buffers.end());
+  for (auto& b : buffers) {
+    b->count.store(0, std::memory_order_release);
+    b->dropped.store(0, std::memory_order_relaxed);
+    if (!b->in_use) {
+      b->name.store(nullptr, std::memory_order_relaxed);
+      free_buffers.push_back(b.get());
+    }
+  }
+}
+
+bool Tracer::exportChrome(std::ostream& out) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  bool first = true;
+  auto separator = [&out, &first] {
+    if (!first) out << ",";
+    first = false;
+    out << "\n";
+  };
+  out << std::fixed << std::setprecision(3);
+  for (const auto& b : buffers) {
+    if (const char* name = b->name.load(std::memory_order_acquire)) {
+      separator();
+      out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+        << b->tid << ",\"args\":{\"name\":\"" << name << "\"}}";
+    }
+    const size_t n = b->count.load(std::memory_order_acquire);
+    for (size_t i = 0; i < n; ++i) {
+      const TraceEvent& e = b->events[i];
+      separator();
+      // complete events, in microseconds
+      out << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+        << b->tid << ",\"ts\":" << e.begin_ns / 1e3 << ",\"dur\":"
+        << (e.end_ns - e.begin_ns) / 1e3 << "}";
+    }
+  }
+  out << "\n]}\n";
+  return (bool) out;
+}
+
+bool Tracer::exportChrome(const std::string& path) const {
+  std::ofstream file(path);
+  return file && exportChrome(file);
+}
+
+} // end namespace remy_robot_control
@@ -0,0 +1,90 @@
+#include <trajectory.h>
+
+template <class T>
+TrajectoryT<T>::TrajectoryT(const std::vector<Vector4>& waypoints) {
+  const size_t n = waypoints.size();
+  end_.resize(n);
+  for (int j = 0; j < 3; ++j) {
+    xf_[j].resize(n);
+    v_[j].resize(n);
+  }
+  for (size_t k = 0; k < n; ++k) {
+    const T t0 = (k == 0) ? 0 : waypoints[k - 1][3];
+    const T tf = waypoints[k][3];
+    end_[k] = tf;
+    for (int j = 0; j < 3; ++j) {
+      const T x0 = (k == 0) ? 0 : waypoints[k - 1][j];
+      xf_[j][k] = waypoints[k][j];
+      // x(t) = x0 + v(t-t0)
+      // v = (xf - x0) / (tf - t0)
+      v_[j][k] = (tf == t0) ? 0 : (xf_[j][k] - x0) / (tf - t0);
+    }
+  }
+
+  // one bin per segment: bin b starts at the first segment ending in it or
+  // after, by the same bin() as the lookups, so no rounding can skip one
+  const size_t bins = std::max<size_t>(1, n);
+  const T duration = (n > 0) ? end_.back() : 0;
+  bin_scale_ = (duration > 0) ? bins / duration : 0;
+  bins_.resize(bins + 1);
+  size_t k = 0;
+  for (size_t b = 0; b < bins; ++b) {
+    while (k < n && bin(end_[k]) < b) {
+      ++k;
+    }
+    bins_[b] = (uint32_t) k;
+  }
+  bins_[bins] = (uint32_t) n;
+}
+
+template <class T>
+size_t TrajectoryT<T>::bin(T t) const {
+  const size_t last = bins_.size() - 2;
+  if (!(t > 0))
+    return 0;
+  const T b = t * bin_scale_;
+  return (b >= (T) last) ? last : (size_t) b;
+}
+
+template <class T>
+bool TrajectoryT<T>::update(T t) {
+  return sample(t, x, v);
+}
+
+template <class T>
+bool TrajectoryT<T>::sample(T t, Vector3& x, Vector3& v) const {
+  // the first segment ending at t or after is within the bin of t, or it is
+  // the first one of the next bin
+  const size_t b = bin(t);
+  size_t k = bins_[b];
+  const size_t last = bins_[b + 1];
+  if (last - k > 8) {
+    k = std::lower_bound(end_.begin() + k, end_.begin() + last, t) -
+      end_.begin();
+  }
+  else {
+    while (k < last && end_[k] < t) {
+      ++k;
+    }
+  }
+  if (k >= size()) return false;
+
+  for (int j = 0; j < 3; ++j) {
+    v[j] = v_[j][k];
+    x[j] = xf_[j][k] + v_[j][k] * (t - end_[k]);
+  }
+  return true;
+}
+
+template <class T>
+std::vector<Eigen::Matrix<T, 4, 1>> TrajectoryT<T>::getWaypoints() const {
+  std::vector<Vector4> waypoints;
+  waypoints.reserve(size());
+  for (size_t k = 0; k < size(); ++k) {
+    waypoints.push_back(Vector4(xf_[0][k], xf_[1][k], xf_[2][k], end_[k]));
+  }
+  return waypoints;
+}
+
+template class TrajectoryT<float>;
+template class TrajectoryT<double>;
@@ -1,23 +1,28 @@
 #include <utils.h>
 
+// std
+#include <cstring>
+
 namespace remy_robot_control {
 
-Eigen::Affine3f DHToAffine(float theta, float alpha, float link_length, 
-    float offset) {
-  float ct = cos(theta);
-  float st = sin(theta);
-  float ca = cos(alpha);
-  float sa = sin(alpha);
+template <class T>
+Eigen::Transform<T, 3, Eigen::Affine> DHToAffine(T theta, T alpha, 
+    T link_length, T offset) {
+  T ct = std::cos(theta);
+  T st = std::sin(theta);
+  T ca = std::cos(alpha);
+  T sa = std::sin(alpha);
   
-  Eigen::Matrix3f R;
+  Eigen::Matrix<T, 3, 3> R;
   R <<  ct, -st * ca,  st * sa, 
         st,  ct * ca, -ct * sa,
          0,   sa    ,  ca;
-  Eigen::Vector3f v = {link_length * ct, link_length * st, offset};
-  Eigen::Affine3f T = Eigen::Affine3f::Identity();
-  T.linear() = R;
-  T.translation() = v;
-  return T;
+  Vector3<T> v = {link_length * ct, link_length * st, offset};
+  Eigen::Transform<T, 3, Eigen::Affine> T_ = 
+    Eigen::Transform<T, 3, Eigen::Affine>::Identity();
+  T_.linear() = R;
+  T_.translation() = v;
+  return T_;
 }
 
 
@@ -26,10 +31,8 @@ float charToFloat(unsigned char c[4]) {
   return f;
 }
 
-unsigned char* floatToChar(float f) {
-  unsigned char* s = new unsigned char[sizeof(float)];
-  *(float*)(s) = f;
-  return s;
+void floatToChar(float f, unsigned char buffer[4]) {
+  std::memcpy(buffer, &f, sizeof(float));
 }
 
 Eigen::Vector3f uchar3ToEigen3f(const std::vector<unsigned char>& v_uchar) {
@@ -48,51 +51,195 @@ Eigen::Vector3f uchar3ToEigen3f(const std::vector<unsigned char>& v_uchar) {
 
 std::vector<unsigned char> eigen3fToUchar3(const Eigen::Vector3f& vec3) {
   std::vector<unsigned char> v_char;
-  v_char.reserve(12);
-  auto c1 = floatToChar(vec3[0]);
-  auto c2 = floatToChar(vec3[1]);
-  auto c3 = floatToChar(vec3[2]);
-  for (auto c : {c1, c2, c3}) {
-    v_char.push_back(c[0]);
-    v_char.push_back(c[1]);
-    v_char.push_back(c[2]);
-    v_char.push_back(c[3]);
-  }
+  eigen3fToUchar3(vec3, v_char);
   return v_char;
 }
 
-float encoderToJoint(int joint_int) {
-  return 2 * M_PI * joint_int / 4096 - M_PI;
+void eigen3fToUchar3(const Eigen::Vector3f& vec3, 
+    std::vector<unsigned char>& v_char) {
+  v_char.resize(kJointsMsgSize);
+  floatToChar(vec3[0], &v_char[0]);
+  floatToChar(vec3[1], &v_char[4]);
+  floatToChar(vec3[2], &v_char[8]);
+}
+
+template <class T>
+T encoderToJoint(int joint_int, int encoder_resolution) {
+  return 2 * kPi<T> * joint_int / encoder_resolution - kPi<T>;
+}
+
+template <class T>
+int jointToEncoder(T joint, int encoder_resolution) {
+  return (int) (encoder_resolution * (joint + kPi<T>) / (2 * kPi<T>));
 }
 
-void mockEncoderPrecisionLost(float& joint, int encoder_resolution) {
-  int n = (int) (encoder_resolution * (joint + M_PI) / (2 * M_PI));
-  joint = encoderToJoint(n);
+template <class T>
+Eigen::Vector3i jointToEncoder(const Vector3<T>& joints, 
+    int encoder_resolution) {
+  return {jointToEncoder(joints[0], encoder_resolution), 
+    jointToEncoder(joints[1], encoder_resolution),
+    jointToEncoder(joints[2], encoder_resolution)};
 }
 
-void mockEncoderPrecisionLost(Eigen::Vector3f& joints, int encoder_resolution) {
+template <class T>
+void mockEncoderPrecisionLost(T& joint, int encoder_resolution) {
+  joint = encoderToJoint<T>(jointToEncoder(joint, encoder_resolution), 
+    encoder_resolution);
+}
+
+template <class T>
+void mockEncoderPrecisionLost(Vector3<T>& joints, int encoder_resolution) {
   mockEncoderPrecisionLost(joints[0], encoder_resolution);
   mockEncoderPrecisionLost(joints[1], encoder_resolution);
   mockEncoderPrecisionLost(joints[2], encoder_resolution);
 }
 
+static void pushInt32(std::vector<unsigned char>& v, int32_t value) {
+  uint32_t u = (uint32_t) value;
+  v.push_back(u & 0xff);
+  v.push_back((u >> 8) & 0xff);
+  v.push_back((u >> 16) & 0xff);
+  v.push_back((u >> 24) & 0xff);
+}
+
+static int32_t readInt32(const unsigned char* c) {
+  uint32_t u = (uint32_t) c[0] | ((uint32_t) c[1] << 8) | 
+    ((uint32_t) c[2] << 16) | ((uint32_t) c[3] << 24);
+  return (int32_t) u;
+}
+
+std::vector<unsigned char> encoderTicksToUchar(const Eigen::Vector3i& ticks, 
+    int encoder_resolution) {
+  std::vector<unsigned char> v_char;
+  encoderTicksToUchar(ticks, encoder_resolution, v_char);
+  return v_char;
+}
+
+void encoderTicksToUchar(const Eigen::Vector3i& ticks, int encoder_resolution,
+    std::vector<unsigned char>& v_char) {
+  v_char.clear();
+  v_char.reserve(kTicksMsgSize);
+  pushInt32(v_char, encoder_resolution);
+  pushInt32(v_char, ticks[0]);
+  pushInt32(v_char, ticks[1]);
+  pushInt32(v_char, ticks[2]);
+}
+
+bool ucharToEncoderTicks(const std::vector<unsigned char>& v_uchar, 
+    Eigen::Vector3i& ticks, int& encoder_resolution) {
+  if (v_uchar.size() != kTicksMsgSize)
+    return false;
+  encoder_resolution = readInt32(&v_uchar[0]);
+  ticks[0] = readInt32(&v_uchar[4]);
+  ticks[1] = readInt32(&v_uchar[8]);
+  ticks[2] = readInt32(&v_uchar[12]);
+  return encoder_resolution > 0 && encoder_resolution <= kEncoderResolutionMax;
+}
+
+static void pushFloat(std::vector<unsigned char>& v, float value) {
+  int32_t i;
+  std::memcpy(&i, &value, sizeof(float));
+  pushInt32(v, i);
+}
+
+static float readFloat(const unsigned char* c) {
+  int32_t i = readInt32(c);
+  float f;
+  std::memcpy(&f, &i, sizeof(float));
+  return f;
+}
+
+std::vector<unsigned char> horizonToUchar(
+    const std::vector<Eigen::Vector3f>& setpoints, float t0, float dt) {
+  std::vector<unsigned char> v_char;
+  horizonToUchar(setpoints, t0, dt, v_char);
+  return v_char;
+}
+
+void horizonToUchar(const std::vector<Eigen::Vector3f>& setpoints, float t0, 
+    float dt, std::vector<unsigned char>& v_char) {
+  v_char.clear();
+  v_char.reserve(16 + 12 * setpoints.size());
+  pushInt32(v_char, kHorizonMagic);
+  pushInt32(v_char, (int32_t) setpoints.size());
+  pushFloat(v_char, t0);
+  pushFloat(v_char, dt);
+  for (const auto& u : setpoints) {
+    pushFloat(v_char, u[0]);
+    pushFloat(v_char, u[1]);
+    pushFloat(v_char, u[2]);
+  }
+}
+
+/** \return the size of the control inputs at the end of v_uchar, 0 if none
+ * (\sa appendControlInputs) */
+static size_t controlInputsSize(const std::vector<unsigned char>& v_uchar) {
+  if (v_uchar.size() < kJointsMsgSize + kControlInputsSize || 
+      readInt32(&v_uchar[v_uchar.size() - kControlInputsSize]) != 
+      kControlInputsMagic)
+    return 0;
+  return kControlInputsSize;
+}
+
+bool ucharToHorizon(const std::vector<unsigned char>& v_uchar, 
+    std::vector<Eigen::Vector3f>& setpoints, float& t0, float& dt) {
+  if (v_uchar.size() < 28 || readInt32(&v_uchar[0]) != kHorizonMagic)
+    return false;
+  int32_t count = readInt32(&v_uchar[4]);
+  if (count < 1 || count > kHorizonMax || v_uchar.size() != 
+      16 + 12 * (size_t) count + controlInputsSize(v_uchar))
+    return false;
+  t0 = readFloat(&v_uchar[8]);
+  dt = readFloat(&v_uchar[12]);
+  setpoints.resize(count);
+  for (int32_t k = 0; k < count; ++k) {
+    const unsigned char* c = &v_uchar[16 + 12 * k];
+    setpoints[k] = {readFloat(c), readFloat(c + 4), readFloat(c + 8)};
+  }
+  return true;
+}
+
+void appendControlInputs(double t, const Eigen::Vector3f& joints,
+    std::vector<unsigned char>& v_char) {
+  uint64_t u;
+  std::memcpy(&u, &t, sizeof(double));
+  pushInt32(v_char, kControlInputsMagic);
+  pushInt32(v_char, (int32_t) (uint32_t) (u & 0xffffffffu));
+  pushInt32(v_char, (int32_t) (uint32_t) (u >> 32));
+  pushFloat(v_char, joints[0]);
+  pushFloat(v_char, joints[1]);
+  pushFloat(v_char, joints[2]);
+}
+
+bool ucharToControlInputs(const std::vector<unsigned char>& v_uchar, 
+    double& t, Eigen::Vector3f& joints) {
+  if (controlInputsSize(v_uchar) == 0)
+    return false;
+  const unsigned char* c = &v_uchar[v_uchar.size() - kControlInputsSize];
+  uint64_t u = (uint64_t) (uint32_t) readInt32(c + 4) | 
+    ((uint64_t) (uint32_t) readInt32(c + 8) << 32);
+  std::memcpy(&t, &u, sizeof(double));
+  joints = {readFloat(c + 12), readFloat(c + 16), readFloat(c + 20)};
+  return true;
+}
+
 RemyRobotSettings parseRobotSetting(const json& j) {
   RemyRobotSettings settings;
   
-  auto ik_string = parseJsonFieldAtt<std::string>(j, "robot", "ik");
-  if (ik_string == "analytical") 
-    settings.iktype = IkType::analytical;
-  else if (ik_string == "transpose")
-    settings.iktype = IkType::transpose;
-  else if (ik_string == "damped")
-    settings.iktype = IkType::damped;
-
-  auto fk_string = parseJsonFieldAtt<std::string>(j, "robot", "fk");
-  if (fk_string == "fast") 
-    settings.fktype = FkType::fast;
-  else if (fk_string == "generic")
-    settings.fktype = FkType::generic;
-  
+  settings.iktype = parseJsonEnum<IkType>(j, "robot", "ik", {
+    {"analytical", IkType::analytical}, {"transpose", IkType::transpose},
+    {"damped", IkType::damped}, {"multistart", IkType::multistart}});
+  settings.fktype = parseJsonEnum<FkType>(j, "robot", "fk", {
+    {"fast", FkType::fast}, {"generic", FkType::generic}});
+  settings.reach_policy = parseJsonEnum<ReachPolicy>(j, "robot", "reach", {
+    {"none", ReachPolicy::none}, {"reject", ReachPolicy::reject}, 
+    {"project", ReachPolicy::project}}, "project");
+
+  settings.ik_cache_resolution = parseJsonFieldAtt<float>(j, "robot", 
+    "ik_cache_resolution", 0);
+  settings.ik_cache_capacity = parseJsonFieldAtt<int>(j, "robot", 
+    "ik_cache_capacity", 4096);
+
   auto joints_min = parseJsonFieldAtt<std::vector<float>>(j, "robot", 
     "joints_min");
   settings.joints_min[0] = joints_min[0];
@@ -104,6 +251,17 @@ RemyRobotSettings parseRobotSetting(const json& j) {
   settings.joints_max[0] = joints_max[0];
   settings.joints_max[1] = joints_max[1];
   settings.joints_max[2] = joints_max[2];
+
+  auto parse3 = [&j](const std::string& att, float value[3]) {
+    auto v = parseJsonFieldAtt<std::vector<float>>(j, "robot", att, 
+      {value[0], value[1], value[2]});
+    if (v.size() == 3)
+      std::copy(v.begin(), v.end(), value);
+  };
+  parse3("joint_velocity_max", settings.joint_velocity_max);
+  parse3("joint_acceleration_max", settings.joint_acceleration_max);
+  settings.retiming_step = parseJsonFieldAtt<float>(j, "robot", 
+    "retiming_step", settings.retiming_step);
   return settings;
 }
 
@@ -113,18 +271,81 @@ RemySystemSettings parseSystemSetting(const json& j) {
   settings.save_output = parseJsonFieldAtt<bool>(j, "robot_system", "save_output"); 
   settings.encoder_resolution = parseJsonFieldAtt<int>(j, "robot_system", 
     "encoder_resolution");
+  if (settings.encoder_resolution <= 0 || 
+      settings.encoder_resolution > kEncoderResolutionMax)
+    throw std::invalid_argument("robot_system.encoder_resolution: out of "
+      "range");
+  settings.encoder_output = parseJsonEnum<EncoderOutput>(j, "robot_system", 
+    "encoder_output", {{"angle", EncoderOutput::angle}, 
+    {"ticks", EncoderOutput::ticks}}, "angle");
+  settings.command_timeout_ms = parseJsonFieldAtt<int>(j, "robot_system", 
+    "command_timeout_ms", 0);
+  settings.integrator = parseJsonEnum<IntegratorType>(j, "robot_system", 
+    "integrator", {{"euler", IntegratorType::euler}, 
+    {"semi_implicit", IntegratorType::semi_implicit}, 
+    {"rk4", IntegratorType::rk4}}, "euler");
+  settings.integrator_step = parseJsonFieldAtt<double>(j, "robot_system", 
+    "integrator_step", settings.integrator_step);
+  settings.actuator_tau = parseJsonFieldAtt<float>(j, "robot_system", 
+    "actuator_tau", settings.actuator_tau);
+  settings.plant = parseJsonEnum<PlantModel>(j, "robot_system", "plant", {
+    {"kinematic", PlantModel::kinematic}, {"dynamic", PlantModel::dynamic}},
+    "kinematic");
+  auto parse3 = [&j](const std::string& att, float value[3]) {
+    auto v = parseJsonFieldAtt<std::vector<float>>(j, "robot_system", att, 
+      {value[0], value[1], value[2]});
+    if (v.size() == 3)
+      std::copy(v.begin(), v.end(), value);
+  };
+  parse3("link_mass", settings.dynamics.link_mass);
+  parse3("viscous_friction", settings.dynamics.viscous_friction);
+  parse3("velocity_gain", settings.dynamics.velocity_gain);
+  parse3("torque_max", settings.dynamics.torque_max);
+  settings.recorder_seconds = parseJsonFieldAtt<float>(j, "robot_system", 
+    "recorder_seconds", settings.recorder_seconds);
+  settings.recorder_prefix = parseJsonFieldAtt<std::string>(j, "robot_system",
+    "recorder_prefix", settings.recorder_prefix);
+  settings.recorder_format = parseJsonEnum<RecorderFormat>(j, 
+    "robot_system", "recorder_format", {{"binary", RecorderFormat::binary}, 
+    {"csv", RecorderFormat::csv}}, "binary");
   return settings;
 }
 
 RemyControlSettings parseControlSetting(const json& j) {
   RemyControlSettings settings;
   settings.frequency = parseJsonFieldAtt<int>(j, "control", "frequency"); 
-  auto control_type = parseJsonFieldAtt<std::string>(j, "control", "type"); 
-  if (control_type == "feedforward")
-    settings.control_type = ControlType::feedfoward;
-  else if (control_type == "analytical")
-    settings.control_type = ControlType::analytical;
+  settings.control_type = parseJsonEnum<ControlType>(j, "control", "type", {
+    {"feedforward", ControlType::feedfoward}, 
+    {"feedfoward", ControlType::feedfoward}, // legacy spelling
+    {"analytical", ControlType::analytical}});
+
+  auto q0dot = parseJsonFieldAtt<std::vector<float>>(j, "control", "q0dot", 
+    {settings.q0dot[0], settings.q0dot[1], settings.q0dot[2]});
+  if (q0dot.size() == 3)
+    std::copy(q0dot.begin(), q0dot.end(), settings.q0dot);
+  settings.kp = parseJsonFieldAtt<float>(j, "control", "kp", settings.kp);
+  settings.damping_w0 = parseJsonFieldAtt<float>(j, "control", "damping_w0",
+    settings.damping_w0);
+  settings.damping_alpha0 = parseJsonFieldAtt<float>(j, "control", 
+    "damping_alpha0", settings.damping_alpha0);
+  settings.horizon = parseJsonFieldAtt<int>(j, "control", "horizon", 
+    settings.horizon);
+  if (settings.horizon < 1 || settings.horizon > kHorizonMax)
+    throw std::invalid_argument("control.horizon: out of range");
+  settings.horizon_dt = parseJsonFieldAtt<float>(j, "control", "horizon_dt",
+    settings.horizon_dt);
   return settings;
 }
 
+#define REMY_INSTANTIATE_UTILS(T) \
+  template Eigen::Transform<T, 3, Eigen::Affine> DHToAffine(T, T, T, T); \
+  template T encoderToJoint<T>(int, int); \
+  template int jointToEncoder(T, int); \
+  template Eigen::Vector3i jointToEncoder(const Vector3<T>&, int); \
+  template void mockEncoderPrecisionLost(T&, int); \
+  template void mockEncoderPrecisionLost(Vector3<T>&, int);
+
+REMY_INSTANTIATE_UTILS(float)
+REMY_INSTANTIATE_UTILS(double)
+
 }
@@ -0,0 +1,182 @@
+// remy
+#include <workspace.h>
+#include <robot.h>
+
+// std
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+
+// posix
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace remy_robot_control {
+
+namespace {
+
+const char kMagic[4] = {'R', 'M', 'A', 'P'};
+const uint32_t kVersion = 1;
+
+// |det(J)| = 25 * |s3| * rho <= 25 * 20: the manipulability of the value 255
+const float kManipulabilityScale = 500;
+
+uint8_t quantize(float manipulability) {
+  float v = 1 + 254 * std::min(manipulability / kManipulabilityScale, 1.f);
+  return (uint8_t) std::lround(v);
+}
+
+}
+
+ReachabilityMap::ReachabilityMap(const Eigen::Vector3f& min, 
+    const Eigen::Vector3f& max, float resolution) {
+  std::memcpy(header_.magic, kMagic, sizeof(kMagic));
+  header_.version = kVersion;
+  for (int i = 0; i < 3; ++i) {
+    header_.origin[i] = min[i];
+    header_.dims[i] = std::max(1, (int) std::ceil((max[i] - min[i]) / 
+      resolution));
+  }
+  header_.resolution = resolution;
+  header_.manipulability_scale = kManipulabilityScale;
+  owned_.assign(size(), 0);
+  data_ = owned_.data();
+}
+
+ReachabilityMap::ReachabilityMap(float resolution) : 
+  ReachabilityMap(Eigen::Vector3f(-20 - resolution, -20 - resolution, 
+    -10 - resolution), Eigen::Vector3f(20 + resolution, 20 + resolution, 
+    10 + resolution), resolution) {}
+
+ReachabilityMap::~ReachabilityMap() {
+  if (mapped_)
+    munmap(mapped_, mapped_size_);
+}
+
+std::unique_ptr<ReachabilityMap> ReachabilityMap::load(
+    const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return nullptr;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(Header)) {
+    close(fd);
+    return nullptr;
+  }
+  void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED)
+    return nullptr;
+
+  std::unique_ptr<ReachabilityMap> map(new ReachabilityMap());
+  map->mapped_ = mapped;
+  map->mapped_size_ = st.st_size;
+  std::memcpy(&map->header_, mapped, sizeof(Header));
+  const Header& h = map->header_;
+  if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0 || 
+      h.version != kVersion || h.dims[0] <= 0 || h.dims[1] <= 0 || 
+      h.dims[2] <= 0 || !(h.resolution > 0) || 
+      sizeof(Header) + map->size() != (size_t) st.st_size)
+    return nullptr;
+  map->data_ = (const uint8_t*) mapped + sizeof(Header);
+  return map;
+}
+
+bool ReachabilityMap::save(const std::string& path) const {
+  std::ofstream file(path, std::ios::binary);
+  file.write((const char*) &header_, sizeof(Header));
+  file.write((const char*) data_, size());
+  return (bool) file;
+}
+
+Eigen::Vector3f ReachabilityMap::center(size_t index) const {
+  size_t i = index % header_.dims[0];
+  size_t j = (index / header_.dims[0]) % header_.dims[1];
+  size_t k = index / ((size_t) header_.dims[0] * header_.dims[1]);
+  const float r = header_.resolution;
+  return {header_.origin[0] + (i + 0.5f) * r, 
+    header_.origin[1] + (j + 0.5f) * r, header_.origin[2] + (k + 0.5f) * r};
+}
+
+size_t ReachabilityMap::reachableCount() const {
+  return size() - std::count(data_, data_ + size(), 0);
+}
+
+std::unique_ptr<ReachabilityMap> sweepJointGrid(
+    const RemyRobotSettings& settings, float resolution, int samples, 
+    ThreadPool& pool) {
+  std::unique_ptr<ReachabilityMap> map(new ReachabilityMap(resolution));
+  std::vector<std::vector<uint8_t>> buffers(pool.size());
+  
+  auto sample = [&](int joint, int i) {
+    float min = settings.joints_min[joint];
+    float max = settings.joints_max[joint];
+    return (samples > 1) ? min + (max - min) * i / (samples - 1) : min;
+  };
+
+  pool.parallelFor(samples, [&](size_t chunk, size_t begin, size_t end) {
+    auto& buffer = buffers[chunk];
+    buffer.assign(map->size(), 0);
+    Robot robot;
+    robot.setSettings(settings);
+    for (size_t i = begin; i < end; ++i) {
+      for (int j = 0; j < samples; ++j) {
+        for (int k = 0; k < samples; ++k) {
+          Eigen::Vector3f q(sample(0, i), sample(1, j), sample(2, k));
+          auto p = robot.forwardKinematics(q);
+          long index = map->index(p[0], p[1], p[2]);
+          if (index < 0)
+            continue;
+          uint8_t v = quantize(std::abs(robot.jacob(q).determinant()));
+          buffer[index] = std::max(buffer[index], v);
+        }
+      }
+    }
+  });
+
+  uint8_t* data = map->mutableData();
+  for (auto& buffer : buffers) {
+    if (buffer.empty())
+      continue;
+    for (size_t i = 0; i < map->size(); ++i) {
+      data[i] = std::max(data[i], buffer[i]);
+    }
+  }
+  return map;
+}
+
+std::unique_ptr<ReachabilityMap> sweepCartesianGrid(
+    const RemyRobotSettings& settings, float resolution, ThreadPool& pool) {
+  std::unique_ptr<ReachabilityMap> map(new ReachabilityMap(resolution));
+  uint8_t* data = map->mutableData();
+
+  pool.parallelFor(map->size(), [&](size_t, size_t begin, size_t end) {
+    Robot robot;
+    robot.setSettings(settings);
+    const float h = resolution / 2;
+    for (size_t i = begin; i < end; ++i) {
+      auto c = map->center(i);
+      uint8_t best = 0;
+      // center and corners: a voxel is reachable if any part of it is
+      for (int s = 0; s < 9; ++s) {
+        Eigen::Vector3f p = c;
+        if (s > 0) {
+          p += Eigen::Vector3f((s & 1) ? h : -h, (s & 2) ? h : -h, 
+            (s & 4) ? h : -h);
+        }
+        for (const auto& q : robot.analyticalIKBranches(p[0], p[1], p[2])) {
+          if (!robot.withinLimits(q))
+            continue;
+          best = std::max(best, 
+            quantize(std::abs(robot.jacob(q).determinant())));
+        }
+      }
+      data[i] = best;
+    }
+  });
+  return map;
+}
+
+} // end namespace remy_robot_control
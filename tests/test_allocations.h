@@ -0,0 +1,191 @@
+#pragma once
+
+#include <gtest/gtest.h>
+#include <alloc_scope.h>
+#include <control.h>
+#include <live_settings.h>
+#include <robot_system.h>
+#include <scheduler.h>
+#include <settings.h>
+
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <new>
+#include <string>
+
+using namespace remy_robot_control;
+
+/** It runs f within an AllocScope
+ * \return a failure with the call sites if f allocated or freed heap memory,
+ * or if the allocation hooks are not linked
+ */
+template <class F>
+::testing::AssertionResult noAllocations(F&& f) {
+  if (!AllocScope::enabled())
+    return ::testing::AssertionFailure() << "the allocation hooks are not "
+      "linked (\\sa AllocScope)";
+  size_t allocations;
+  size_t deallocations;
+  std::string sites;
+  {
+    AllocScope scope;
+    f();
+    allocations = scope.allocations();
+    deallocations = scope.deallocations();
+    if (allocations > 0)
+      sites = scope.report();
+  }
+  if (allocations == 0 && deallocations == 0)
+    return ::testing::AssertionSuccess();
+  return ::testing::AssertionFailure() << allocations << " allocation(s) and "
+    << deallocations << " deallocation(s)\n" << sites;
+}
+
+/** It expects that a statement does not allocate (\sa noAllocations) */
+#define EXPECT_NO_ALLOCATIONS(statement) \
+  EXPECT_TRUE(noAllocations([&]() { statement; }))
+
+int* volatile allocations_test_kept = nullptr;
+
+__attribute__((noinline)) void allocationsTestAllocate() {
+  allocations_test_kept = new int[4];
+}
+
+TEST(Allocations, scope)
+{
+  ASSERT_TRUE(AllocScope::enabled());
+  AllocScope scope;
+  EXPECT_EQ(scope.allocations(), 0u);
+  {
+    AllocScope inner;
+    allocationsTestAllocate();
+    EXPECT_EQ(inner.allocations(), 1u);
+    EXPECT_EQ(inner.bytes(), 4 * sizeof(int));
+    EXPECT_EQ(inner.deallocations(), 0u);
+  }
+  delete[] allocations_test_kept;
+  EXPECT_EQ(scope.allocations(), 1u);
+  EXPECT_EQ(scope.deallocations(), 1u);
+  const std::string report = scope.report();
+  EXPECT_NE(report.find("allocationsTestAllocate"), std::string::npos) << 
+    report;
+  // the report is not counted
+  EXPECT_EQ(scope.allocations(), 1u);
+  EXPECT_FALSE(noAllocations([]() { allocationsTestAllocate(); }));
+  delete[] allocations_test_kept;
+}
+
+int allocations_test_handler_calls = 0;
+
+void allocationsTestHandler() {
+  ++allocations_test_handler_calls;
+  std::set_new_handler(nullptr);
+}
+
+TEST(Allocations, newHandler)
+{
+  ASSERT_TRUE(AllocScope::enabled());
+  // the hooks behave as the default operator new on failure
+  volatile size_t huge = std::numeric_limits<size_t>::max() / 4;
+  std::set_new_handler(allocationsTestHandler);
+  EXPECT_THROW(allocations_test_kept = new int[huge / sizeof(int)], 
+    std::bad_alloc);
+  EXPECT_EQ(allocations_test_handler_calls, 1);
+  EXPECT_EQ(new (std::nothrow) char[huge], nullptr);
+}
+
+/** Full ticks of a Control and a RobotSystem, on a Scheduler of the calling
+ * thread: the control law, the plant step (with its flight recorder) and the
+ * messages over the connections, once warmed up */
+void expectTicksDoNotAllocate(const RemyControlSettings& control_settings,
+    RemySystemSettings system_settings)
+{
+  std::string input = std::string(TEST_DIR) + std::string("/input.in");
+  Control control(input);
+  control.setSettings(control_settings);
+  RobotSystem system;
+  system_settings.save_output = false;
+  system_settings.recorder_seconds = 1;
+  system_settings.recorder_prefix = testing::TempDir() + "remy_allocations";
+  system.setSettings(system_settings);
+  system.setJoints(Eigen::Vector3f(0.1f, 0.2f, 0.3f));
+  Scheduler scheduler;
+  system.start(control.connection, scheduler);
+  control.start(system.connection, scheduler);
+  const auto period = std::chrono::milliseconds(100);
+  scheduler.runUntil(ScheduledTask::Clock::now() + period);
+  const size_t resumes = scheduler.resumes();
+  // with a dump of the flight recorder, written by its own thread
+  EXPECT_NO_ALLOCATIONS(
+    system.recorder->request();
+    scheduler.runUntil(ScheduledTask::Clock::now() + period));
+  EXPECT_GT(scheduler.resumes(), resumes + 4);
+  system.recorder->flush();
+  ASSERT_EQ(system.recorder->dumps(), 1u);
+  std::remove(system.recorder->lastDump().c_str());
+  control.stop();
+  system.stop();
+  ASSERT_EQ(system.recorder->dumps(), 2u);
+  std::remove(system.recorder->lastDump().c_str());
+}
+
+TEST(Allocations, tick)
+{
+  expectTicksDoNotAllocate(RemyControlSettings(), RemySystemSettings());
+  RemyControlSettings control_settings;
+  control_settings.control_type = ControlType::analytical;
+  control_settings.horizon = 5;
+  RemySystemSettings system_settings;
+  system_settings.encoder_output = EncoderOutput::ticks;
+  system_settings.plant = PlantModel::dynamic;
+  expectTicksDoNotAllocate(control_settings, system_settings);
+}
+
+TEST(Allocations, liveSettings)
+{
+  std::string input = std::string(TEST_DIR) + std::string("/input.in");
+  Control control(input);
+  RobotSystem system;
+  RemySystemSettings system_settings;
+  system_settings.save_output = false;
+  system.setSettings(system_settings);
+  system.setJoints(Eigen::Vector3f(0.1f, 0.2f, 0.3f));
+  auto live = std::make_shared<LiveSettings>(RemyRobotSettings(), 
+    RemyControlSettings(), system_settings);
+  control.setLiveSettings(live);
+  system.setLiveSettings(live);
+  Scheduler scheduler;
+  system.start(control.connection, scheduler);
+  control.start(system.connection, scheduler);
+  const auto period = std::chrono::milliseconds(100);
+  scheduler.runUntil(ScheduledTask::Clock::now() + period);
+
+  // what used to allocate on the tick which applies it: a longer horizon,
+  // another IK cache and another encoder resolution
+  RemyRobotSettings robot_settings;
+  robot_settings.ik_cache_resolution = 0.01f;
+  RemyControlSettings control_settings;
+  control_settings.control_type = ControlType::analytical;
+  control_settings.horizon = kHorizonMax;
+  system_settings.encoder_output = EncoderOutput::ticks;
+  system_settings.encoder_resolution = 1000;
+  live->publish(robot_settings, control_settings, system_settings);
+  size_t resumes = scheduler.resumes();
+  EXPECT_NO_ALLOCATIONS(scheduler.runUntil(ScheduledTask::Clock::now() + 
+    period));
+  EXPECT_GT(scheduler.resumes(), resumes + 4);
+
+  // two encoder resolutions between two ticks: the one the controller
+  // decodes with is not freed when it moves on
+  system_settings.encoder_resolution = 2000;
+  live->publish(robot_settings, control_settings, system_settings);
+  system_settings.encoder_resolution = 3000;
+  live->publish(robot_settings, control_settings, system_settings);
+  resumes = scheduler.resumes();
+  EXPECT_NO_ALLOCATIONS(scheduler.runUntil(ScheduledTask::Clock::now() + 
+    period));
+  EXPECT_GT(scheduler.resumes(), resumes + 4);
+  control.stop();
+  system.stop();
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <gtest/gtest.h>
+#include <batch_control.h>
+#include <control.h>
+#include <settings.h>
+
+#include <random>
+
+using namespace remy_robot_control;
+
+/** It compares a batch of arms with one ControlT per arm, at times before,
+ * along and after the trajectories (and back). The targets within reach stay
+ * off the boundary of the workspace and the joints off the stretched arm,
+ * where both are ill-conditioned (acos(1), near singular J J^t in float).
+ * Every 5th arm is out of reach: it is compared with the reject policy only,
+ * as the projected target lies on the boundary. */
+template <class T>
+void expectBatchMatches(ControlType type, ReachPolicy policy, T tolerance) {
+  std::string input = std::string(TEST_DIR) + std::string("/input.in");
+  auto waypoints = Control(input).getWaypoints();
+  RemyControlSettings settings;
+  settings.control_type = type;
+  RemyRobotSettings robot;
+  robot.reach_policy = policy;
+
+  // not a multiple of the vector width
+  const size_t n = 37;
+  BatchControlT<T> batch;
+  batch.setSettings(settings);
+  batch.setRobotSettings(robot);
+  std::vector<std::unique_ptr<ControlT<T>>> controls;
+  JointBlock<T> joints(n, robot);
+  std::mt19937 gen(7);
+  std::uniform_real_distribution<T> offset(-1, 1);
+  std::uniform_real_distribution<T> angle(-1.5, 1.5);
+  std::uniform_real_distribution<T> elbow(0.3, 1.5);
+  for (size_t i = 0; i < n; ++i) {
+    std::vector<Vector4<T>> arm;
+    Vector4<T> shift(offset(gen) - T(1.5), offset(gen), offset(gen), 0);
+    // some arms with targets out of reach
+    if (i % 5 == 0)
+      shift[0] += 30;
+    for (const auto& w : waypoints) {
+      arm.push_back(w.template cast<T>() + shift);
+    }
+    EXPECT_EQ(batch.add(arm), i);
+    controls.push_back(std::make_unique<ControlT<T>>(arm));
+    controls.back()->setSettings(settings);
+    controls.back()->setRobotSettings(robot);
+    const T q3 = (i % 2) ? elbow(gen) : - elbow(gen);
+    joints.set(i, {angle(gen), angle(gen), q3});
+  }
+  ASSERT_EQ(batch.size(), n);
+  EXPECT_EQ(batch.period(), controls[0]->period());
+
+  for (T t : {T(0), T(0.5), T(3.3), T(7), T(2), T(100)}) {
+    batch.computeVelocityControl(joints, t);
+    for (size_t i = 0; i < n; ++i) {
+      controls[i]->computeVelocityControl(joints.get(i), t);
+      Vector3<T> expected = controls[i]->getControlSignal();
+      Vector3<T> u = batch.getControlSignal(i);
+      EXPECT_TRUE(u.allFinite()) << "arm " << i << " at " << t;
+      if (type == ControlType::analytical && policy != ReachPolicy::reject &&
+          i % 5 == 0)
+        continue;
+      EXPECT_LE((u - expected).norm(), tolerance * std::max<T>(1, 
+        expected.norm())) << "arm " << i << " at " << t << ": " << 
+        u.transpose() << " vs " << expected.transpose();
+    }
+  }
+  // the contiguous signals are the same
+  EXPECT_EQ(batch.u(1)[3], batch.getControlSignal(3)[1]);
+}
+
+TEST(BatchControl, feedforward)
+{
+  expectBatchMatches<float>(ControlType::feedfoward, ReachPolicy::project,
+    1e-3f);
+  expectBatchMatches<double>(ControlType::feedfoward, ReachPolicy::project,
+    1e-9);
+}
+
+TEST(BatchControl, analytical)
+{
+  for (ReachPolicy policy : {ReachPolicy::project, ReachPolicy::reject}) {
+    expectBatchMatches<float>(ControlType::analytical, policy, 1e-3f);
+    expectBatchMatches<double>(ControlType::analytical, policy, 1e-9);
+  }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <gtest/gtest.h> 
+#include <broadcast.h>
+#include <robot_system.h>
+
+// std
+#include <thread>
+
+using namespace remy_robot_control;
+
+TEST(Broadcast, readers) 
+{
+  BroadcastChannel<int, 4> channel;
+  auto early = channel.subscribe();
+  channel.publish(1);
+  auto late = channel.subscribe();
+  channel.publish(2);
+
+  int value = 0;
+  EXPECT_EQ(early.read(value), decltype(channel)::Status::ok);
+  EXPECT_EQ(value, 1);
+  EXPECT_EQ(early.read(value), decltype(channel)::Status::ok);
+  EXPECT_EQ(value, 2);
+  EXPECT_EQ(early.read(value), decltype(channel)::Status::empty);
+  EXPECT_EQ(late.read(value), decltype(channel)::Status::ok);
+  EXPECT_EQ(value, 2);
+
+  // the writer does not wait for the slow reader: it is told what it lost
+  for (int i = 3; i <= 10; ++i) {
+    channel.publish(i);
+  }
+  EXPECT_EQ(early.lag(), 8u);
+  EXPECT_EQ(early.read(value), decltype(channel)::Status::overrun);
+  EXPECT_EQ(value, 7);
+  EXPECT_EQ(early.lost(), 4u);
+  EXPECT_EQ(early.read(value), decltype(channel)::Status::ok);
+  EXPECT_EQ(value, 8);
+  EXPECT_TRUE(late.readLatest(value));
+  EXPECT_EQ(value, 10);
+  EXPECT_EQ(late.lag(), 0u);
+}
+
+TEST(Broadcast, concurrent) 
+{
+  struct Message {
+    uint64_t a;
+    uint64_t b; ///< 3 * a, to detect torn reads
+  };
+  BroadcastChannel<Message, 8> channel;
+  const uint64_t n = 200000;
+  auto reader = [&channel, n] {
+    auto cursor = channel.subscribe();
+    Message m;
+    uint64_t last = 0;
+    bool ok = true;
+    while (last < n) {
+      if (cursor.read(m) == decltype(channel)::Status::empty) {
+        std::this_thread::yield();
+        continue;
+      }
+      ok = ok && m.b == 3 * m.a && m.a > last;
+      last = m.a;
+    }
+    return ok && cursor.lost() < n;
+  };
+  auto r1 = std::async(std::launch::async, reader);
+  auto r2 = std::async(std::launch::async, reader);
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  for (uint64_t i = 1; i <= n; ++i) {
+    channel.publish({i, 3 * i});
+  }
+  EXPECT_TRUE(r1.get());
+  EXPECT_TRUE(r2.get());
+}
+
+TEST(Broadcast, robotState) 
+{
+  RobotSystem system;
+  system.save_run = false;
+  auto monitor = system.state->subscribe();
+  system.setControl(eigen3fToUchar3({1, 0, 0}));
+  system.step(0.001);
+  system.step(0.001);
+  RobotState state;
+  EXPECT_EQ(monitor.lag(), 2u);
+  EXPECT_TRUE(monitor.readLatest(state));
+  EXPECT_NEAR(state.t, 0.002, 1e-9);
+  EXPECT_NEAR(state.joints[0], 0.002f, 1e-6);
+  EXPECT_EQ(state.control[0], 1);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <gtest/gtest.h> 
+#include <connection.h>
+
+// std
+#include <thread>
+#include <future>
+
+TEST(Connection, sequence) 
+{
+  Connection connection;
+  connection.open();
+  std::vector<unsigned char> data = {1, 2, 3};
+  std::vector<unsigned char> received;
+  Connection::Clock::time_point stamp;
+  EXPECT_EQ(connection.receive(received, stamp), 0u);
+  connection.send(data);
+  EXPECT_EQ(connection.receive(received, stamp), 1u);
+  EXPECT_EQ(received, data);
+  EXPECT_LE(stamp, Connection::Clock::now());
+  connection.send(data);
+  EXPECT_EQ(connection.sequence(), 2u);
+
+  // nothing newer than 2: timeout
+  EXPECT_EQ(connection.waitNewer(2, received, std::chrono::milliseconds(1)),
+    0u);
+  EXPECT_EQ(connection.waitNewer(1, received, std::chrono::milliseconds(1)),
+    2u);
+}
+
+TEST(Connection, wakeup) 
+{
+  Connection connection;
+  EXPECT_FALSE(connection.waitOpened(std::chrono::milliseconds(1)));
+  auto opened = std::async(std::launch::async, [&connection] {
+    return connection.waitOpened(std::chrono::seconds(5));
+  });
+  connection.open();
+  EXPECT_TRUE(opened.get());
+
+  auto newer = std::async(std::launch::async, [&connection] {
+    std::vector<unsigned char> data;
+    auto sequence = connection.waitNewer(0, data, std::chrono::seconds(5));
+    return std::make_pair(sequence, Connection::Clock::now());
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  std::vector<unsigned char> data = {4};
+  auto sent = Connection::Clock::now();
+  connection.send(data);
+  auto result = newer.get();
+  EXPECT_EQ(result.first, 1u);
+  // woken up by the writer, not by the timeout
+  EXPECT_LT(result.second - sent, std::chrono::milliseconds(100));
+
+  // closing wakes the readers up
+  auto closed = std::async(std::launch::async, [&connection] {
+    std::vector<unsigned char> data;
+    return connection.waitNewer(1, data, std::chrono::seconds(5));
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  connection.close();
+  EXPECT_EQ(closed.get(), 0u);
+}
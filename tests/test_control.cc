@@ -1,6 +1,7 @@
 #include <gtest/gtest.h> 
 #include <control.h>
 #include <fstream>
+#include <cmath>
 #include <settings.h>
 
 using namespace remy_robot_control;
@@ -31,50 +32,50 @@ TEST(Control, init)
 }
 
 void assertPosition(const Eigen::Vector3f& p, float t) {
-  float tol = 1e-1;
-  if (abs(t - 1.5) <= 1e-3) {
+  float tol = 1e-1f;
+  if (std::abs(t - 1.5f) <= 1e-3f) {
     EXPECT_NEAR(p[0], 17, tol);
     EXPECT_NEAR(p[1], 0, tol);
     EXPECT_NEAR(p[2], 0, tol);
     return;
   }
 
-  if (abs(t -3.5) <= 1e-3) {
+  if (std::abs(t - 3.5f) <= 1e-3f) {
     EXPECT_NEAR(p[0], 15, tol);
     EXPECT_NEAR(p[1], 1.5, tol);
     EXPECT_NEAR(p[2], 1.5, tol);
     return;
   }
 
-  if (abs(t - 3.5) <= 1e-3) {
+  if (std::abs(t - 3.5f) <= 1e-3f) {
     EXPECT_NEAR(p[0], 15, tol);
     EXPECT_NEAR(p[1], 1.5, tol);
     EXPECT_NEAR(p[2], 1.5, tol);
     return;
   }
 
-  if (abs(t - 5.0) <= 1e-3) {
+  if (std::abs(t - 5.0f) <= 1e-3f) {
     EXPECT_NEAR(p[0], 15, tol);
     EXPECT_NEAR(p[1], -1.5, tol);
     EXPECT_NEAR(p[2], 1.5, tol);
     return;
   }
 
-  if (abs(t - 7.0) <= 1e-3) {
+  if (std::abs(t - 7.0f) <= 1e-3f) {
     EXPECT_NEAR(p[0], 15, tol);
     EXPECT_NEAR(p[1], -1.5, tol);
     EXPECT_NEAR(p[2], -1.5, tol);
     return;
   }
 
-  if (abs(t - 9.0) <= 1e-3) {
+  if (std::abs(t - 9.0f) <= 1e-3f) {
     EXPECT_NEAR(p[0], 15, tol);
     EXPECT_NEAR(p[1], 1.5, tol);
     EXPECT_NEAR(p[2], -1.5, tol);
     return;
   }
 
-  if (abs(t - 10.0) <= 1e-3) {
+  if (std::abs(t - 10.0f) <= 1e-3f) {
     EXPECT_NEAR(p[0], 20, tol);
     EXPECT_NEAR(p[1], 0, tol);
     EXPECT_NEAR(p[2], 0, tol);
@@ -87,8 +88,8 @@ TEST(Control, feedforward)
   std::string input = std::string(TEST_DIR) + std::string("/input.in");
   Control control(std::move(input));
   Robot robot(0, 0, 0);
-  float dt = 0.02;
-  for (float t = 0; t < 11; t+= 0.02) {
+  float dt = 0.02f;
+  for (float t = 0; t < 11; t += 0.02f) {
     control.computeVelocityControl(robot.getJoints(), t);
     robot.update(control.getControlSignal(), dt);
     auto p = robot.forwardKinematics(robot.getJoints());
@@ -103,8 +104,8 @@ TEST(Control, analytical)
   Control control(std::move(input));
   Robot robot(0, 0, 0);
   control.setControlStrategy(ControlType::analytical);
-  float dt = 0.02;
-  for (float t = 0; t < 11; t+= 0.02) {
+  float dt = 0.02f;
+  for (float t = 0; t < 11; t += 0.02f) {
     control.computeVelocityControl(robot.getJoints(), t);
     robot.update(control.getControlSignal(), dt);
     auto p = robot.forwardKinematics(robot.getJoints());
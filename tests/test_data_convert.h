@@ -2,6 +2,7 @@
 
 #include <gtest/gtest.h> 
 #include <utils.h>
+#include <encoder_table.h>
 
 using namespace remy_robot_control;
 
@@ -22,4 +23,98 @@ TEST(Data, encoder)
   EXPECT_NEAR(5.1204, u[0], 1e-4);
   EXPECT_NEAR(4.5313, u[1], 1e-4);
   EXPECT_NEAR(6.5516, u[2], 1e-4);
-}
\ No newline at end of file
+}
+
+TEST(Data, encoderResolution) 
+{
+  EXPECT_NEAR(encoderToJoint(512, 1024), 0, 1e-6);
+  EXPECT_NEAR(encoderToJoint(2048), 0, 1e-6);
+  EXPECT_EQ(jointToEncoder(0.f, 1024), 512);
+  EXPECT_EQ(jointToEncoder(0.f), 2048);
+
+  float q = 1.234;
+  mockEncoderPrecisionLost(q, 1000);
+  EXPECT_NEAR(1.2315, q, 1e-4);
+}
+
+TEST(Data, encoderTicks) 
+{
+  Eigen::Vector3i ticks(0, 2047, 4096);
+  auto tc = encoderTicksToUchar(ticks, 4096);
+  ASSERT_EQ(tc.size(), kTicksMsgSize);
+  Eigen::Vector3i tt;
+  int resolution;
+  ASSERT_TRUE(ucharToEncoderTicks(tc, tt, resolution));
+  ASSERT_EQ(resolution, 4096);
+  ASSERT_EQ(tt, ticks);
+  ASSERT_FALSE(ucharToEncoderTicks(encoderTicksToUchar(ticks, 
+    kEncoderResolutionMax + 1), tt, resolution));
+
+  auto qc = eigen3fToUchar3(Eigen::Vector3f(1, 2, 3));
+  ASSERT_FALSE(ucharToEncoderTicks(qc, tt, resolution));
+}
+
+TEST(Data, encoderTable) 
+{
+  Eigen::Vector3f q(-3.1, 0.25, 2.9);
+  for (int resolution : {1000, 4096}) {
+    auto table = sharedEncoderTable(resolution);
+    ASSERT_EQ(table, sharedEncoderTable(resolution));
+    
+    auto qq = q;
+    mockEncoderPrecisionLost(qq, resolution);
+    auto qt = (*table)(jointToEncoder(q, resolution));
+    ASSERT_FLOAT_EQ(qq[0], qt[0]);
+    ASSERT_FLOAT_EQ(qq[1], qt[1]);
+    ASSERT_FLOAT_EQ(qq[2], qt[2]);
+  }
+  EXPECT_FALSE(sharedEncoderTable(0));
+  EXPECT_FALSE(sharedEncoderTable(kEncoderResolutionMax + 1));
+
+  // the cache only keeps the tables in use
+  std::weak_ptr<const EncoderTable> unused = sharedEncoderTable(123);
+  EXPECT_TRUE(unused.expired());
+  auto used = sharedEncoderTable(321);
+  EXPECT_EQ(used, sharedEncoderTable(321));
+}
+TEST(Data, horizon) 
+{
+  std::vector<Eigen::Vector3f> setpoints = {
+    Eigen::Vector3f(1, 2, 3), Eigen::Vector3f(-1, 0.5, 4)};
+  auto c = horizonToUchar(setpoints, 1.5f, 0.02f);
+  ASSERT_EQ(c.size(), 16u + 12u * setpoints.size());
+  std::vector<Eigen::Vector3f> s;
+  float t0, dt;
+  ASSERT_TRUE(ucharToHorizon(c, s, t0, dt));
+  ASSERT_EQ(s, setpoints);
+  ASSERT_EQ(t0, 1.5f);
+  ASSERT_EQ(dt, 0.02f);
+
+  auto qc = eigen3fToUchar3(Eigen::Vector3f(1, 2, 3));
+  ASSERT_FALSE(ucharToHorizon(qc, s, t0, dt));
+  c.pop_back();
+  ASSERT_FALSE(ucharToHorizon(c, s, t0, dt));
+}
+
+TEST(Data, controlInputs) 
+{
+  double t;
+  Eigen::Vector3f q;
+  auto c = eigen3fToUchar3(Eigen::Vector3f(1, 2, 3));
+  ASSERT_FALSE(ucharToControlInputs(c, t, q));
+  appendControlInputs(0.123456789012, Eigen::Vector3f(0.1f, -0.2f, 3.f), c);
+  ASSERT_EQ(c.size(), kJointsMsgSize + kControlInputsSize);
+  ASSERT_TRUE(ucharToControlInputs(c, t, q));
+  EXPECT_EQ(t, 0.123456789012);
+  EXPECT_EQ(q, Eigen::Vector3f(0.1f, -0.2f, 3.f));
+  EXPECT_EQ(uchar3ToEigen3f(c), Eigen::Vector3f(1, 2, 3));
+
+  // the horizon decoder skips them
+  std::vector<Eigen::Vector3f> setpoints = {Eigen::Vector3f(1, 2, 3)};
+  c = horizonToUchar(setpoints, 1.5f, 0.02f);
+  appendControlInputs(1.5, Eigen::Vector3f::Zero(), c);
+  std::vector<Eigen::Vector3f> s;
+  float t0, dt;
+  ASSERT_TRUE(ucharToHorizon(c, s, t0, dt));
+  EXPECT_EQ(s, setpoints);
+}
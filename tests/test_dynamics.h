@@ -0,0 +1,87 @@
+#pragma once
+
+#include <gtest/gtest.h>
+#include <dynamics.h>
+#include <integrator.h>
+#include <robot_system.h>
+
+using namespace remy_robot_control;
+
+TEST(Dynamics, rneaCrba)
+{
+  Dynamicsd dynamics;
+  Eigen::Vector3d q(0.3, -0.7, 1.2), qd(0.5, -1, 2), qdd(1, 0.2, -0.4);
+
+  // tau = M qdd + bias
+  auto M = dynamics.massMatrix(q);
+  EXPECT_TRUE(M.isApprox(M.transpose()));
+  EXPECT_GT(M.llt().matrixL()(2, 2), 0);
+  auto tau = dynamics.inverseDynamics(q, qd, qdd);
+  EXPECT_TRUE(tau.isApprox(M * qdd + dynamics.bias(q, qd), 1e-9));
+  EXPECT_TRUE(dynamics.forwardDynamics(q, qd, tau).isApprox(qdd, 1e-9));
+
+  // gravity torques are the gradient of the potential energy
+  const double h = 1e-6;
+  auto g = dynamics.gravity(q);
+  for (int i = 0; i < 3; ++i) {
+    Eigen::Vector3d dq = Eigen::Vector3d::Zero();
+    dq[i] = h;
+    double dv = (dynamics.potentialEnergy(q + dq) -
+      dynamics.potentialEnergy(q - dq)) / (2 * h);
+    EXPECT_NEAR(g[i], dv, 1e-5);
+  }
+  // the first joint is vertical
+  EXPECT_NEAR(g[0], 0, 1e-9);
+}
+
+TEST(Dynamics, energy)
+{
+  // no friction and no torque: the energy is conserved
+  RemyDynamicsSettings settings;
+  std::fill(settings.viscous_friction, settings.viscous_friction + 3, 0.f);
+  Dynamicsd dynamics(settings);
+  IntegratorT<double> integrator(IntegratorType::rk4, 0.0005);
+  Eigen::Vector3d q(0, 0.5, -0.5), qd(1, 0, 0);
+  const double e0 = dynamics.kineticEnergy(q, qd) +
+    dynamics.potentialEnergy(q);
+  for (int k = 0; k < 100; ++k) {
+    integrator.integrate([&dynamics](double, const Eigen::Vector3d& q,
+        const Eigen::Vector3d& qd) {
+      return dynamics.forwardDynamics(q, qd, Eigen::Vector3d::Zero());
+    }, 0.01, q, qd);
+  }
+  const double e1 = dynamics.kineticEnergy(q, qd) +
+    dynamics.potentialEnergy(q);
+  EXPECT_NEAR(e1, e0, 1e-6 * std::abs(e0) + 1e-6);
+  EXPECT_GT(qd.norm(), 0.1);
+}
+
+TEST(Dynamics, plant)
+{
+  auto run = [](float torque_max, size_t& saturations) {
+    RobotSystem system;
+    system.save_run = false;
+    RemySystemSettings settings;
+    settings.plant = PlantModel::dynamic;
+    settings.integrator = IntegratorType::semi_implicit;
+    settings.integrator_step = 0.001;
+    settings.dynamics.torque_max[1] = torque_max;
+    system.setSettings(settings);
+    system.setControl(eigen3fToUchar3(Eigen::Vector3f(0.2f, 0.5f, 0)));
+    for (int k = 0; k < 500; ++k) {
+      system.step(0.002);
+    }
+    saturations = system.getTorqueSaturations();
+    return system.getJointVelocities();
+  };
+  size_t saturations;
+  auto qd = run(1000, saturations);
+  EXPECT_NEAR(qd[0], 0.2f, 0.02f);
+  EXPECT_NEAR(qd[1], 0.5f, 0.02f);
+  EXPECT_EQ(saturations, 0u);
+
+  // the second joint can not hold the arm against the gravity
+  qd = run(20, saturations);
+  EXPECT_LT(qd[1], 0);
+  EXPECT_GT(saturations, 0u);
+}
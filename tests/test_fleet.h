@@ -0,0 +1,43 @@
+#pragma once
+
+#include <gtest/gtest.h> 
+#include <fleet.h>
+#include <simulation.h>
+#include <settings.h>
+
+using namespace remy_robot_control;
+
+TEST(Fleet, run) 
+{
+  std::string input = std::string(TEST_DIR) + std::string("/input.in");
+  RemyRobotSettings robot;
+  RemyControlSettings control;
+  RemySystemSettings system;
+  system.frequency = 1000;
+
+  ThreadPool pool(2);
+  Fleet fleet(pool);
+  for (int i = 0; i < 4; ++i) {
+    fleet.add(input, robot, control, system);
+  }
+  auto report = fleet.run(2);
+  report = fleet.run(1);
+  EXPECT_EQ(report.arms, 4u);
+  EXPECT_EQ(report.plant_steps, 4u * 1000);
+  EXPECT_EQ(report.control_steps, 4u * 50);
+  EXPECT_GT(report.armSecondsPerWallSecond(), 0);
+
+  // simulated time: same result whatever the workers and the slicing
+  ThreadPool single(1);
+  Fleet reference(single);
+  reference.add(input, robot, control, system);
+  reference.run(3);
+  for (size_t i = 0; i < fleet.size(); ++i) {
+    EXPECT_EQ(fleet.getJoints(i), reference.getJoints(0));
+  }
+
+  // offline: neither csv logs nor flight recorder dumps
+  auto offline = offlineSettings(system);
+  EXPECT_FALSE(offline.save_output);
+  EXPECT_EQ(offline.recorder_seconds, 0);
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <gtest/gtest.h>
+#include <flight_recorder.h>
+#include <robot_system.h>
+#include <utils.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+using namespace remy_robot_control;
+
+TEST(FlightRecorder, ring)
+{
+  FlightRecorder recorder(4);
+  for (int i = 0; i < 6; ++i) {
+    FlightRecord r = {};
+    r.t = i;
+    r.sequence = i;
+    recorder.record(r);
+  }
+  ASSERT_EQ(recorder.size(), 4u);
+  EXPECT_EQ(recorder.recorded(), 6u);
+  EXPECT_EQ(recorder[0].t, 2);
+  EXPECT_EQ(recorder[3].t, 5);
+
+  // binary: header and the records from the oldest one
+  std::stringstream bin;
+  ASSERT_TRUE(recorder.write(bin, RecorderFormat::binary));
+  std::string b = bin.str();
+  ASSERT_EQ(b.size(), 20 + 4 * sizeof(FlightRecord));
+  EXPECT_EQ(b.substr(0, 4), "RFLR");
+  uint64_t count;
+  std::memcpy(&count, &b[12], 8);
+  EXPECT_EQ(count, 4u);
+  for (size_t i = 0; i < 4; ++i) {
+    FlightRecord r;
+    std::memcpy(&r, &b[20 + i * sizeof(FlightRecord)], sizeof(FlightRecord));
+    EXPECT_EQ(r.sequence, i + 2);
+  }
+
+  std::stringstream csv;
+  ASSERT_TRUE(recorder.write(csv, RecorderFormat::csv));
+  std::string c = csv.str();
+  EXPECT_EQ(std::count(c.begin(), c.end(), '\n'), 5);
+}
+
+TEST(FlightRecorder, system)
+{
+  RobotSystem system;
+  RemySystemSettings settings;
+  settings.frequency = 1000;
+  settings.recorder_seconds = 0.01f;
+  settings.recorder_prefix = testing::TempDir() + "remy_recorder";
+  settings.recorder_format = RecorderFormat::csv;
+  system.setSettings(settings);
+  system.save_run = false;
+  auto recorder = system.recorder;
+  ASSERT_TRUE(recorder);
+  ASSERT_EQ(recorder->capacity(), 10u);
+
+  system.setControl(eigen3fToUchar3({1, 0, 0}));
+  for (int k = 0; k < 20; ++k) {
+    system.step(0.001);
+  }
+  EXPECT_EQ(recorder->size(), 10u);
+  EXPECT_NEAR((*recorder)[9].t, 0.02, 1e-9);
+  EXPECT_EQ((*recorder)[9].command[0], 1);
+  EXPECT_EQ(recorder->dumps(), 0u);
+
+  // on request, at the next step
+  recorder->request();
+  EXPECT_EQ(recorder->dumps(), 0u);
+  system.step(0.001);
+  recorder->flush();
+  ASSERT_EQ(recorder->dumps(), 1u);
+  std::ifstream file(recorder->lastDump());
+  std::string line;
+  size_t lines = 0;
+  while (std::getline(file, line)) ++lines;
+  EXPECT_EQ(lines, 11u);
+  std::remove(recorder->lastDump().c_str());
+
+  // on faults, once per ring
+  system.setControl(eigen3fToUchar3({NAN, 0, 0}));
+  for (int k = 0; k < 5; ++k) {
+    system.step(0.001);
+  }
+  recorder->flush();
+  ASSERT_EQ(recorder->dumps(), 2u);
+  EXPECT_NE(recorder->lastDump().find("fault"), std::string::npos);
+  std::remove(recorder->lastDump().c_str());
+
+  // on signal
+  FlightRecorder::installSignalHandler(SIGUSR1);
+  std::raise(SIGUSR1);
+  system.step(0.001);
+  recorder->flush();
+  ASSERT_EQ(recorder->dumps(), 3u);
+  EXPECT_NE(recorder->lastDump().find("signal"), std::string::npos);
+  std::remove(recorder->lastDump().c_str());
+  std::signal(SIGUSR1, SIG_DFL);
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <gtest/gtest.h> 
+#include <gain_sweep.h>
+#include <control.h>
+#include <robot_system.h>
+#include <utils.h>
+#include <settings.h>
+
+using namespace remy_robot_control;
+
+TEST(GainSweep, simulate) 
+{
+  std::string input = std::string(TEST_DIR) + std::string("/input.in");
+  auto waypoints = Control(input).getWaypoints();
+  SimulationCase simulation;
+  simulation.system.frequency = 1000;
+  auto a = simulate(waypoints, simulation);
+  auto b = simulate(waypoints, simulation);
+  EXPECT_EQ(a.rms_error, b.rms_error);
+  EXPECT_EQ(a.effort, b.effort);
+  EXPECT_EQ(a.samples, 10000u);
+  EXPECT_LT(a.rms_error, 0.5);
+  EXPECT_GT(a.effort, 0);
+
+  // no proportional gain: the error is not corrected
+  simulation.control.kp = 0;
+  EXPECT_GT(simulate(waypoints, simulation).rms_error, a.rms_error);
+}
+
+TEST(GainSweep, horizon) 
+{
+  std::string input = std::string(TEST_DIR) + std::string("/input.in");
+  auto waypoints = Control(input).getWaypoints();
+  SimulationCase simulation;
+  simulation.seconds = 5;
+  simulation.system.frequency = 1000;
+  simulation.control.frequency = 10;
+  auto a = simulate(waypoints, simulation);
+
+  // the plant follows the predicted setpoints between two slow messages
+  simulation.control.horizon = 6;
+  simulation.control.horizon_dt = 0.02f;
+  auto b = simulate(waypoints, simulation);
+  EXPECT_LT(b.rms_error, a.rms_error);
+}
+
+TEST(GainSweep, horizonTime)
+{
+  std::vector<Eigen::Vector3f> setpoints(10);
+  for (size_t k = 0; k < setpoints.size(); ++k) {
+    setpoints[k] = Eigen::Vector3f((float) k, 0, 0);
+  }
+  RobotSystem system;
+  system.save_run = false;
+  system.step(0.1);
+  // the controller clock is 4.9 s ahead
+  system.setControl(horizonToUchar(setpoints, 5, 0.01f));
+  system.step(0.02);
+  EXPECT_NEAR(system.getJointVelocities()[0], 1, 1e-3f);
+  // sent 20 ms later, but received 30 ms late: its first setpoints are due
+  system.step(0.03);
+  system.setControl(horizonToUchar(setpoints, 5.02f, 0.01f));
+  system.step(0.02);
+  EXPECT_NEAR(system.getJointVelocities()[0], 4, 1e-3f);
+  // a new controller, whose clock starts again
+  system.setControl(horizonToUchar(setpoints, 0, 0.01f));
+  system.step(0.02);
+  EXPECT_NEAR(system.getJointVelocities()[0], 1, 1e-3f);
+}
+
+TEST(GainSweep, rank) 
+{
+  std::string input = std::string(TEST_DIR) + std::string("/input.in");
+  auto waypoints = Control(input).getWaypoints();
+  SimulationCase simulation;
+  simulation.seconds = 3;
+  GainSpace space;
+  auto grid = gainGrid(simulation.control, space, 2);
+  ASSERT_EQ(grid.size(), 16u);
+  EXPECT_EQ(grid.front().kp, space.kp.min);
+  EXPECT_EQ(grid.back().damping_alpha0, space.damping_alpha0.max);
+
+  ThreadPool pool(2);
+  auto candidates = randomGains(simulation.control, space, 8, 1);
+  auto entries = sweepGains(waypoints, simulation, candidates, pool);
+  ASSERT_EQ(entries.size(), 8u);
+  size_t pareto = 0;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    if (i > 0) {
+      EXPECT_LE(entries[i - 1].score, entries[i].score);
+    }
+    pareto += entries[i].pareto;
+  }
+  EXPECT_TRUE(entries.front().pareto);
+  EXPECT_GE(pareto, 1u);
+}
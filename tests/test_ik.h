@@ -66,3 +66,133 @@ TEST(IKTest, damped)
     EXPECT_NEAR(xyz_result[2], xyz[i][2], 1e-2);
   }
 }
+
+TEST(IKTest, analyticalBranches) 
+{
+  Robot robot;  
+  for (size_t i = 0; i < 5; ++i) {
+    auto branches = robot.analyticalIKBranches(xyz[i][0], xyz[i][1], 
+      xyz[i][2]);
+    for (const auto& result : branches) {
+      auto xyz_result = robot.forwardKinematics(result);
+      EXPECT_NEAR(xyz_result[0], xyz[i][0], 1e-2);
+      EXPECT_NEAR(xyz_result[1], xyz[i][1], 1e-2);
+      EXPECT_NEAR(xyz_result[2], xyz[i][2], 1e-2);
+    }
+    EXPECT_TRUE(robot.withinLimits(branches[0]) || 
+      robot.withinLimits(branches[1]));
+  }
+  auto out = robot.analyticalIKBranches(25, 0, 0);
+  EXPECT_TRUE(std::isnan(out[0][2]));
+}
+
+TEST(IKTest, reach) 
+{
+  Robot robot;  
+  robot.setIk(IkType::damped);
+  for (size_t i = 0; i < 5; ++i) {
+    EXPECT_TRUE(robot.isReachable(xyz[i][0], xyz[i][1], xyz[i][2]));
+  }
+  EXPECT_FALSE(robot.isReachable(25, 0, 0));
+  EXPECT_FALSE(robot.isReachable(0, 0, 11));
+
+  // default: projected to the boundary of the workspace
+  auto result = robot.inverseKinematics(25, 0, 0);
+  auto xyz_result = robot.forwardKinematics(result);
+  EXPECT_NEAR(xyz_result[0], 20, 1e-2);
+  EXPECT_NEAR(xyz_result[1], 0, 1e-2);
+  EXPECT_NEAR(xyz_result[2], 0, 1e-2);
+
+  robot.setReachPolicy(ReachPolicy::reject);
+  result = robot.inverseKinematics(25, 0, 0);
+  EXPECT_FALSE(result.allFinite());
+  result = robot.inverseKinematics(xyz[0][0], xyz[0][1], xyz[0][2]);
+  EXPECT_TRUE(result.allFinite());
+
+  // within the shell, but both elbows need |q2| > pi / 2
+  EXPECT_FALSE(robot.isReachable(2, 0, -3));
+  EXPECT_FALSE(robot.inverseKinematics(2, 0, -3).allFinite());
+  RemyRobotSettings settings;
+  settings.joints_min[1] = - kPi<float>;
+  settings.joints_max[1] = kPi<float>;
+  robot.setSettings(settings);
+  EXPECT_TRUE(robot.isReachable(2, 0, -3));
+}
+
+TEST(IKTest, multistart) 
+{
+  Robot robot;  
+  robot.setIk(IkType::multistart);
+  auto check = [&robot]() {
+    for (size_t i = 0; i < xyz.size(); ++i) {
+      auto result = robot.inverseKinematics(xyz[i][0], xyz[i][1], xyz[i][2]);
+      EXPECT_TRUE(robot.withinLimits(result));
+      auto xyz_result = robot.forwardKinematics(result);
+      EXPECT_NEAR(xyz_result[0], xyz[i][0], 1e-2);
+      EXPECT_NEAR(xyz_result[1], xyz[i][1], 1e-2);
+      EXPECT_NEAR(xyz_result[2], xyz[i][2], 1e-2);
+    }
+  };
+  check();
+  robot.setThreadPool(std::make_shared<ThreadPool>(2));
+  check();
+
+  // restricted limits (see tests/data/config_test.json)
+  RemyRobotSettings settings;
+  settings.iktype = IkType::multistart;
+  float joints_min[3] = {-1, -0.5, -2};
+  float joints_max[3] = {0.5, 0.1, 1};
+  std::copy(joints_min, joints_min + 3, settings.joints_min);
+  std::copy(joints_max, joints_max + 3, settings.joints_max);
+  robot.setSettings(settings);
+  auto target = robot.forwardKinematics({0.25f, -0.25f, 0.5f});
+  auto result = robot.inverseKinematics(target[0], target[1], target[2]);
+  EXPECT_TRUE(robot.withinLimits(result));
+  EXPECT_NEAR((robot.forwardKinematics(result) - target).norm(), 0, 1e-2);
+}
+
+TEST(IKTest, cache) 
+{
+  Robot robot;  
+  robot.setIk(IkType::damped);
+  auto cache = std::make_shared<IkCache>(0.5f, 8);
+  robot.setIkCache(cache);
+  for (int k = 0; k < 3; ++k) {
+    for (size_t i = 0; i < 5; ++i) {
+      auto result = robot.inverseKinematics(xyz[i][0], xyz[i][1], xyz[i][2]);
+      auto xyz_result = robot.forwardKinematics(result);
+      EXPECT_NEAR(xyz_result[0], xyz[i][0], 1e-2);
+      EXPECT_NEAR(xyz_result[1], xyz[i][1], 1e-2);
+      EXPECT_NEAR(xyz_result[2], xyz[i][2], 1e-2);
+    }
+  }
+  EXPECT_EQ(cache->size(), 5u);
+  EXPECT_EQ(cache->misses(), 5u);
+  EXPECT_EQ(cache->hits(), 10u);
+
+  // near target: warm start from the cached solution
+  cache->clear();
+  robot.inverseKinematics(xyz[0][0], xyz[0][1], xyz[0][2]);
+  auto result = robot.inverseKinematics(xyz[0][0] + 0.01f, xyz[0][1], 
+    xyz[0][2]);
+  EXPECT_EQ(cache->warmHits(), 1u);
+  EXPECT_NEAR(robot.forwardKinematics(result)[0], xyz[0][0] + 0.01f, 1e-2);
+}
+
+TEST(IKTest, cacheEviction) 
+{
+  IkCache cache(1, 2);
+  Vector3<float> q;
+  cache.insert(0.5f, 0.5f, 0.5f, {1, 0, 0});
+  cache.insert(1.5f, 0.5f, 0.5f, {2, 0, 0});
+  EXPECT_EQ(cache.find(0.5f, 0.5f, 0.5f, q), IkCacheHit::exact);
+  EXPECT_EQ(q[0], 1);
+  // the first one was referenced: second chance, the second one goes
+  cache.insert(2.5f, 0.5f, 0.5f, {3, 0, 0});
+  EXPECT_EQ(cache.size(), 2u);
+  EXPECT_EQ(cache.find(1.5f, 0.5f, 0.5f, q), IkCacheHit::miss);
+  EXPECT_EQ(cache.find(0.7f, 0.5f, 0.5f, q), IkCacheHit::warm);
+  EXPECT_EQ(q[0], 1);
+  EXPECT_EQ(cache.find(2.5f, 0.5f, 0.5f, q), IkCacheHit::exact);
+  EXPECT_EQ(q[0], 3);
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <gtest/gtest.h>
+#include <integrator.h>
+#include <robot_system.h>
+#include <utils.h>
+
+using namespace remy_robot_control;
+
+TEST(Integrator, oscillator)
+{
+  // q'' = -q, from q = 1: q(t) = cos(t)
+  auto a = [](double, const Eigen::Vector3d& q, const Eigen::Vector3d&) {
+    return Eigen::Vector3d(-q);
+  };
+  auto run = [&a](IntegratorType type, double dt, double max_step,
+      double seconds, Eigen::Vector3d& q, Eigen::Vector3d& qd) {
+    IntegratorT<double> integrator(type, max_step);
+    q.setOnes();
+    qd.setZero();
+    for (int k = 0; k < (int) std::lround(seconds / dt); ++k) {
+      integrator.integrate(a, dt, q, qd);
+    }
+  };
+  Eigen::Vector3d q, qd;
+  auto error = [&](IntegratorType type, double dt, double max_step) {
+    run(type, dt, max_step, 2, q, qd);
+    return std::abs(q[0] - std::cos(2.));
+  };
+  // energy drift over many periods: the semi-implicit method keeps it bounded
+  auto drift = [&](IntegratorType type) {
+    run(type, 0.1, 0, 100, q, qd);
+    return std::abs(q[0] * q[0] + qd[0] * qd[0] - 1);
+  };
+  EXPECT_GT(drift(IntegratorType::euler), 1);
+  EXPECT_LT(drift(IntegratorType::semi_implicit), 0.1);
+
+  double rk4 = error(IntegratorType::rk4, 0.1, 0);
+  EXPECT_LT(rk4, 1e-5);
+  EXPECT_LT(rk4, error(IntegratorType::euler, 0.1, 0));
+  // sub-steps: the same accuracy whatever the caller step
+  EXPECT_NEAR(error(IntegratorType::rk4, 0.5, 0.1), rk4, 1e-9);
+  EXPECT_EQ(IntegratorT<double>(IntegratorType::rk4, 0.1).substeps(0.5), 5u);
+  EXPECT_EQ(IntegratorT<double>(IntegratorType::rk4, 0).substeps(0.5), 1u);
+}
+
+TEST(Integrator, plant)
+{
+  // a ramp of velocities through stiff velocity loops
+  std::vector<Eigen::Vector3f> setpoints(50);
+  for (size_t k = 0; k < setpoints.size(); ++k) {
+    setpoints[k] = Eigen::Vector3f::Constant(0.02f * k);
+  }
+  auto run = [&setpoints](IntegratorType type, double dt, double max_step) {
+    RobotSystem system;
+    system.save_run = false;
+    RemySystemSettings settings;
+    settings.actuator_tau = 0.02f;
+    settings.integrator = type;
+    settings.integrator_step = max_step;
+    system.setSettings(settings);
+    system.setControl(horizonToUchar(setpoints, 0, 0.01f));
+    for (int k = 0; k < (int) std::lround(0.5 / dt); ++k) {
+      system.step(dt);
+    }
+    return system.getJoints();
+  };
+  auto reference = run(IntegratorType::rk4, 0.001, 0.0001);
+  EXPECT_GT(reference[0], 0.1f);
+  // explicit Euler is unstable at dt > 2 tau, the sub-steps keep it accurate
+  EXPECT_GT((run(IntegratorType::euler, 0.05, 0) - reference).norm(), 0.1f);
+  EXPECT_LT((run(IntegratorType::rk4, 0.05, 0.005) - reference).norm(), 1e-3f);
+  EXPECT_LT((run(IntegratorType::semi_implicit, 0.05, 0.001) -
+    reference).norm(), 1e-2f);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <gtest/gtest.h> 
+#include <joint_block.h>
+
+using namespace remy_robot_control;
+
+TEST(Angle, wrapToPi) 
+{
+  for (float a = -50; a < 50; a += 0.01f) {
+    float expected = wrapToPi((double)a);
+    EXPECT_NEAR(expected, wrapToPi(a), 2e-6) << a;
+    EXPECT_LE(std::abs(wrapToPi(a)), kPi<float> + 1e-6f) << a;
+  }
+}
+
+TEST(JointBlock, methods) 
+{
+  RemyRobotSettings settings;
+  JointBlock<float> block(5, settings);
+  ASSERT_EQ(block.size(), 5);
+  for (size_t i = 0; i < block.size(); ++i) {
+    ASSERT_FLOAT_EQ(block.get(i)[0], 0);
+  }
+
+  block.set(1, {-4, 1.60, 8});
+  auto q = block.get(1);
+  ASSERT_FLOAT_EQ(q[0], 2 * M_PI - 4);
+  ASSERT_FLOAT_EQ(q[1], M_PI_2);
+  ASSERT_FLOAT_EQ(q[2], 8 - 2 * M_PI);
+
+  std::vector<float> u1(5, 1), u2(5, 4), u3(5, -13);
+  const float* u[3] = {u1.data(), u2.data(), u3.data()};
+  block.update(u, 1);
+  q = block.get(0);
+  ASSERT_FLOAT_EQ(q[0], 1);
+  ASSERT_FLOAT_EQ(q[1], - M_PI_2);
+  ASSERT_FLOAT_EQ(q[2], 4 * M_PI - 13);
+
+  // same as a robot joints
+  Angled a(1.60, - M_PI_2, M_PI_2);
+  a += 4.0f;
+  ASSERT_FLOAT_EQ(a(), block.get(1)[1]);
+}
@@ -33,6 +33,10 @@ TEST(JsonParser, RobotSettings)
   ASSERT_FLOAT_EQ(robot_settings.joints_max[0], 0.5);
   ASSERT_FLOAT_EQ(robot_settings.joints_max[1], 0.1);
   ASSERT_FLOAT_EQ(robot_settings.joints_max[2], 1);
+  ASSERT_FLOAT_EQ(robot_settings.joint_velocity_max[2], 3);
+  // missing: the default
+  ASSERT_FLOAT_EQ(robot_settings.joint_acceleration_max[0], 5);
+  ASSERT_FLOAT_EQ(robot_settings.retiming_step, 0.1);
 }
 
 TEST(JsonParser, SystemSettings) 
@@ -45,4 +49,38 @@ TEST(JsonParser, SystemSettings)
   ASSERT_EQ(system_settings.frequency, 1);
   ASSERT_EQ(system_settings.save_output, false);
   ASSERT_EQ(system_settings.encoder_resolution, 1000);
+  ASSERT_EQ(system_settings.encoder_output, EncoderOutput::ticks);
+}
+
+TEST(JsonParser, UnknownValues) 
+{
+  std::string input = std::string(TEST_DIR) + std::string("/config_test.json");
+  std::ifstream i(input);
+  json j;
+  i >> j;
+  j["robot_system"]["encoder_output"] = "degrees";
+  EXPECT_THROW(parseSystemSetting(j), std::invalid_argument);
+  j["robot_system"]["encoder_output"] = "ticks";
+  j["robot_system"]["encoder_resolution"] = 0;
+  EXPECT_THROW(parseSystemSetting(j), std::invalid_argument);
+  j["robot"]["ik"] = "newton";
+  EXPECT_THROW(parseRobotSetting(j), std::invalid_argument);
+  j["control"]["type"] = "pid";
+  EXPECT_THROW(parseControlSetting(j), std::invalid_argument);
+}
+
+TEST(JsonParser, ShippedConfig) 
+{
+  std::string input = std::string(CONFIG_DIR) + std::string("/config.json");
+  std::ifstream i(input);
+  json j;
+  i >> j;
+  ASSERT_NO_THROW(parseRobotSetting(j));
+  ASSERT_NO_THROW(parseSystemSetting(j));
+  auto control_settings = parseControlSetting(j);
+  ASSERT_EQ(control_settings.control_type, ControlType::feedfoward);
+
+  // the spelling of the older configurations
+  j["control"]["type"] = "feedfoward";
+  ASSERT_EQ(parseControlSetting(j).control_type, ControlType::feedfoward);
 }
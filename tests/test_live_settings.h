@@ -0,0 +1,135 @@
+#pragma once
+
+#include <gtest/gtest.h>
+#include <live_settings.h>
+#include <control.h>
+#include <robot_system.h>
+#include <utils.h>
+#include <settings.h>
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+using namespace remy_robot_control;
+
+TEST(LiveSettings, load)
+{
+  LiveSettings live;
+  EXPECT_EQ(live.version(), 1u);
+  EXPECT_EQ(live.read()->control.frequency, 50);
+
+  ASSERT_TRUE(live.load(std::string(TEST_DIR) + "/config_test.json"));
+  EXPECT_EQ(live.version(), 2u);
+  auto snapshot = live.read();
+  EXPECT_EQ(snapshot->robot.iktype, IkType::damped);
+  EXPECT_FLOAT_EQ(snapshot->robot.joints_max[2], 1);
+  EXPECT_EQ(snapshot->control.frequency, 14);
+  EXPECT_EQ(snapshot->system.encoder_output, EncoderOutput::ticks);
+
+  // invalid files keep the snapshot
+  EXPECT_FALSE(live.load("no_such_file.json"));
+  const std::string path = testing::TempDir() + "live_settings_test.json";
+  std::ofstream(path) << "{\"control\": {\"type\": \"analytical\"}}";
+  EXPECT_FALSE(live.load(path));
+  std::ofstream(path) << "{\"control\": ";
+  EXPECT_FALSE(live.load(path));
+  std::remove(path.c_str());
+  EXPECT_EQ(live.version(), 2u);
+}
+
+TEST(LiveSettings, robotKeepsJoints)
+{
+  Robot robot;
+  robot.setJoints(Eigen::Vector3f(0.3f, -0.2f, 1.5f));
+  RemyRobotSettings settings;
+  settings.ik_cache_resolution = 0.01f;
+  robot.setSettings(settings);
+  EXPECT_TRUE(robot.getJoints().isApprox(Eigen::Vector3f(0.3f, -0.2f, 1.5f)));
+  auto cache = robot.getIkCache();
+  ASSERT_TRUE(cache);
+
+  // narrower limits clamp the joints, and the same cache is kept
+  settings.joints_max[2] = 1;
+  robot.setSettings(settings);
+  EXPECT_TRUE(robot.getJoints().isApprox(Eigen::Vector3f(0.3f, -0.2f, 1)));
+  EXPECT_EQ(robot.getIkCache(), cache);
+  settings.ik_cache_capacity = 16;
+  robot.setSettings(settings);
+  EXPECT_NE(robot.getIkCache(), cache);
+}
+
+TEST(LiveSettings, control)
+{
+  std::string input = std::string(TEST_DIR) + std::string("/input.in");
+  Control control(input);
+  auto live = std::make_shared<LiveSettings>();
+  control.setLiveSettings(live);
+  const auto joints = eigen3fToUchar3(Eigen::Vector3f(0.1f, 0.2f, 0.3f));
+  EXPECT_EQ(control.step(joints, 1).size(), kJointsMsgSize);
+  EXPECT_FLOAT_EQ(control.period(), 0.02f);
+
+  // applied at the next step
+  RemyControlSettings settings;
+  settings.frequency = 10;
+  settings.horizon = 4;
+  live->publish(RemyRobotSettings(), settings, RemySystemSettings());
+  EXPECT_FLOAT_EQ(control.period(), 0.02f);
+  EXPECT_EQ(control.step(joints, 1.1f).size(), 16 + 4 * kJointsMsgSize);
+  EXPECT_FLOAT_EQ(control.period(), 0.1f);
+}
+
+TEST(LiveSettings, system)
+{
+  RobotSystem system;
+  system.setSettings(RemySystemSettings());
+  system.setJoints(Eigen::Vector3f(0.1f, 0.2f, 0.3f));
+  auto live = std::make_shared<LiveSettings>();
+  system.setLiveSettings(live);
+  EXPECT_EQ(system.step(0.01).size(), kJointsMsgSize);
+
+  // the loop reads while a loader publishes
+  std::atomic<bool> done(false);
+  std::thread loader([&]() {
+    for (int i = 0; i < 100; ++i) {
+      RemySystemSettings settings;
+      settings.frequency = 10 + i;
+      settings.encoder_output = (i % 2) ? EncoderOutput::ticks :
+        EncoderOutput::angle;
+      live->publish(RemyRobotSettings(), RemyControlSettings(), settings);
+    }
+    done = true;
+  });
+  while (!done) {
+    const auto q = system.step(0.001);
+    EXPECT_TRUE(q.size() == kJointsMsgSize || q.size() == kTicksMsgSize);
+  }
+  loader.join();
+  EXPECT_EQ(system.step(0.001).size(), kTicksMsgSize);
+  EXPECT_DOUBLE_EQ(system.period(), 0.009); // 1000 / 109 ms
+  EXPECT_TRUE(system.getJoints().isApprox(Eigen::Vector3f(0.1f, 0.2f, 0.3f),
+    1e-2f));
+}
+
+TEST(LiveSettings, encoderTables)
+{
+  RemySystemSettings settings;
+  settings.encoder_resolution = 1001;
+  LiveSettings live(RemyRobotSettings(), RemyControlSettings(), settings);
+  // a loop holds the table of the first snapshot
+  auto held = live.read()->encoder_table;
+  std::weak_ptr<const EncoderTable> first = held;
+  // two publishes before the loop moves on
+  settings.encoder_resolution = 1002;
+  live.publish(RemyRobotSettings(), RemyControlSettings(), settings);
+  std::weak_ptr<const EncoderTable> second = live.read()->encoder_table;
+  settings.encoder_resolution = 1003;
+  live.publish(RemyRobotSettings(), RemyControlSettings(), settings);
+  EXPECT_TRUE(second.expired());
+  // the loop lets it go without freeing it, the next publish frees it
+  held.reset();
+  EXPECT_FALSE(first.expired());
+  live.publish(RemyRobotSettings(), RemyControlSettings(), settings);
+  EXPECT_TRUE(first.expired());
+}
@@ -2,9 +2,27 @@
 #include "test_fk.h"
 #include "test_ik.h"
 #include "test_angle.h"
+#include "test_joint_block.h"
 #include "test_trajectory.h"
 #include "test_data_convert.h"
 #include "test_json_parser.h"
+#include "test_workspace.h"
+#include "test_fleet.h"
+#include "test_gain_sweep.h"
+#include "test_monte_carlo.h"
+#include "test_connection.h"
+#include "test_broadcast.h"
+#include "test_integrator.h"
+#include "test_dynamics.h"
+#include "test_flight_recorder.h"
+#include "test_replay.h"
+#include "test_trace.h"
+#include "test_scheduler.h"
+#include "test_batch_control.h"
+#include "test_retiming.h"
+#include "test_rcu.h"
+#include "test_live_settings.h"
+#include "test_allocations.h"
 
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv); 
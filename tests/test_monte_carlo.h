@@ -0,0 +1,73 @@
+#pragma once
+
+#include <gtest/gtest.h> 
+#include <monte_carlo.h>
+#include <control.h>
+#include <settings.h>
+
+// std
+#include <random>
+
+using namespace remy_robot_control;
+
+TEST(MonteCarlo, streamingStats) 
+{
+  std::mt19937 gen(7);
+  std::uniform_real_distribution<double> uniform(0, 10);
+  StreamingStats stats;
+  std::vector<double> samples(20000);
+  for (auto& x : samples) {
+    x = uniform(gen);
+    stats.add(x);
+  }
+  std::sort(samples.begin(), samples.end());
+  EXPECT_EQ(stats.count(), samples.size());
+  EXPECT_NEAR(stats.mean(), 5, 0.1);
+  EXPECT_NEAR(stats.stddev(), 10 / std::sqrt(12.), 0.05);
+  EXPECT_EQ(stats.min(), samples.front());
+  EXPECT_EQ(stats.max(), samples.back());
+  for (const auto& q : stats.quantiles()) {
+    double exact = samples[(size_t) (q.p() * samples.size())];
+    EXPECT_NEAR(q.value(), exact, 0.1);
+  }
+
+  P2Quantile few(0.5);
+  for (double x : {3., 1., 2.}) few.add(x);
+  EXPECT_EQ(few.value(), 2);
+}
+
+TEST(MonteCarlo, campaign) 
+{
+  std::string input = std::string(TEST_DIR) + std::string("/input.in");
+  auto waypoints = Control(input).getWaypoints();
+  SimulationCase base;
+  base.system.frequency = 1000;
+  base.seconds = 2;
+  MonteCarloSettings settings;
+  settings.runs = 12;
+  settings.batch = 5;
+
+  ThreadPool pool(2);
+  std::ostringstream csv;
+  auto summary = runMonteCarlo(waypoints, base, settings, pool, &csv);
+  EXPECT_EQ(summary.runs, 12u);
+  EXPECT_EQ(summary.rms_error.count() + summary.diverged, 12u);
+  EXPECT_GT(summary.rms_error.mean(), 0);
+  auto lines = csv.str();
+  EXPECT_EQ(std::count(lines.begin(), lines.end(), '\n'), 13);
+
+  // seeded: same campaign whatever the workers
+  ThreadPool single(1);
+  auto reference = runMonteCarlo(waypoints, base, settings, single);
+  EXPECT_EQ(summary.rms_error.mean(), reference.rms_error.mean());
+  EXPECT_EQ(summary.max_error.quantiles()[1].value(), 
+    reference.max_error.quantiles()[1].value());
+
+  SimulationCase a, b;
+  std::vector<Vector4<float>> wa, wb;
+  drawMonteCarloRun(waypoints, base, settings, 3, a, wa);
+  drawMonteCarloRun(waypoints, base, settings, 3, b, wb);
+  EXPECT_EQ(a.seed, b.seed);
+  EXPECT_EQ(a.jitter, b.jitter);
+  EXPECT_EQ(wa, wb);
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <gtest/gtest.h>
+#include <rcu.h>
+#include <control.h>
+#include <settings.h>
+
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+using namespace remy_robot_control;
+
+/** A version of the object of the tests: it poisons itself when deleted */
+struct RcuVersion {
+  static std::atomic<int> deleted;
+  int value;
+  int check;
+  explicit RcuVersion(int v) : value(v), check(- v) {}
+  ~RcuVersion() {
+    value = 1;
+    check = 1;
+    ++deleted;
+  }
+};
+std::atomic<int> RcuVersion::deleted(0);
+
+TEST(Rcu, publish)
+{
+  RcuVersion::deleted = 0;
+  {
+    Rcu<RcuVersion> rcu(std::make_unique<RcuVersion>(1));
+    EXPECT_EQ(rcu.read()->value, 1);
+    rcu.publish(std::make_unique<RcuVersion>(2));
+    EXPECT_EQ(RcuVersion::deleted, 1);
+    EXPECT_EQ(rcu.read()->value, 2);
+  }
+  EXPECT_EQ(RcuVersion::deleted, 2);
+  Rcu<RcuVersion> empty;
+  EXPECT_EQ(empty.read().get(), nullptr);
+}
+
+TEST(Rcu, waitsForReaders)
+{
+  // the old version lives until the read section which sees it is closed
+  RcuVersion::deleted = 0;
+  Rcu<RcuVersion> rcu(std::make_unique<RcuVersion>(1));
+  std::atomic<bool> published(false);
+  std::thread writer;
+  {
+    auto guard = rcu.read();
+    writer = std::thread([&]() {
+      rcu.publish(std::make_unique<RcuVersion>(2));
+      published = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(published);
+    EXPECT_EQ(RcuVersion::deleted, 0);
+    EXPECT_EQ(guard->value, 1);
+    // new sections already see the new version
+    EXPECT_EQ(rcu.read()->value, 2);
+  }
+  writer.join();
+  EXPECT_TRUE(published);
+  EXPECT_EQ(RcuVersion::deleted, 1);
+}
+
+TEST(Rcu, concurrent)
+{
+  // readers never see a deleted version while a writer keeps publishing
+  RcuVersion::deleted = 0;
+  const int versions = 2000;
+  {
+    Rcu<RcuVersion> rcu(std::make_unique<RcuVersion>(1));
+    std::atomic<bool> done(false);
+    std::atomic<int> torn(0);
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 2; ++r) {
+      readers.emplace_back([&]() {
+        int last = 0;
+        while (!done) {
+          auto guard = rcu.read();
+          const int v = guard->value;
+          for (volatile int spin = 0; spin < 100; ++spin) {}
+          if (guard->check != - v || v < last)
+            ++torn;
+          last = v;
+        }
+      });
+    }
+    for (int v = 2; v <= versions; ++v) {
+      rcu.publish(std::make_unique<RcuVersion>(v));
+    }
+    done = true;
+    for (auto& t : readers) {
+      t.join();
+    }
+    EXPECT_EQ(torn, 0);
+    EXPECT_EQ(RcuVersion::deleted, versions - 1);
+  }
+  EXPECT_EQ(RcuVersion::deleted, versions);
+}
+
+TEST(Rcu, controlHotSwap)
+{
+  std::string input = std::string(TEST_DIR) + std::string("/input.in");
+  Control control(input);
+  control.setSettings(RemyControlSettings());
+  const Eigen::Vector3f q(0.1f, 0.2f, 0.3f);
+  control.computeVelocityControl(q, 2);
+
+  // the new path starts at the first tick which reads it
+  std::vector<Eigen::Vector4f> waypoints = {
+    Eigen::Vector4f(15, 1, 1, 0),
+    Eigen::Vector4f(16, 0, 1, 2)
+  };
+  ASSERT_TRUE(control.loadAsync(waypoints).get());
+  EXPECT_EQ(control.getWaypoints(), waypoints);
+  Control fresh(waypoints);
+  fresh.setSettings(RemyControlSettings());
+  for (float t : {5.f, 6.f, 6.5f, 8.f}) {
+    control.computeVelocityControl(q, t);
+    fresh.computeVelocityControl(q, t - 5);
+    EXPECT_EQ(control.getControlSignal(), fresh.getControlSignal()) << t;
+  }
+
+  // invalid loads keep the trajectory
+  EXPECT_FALSE(control.loadAsync(std::string("no_such_file.in")).get());
+  EXPECT_FALSE(control.loadAsync({Eigen::Vector4f(15, 1, 1, 2),
+    Eigen::Vector4f(16, 0, 1, 1)}).get());
+  EXPECT_EQ(control.getWaypoints(), waypoints);
+  // and a file, while the loop reads
+  auto load = control.loadAsync(input);
+  for (int i = 0; i < 1000; ++i) {
+    control.computeVelocityControl(q, 9 + i * 1e-3f);
+  }
+  ASSERT_TRUE(load.get());
+  EXPECT_EQ(control.getWaypoints().size(), 7u);
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <gtest/gtest.h>
+#include <replay.h>
+#include <robot_system.h>
+#include <control.h>
+#include <scheduler.h>
+#include <settings.h>
+
+#include <chrono>
+#include <cstdio>
+
+using namespace remy_robot_control;
+
+/** It records a simulated run in a flight recorder dump */
+static std::string recordRun(const std::vector<Vector4<float>>& waypoints,
+    RecorderFormat format) {
+  Control control(waypoints);
+  RobotSystem system;
+  RemySystemSettings settings;
+  settings.frequency = 1000;
+  settings.recorder_seconds = 4;
+  settings.recorder_prefix = testing::TempDir() + "remy_replay";
+  settings.recorder_format = format;
+  system.setSettings(settings);
+  system.save_run = false;
+  const double dt = system.period();
+  size_t control_steps = 0;
+  for (size_t k = 1; k <= 3000; ++k) {
+    double t = k * dt;
+    auto joints = system.step(dt);
+    if (control_steps * (double) control.period() <= t + 1e-9) {
+      system.setControl(control.step(joints, (float) t));
+      ++control_steps;
+    }
+  }
+  return system.recorder->dump(DumpReason::request);
+}
+
+TEST(Replay, recorder)
+{
+  std::string input = std::string(TEST_DIR) + std::string("/input.in");
+  auto waypoints = Control(input).getWaypoints();
+  ReplaySettings settings;
+  settings.encoder_resolution = RemySystemSettings().encoder_resolution;
+
+  auto path = recordRun(waypoints, RecorderFormat::binary);
+  ASSERT_FALSE(path.empty());
+  {
+    LogReader log(path);
+    ASSERT_EQ(log.format(), LogFormat::recorder_binary);
+    Control control(waypoints);
+    auto result = replay(log, control, settings);
+    EXPECT_EQ(result.samples, 3000u);
+    EXPECT_GT(result.replayed, 100u);
+    EXPECT_EQ(result.mismatches, 0u);
+    EXPECT_LT(result.difference.max(), 1e-6);
+  }
+  {
+    // a controller change is caught
+    LogReader log(path);
+    Control control(waypoints);
+    RemyControlSettings changed;
+    changed.kp = 2;
+    control.setSettings(changed);
+    auto result = replay(log, control, settings);
+    EXPECT_GT(result.mismatches, 0u);
+    EXPECT_GT(result.first_mismatch, 0);
+  }
+  std::remove(path.c_str());
+
+  path = recordRun(waypoints, RecorderFormat::csv);
+  {
+    LogReader log(path);
+    ASSERT_EQ(log.format(), LogFormat::recorder_csv);
+    Control control(waypoints);
+    settings.tolerance = 1e-2f;
+    auto result = replay(log, control, settings);
+    EXPECT_EQ(result.samples, 3000u);
+    EXPECT_EQ(result.mismatches, 0u);
+  }
+  std::remove(path.c_str());
+}
+
+/** It runs a controller and a plant on a Scheduler, in real time, and it 
+ * replays the flight recorder dump of the run: the controller ticks at its
+ * own times, on joints of its own, which the recorded inputs reproduce */
+static void expectRunReplays(const RemyControlSettings& control_settings,
+    RecorderFormat format) {
+  std::string input = std::string(TEST_DIR) + std::string("/input.in");
+  Control control(input);
+  control.setSettings(control_settings);
+  RobotSystem system;
+  RemySystemSettings settings;
+  settings.frequency = 1000;
+  settings.save_output = false;
+  settings.recorder_seconds = 2;
+  settings.recorder_prefix = testing::TempDir() + "remy_replay_run";
+  settings.recorder_format = format;
+  system.setSettings(settings);
+  Scheduler scheduler;
+  system.start(control.connection, scheduler);
+  control.start(system.connection, scheduler);
+  scheduler.runUntil(ScheduledTask::Clock::now() + 
+    std::chrono::milliseconds(400));
+  control.stop();
+  system.stop();
+  const std::string path = system.recorder->lastDump();
+  ASSERT_FALSE(path.empty());
+
+  LogReader log(path);
+  Control replayed(input);
+  replayed.setSettings(control_settings);
+  auto result = replay(log, replayed);
+  EXPECT_GT(result.samples, 100u);
+  EXPECT_GT(result.replayed, 5u);
+  EXPECT_EQ(result.mismatches, 0u);
+  EXPECT_LT(result.difference.max(), 1e-6);
+  std::remove(path.c_str());
+}
+
+TEST(Replay, run)
+{
+  expectRunReplays(RemyControlSettings(), RecorderFormat::binary);
+  RemyControlSettings settings;
+  settings.control_type = ControlType::analytical;
+  settings.horizon = 5;
+  expectRunReplays(settings, RecorderFormat::csv);
+}
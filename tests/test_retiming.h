@@ -0,0 +1,130 @@
+#pragma once
+
+#include <gtest/gtest.h>
+#include <retiming.h>
+#include <control.h>
+#include <settings.h>
+
+using namespace remy_robot_control;
+
+static std::vector<Vector4<double>> retimingInput() {
+  std::string input = std::string(TEST_DIR) + std::string("/input.in");
+  auto waypoints = Controld(input).getWaypoints();
+  return waypoints;
+}
+
+static RemyRobotSettings retimingSettings() {
+  RemyRobotSettings settings;
+  settings.retiming_step = 0.05f;
+  return settings;
+}
+
+TEST(Retiming, limits)
+{
+  auto settings = retimingSettings();
+  RobotT<double> robot;
+  robot.setSettings(settings);
+  auto waypoints = retimingInput();
+  auto path = retime(waypoints, robot, settings);
+  ASSERT_TRUE(path.solved);
+  ASSERT_GT(path.waypoints.size(), waypoints.size());
+  EXPECT_EQ(path.waypoints.front(), Eigen::Vector4d(20, 0, 0, 0));
+  EXPECT_EQ(path.waypoints.back().head<3>(), Eigen::Vector3d(20, 0, 0));
+  EXPECT_DOUBLE_EQ(path.waypoints.back()[3], path.duration);
+  EXPECT_DOUBLE_EQ(path.input_duration, 10);
+
+  // the mean joint speeds of the intervals, and the accelerations between 
+  // them, within the limits (up to the discretization)
+  std::vector<Eigen::Vector3d> v;
+  std::vector<double> dt;
+  double ratio = 0;
+  for (size_t k = 1; k < path.waypoints.size(); ++k) {
+    const auto& a = path.waypoints[k - 1];
+    const auto& b = path.waypoints[k];
+    ASSERT_GT(b[3], a[3]);
+    dt.push_back(b[3] - a[3]);
+    v.push_back((robot.inverseKinematics(b[0], b[1], b[2]) - 
+      robot.inverseKinematics(a[0], a[1], a[2])) / dt.back());
+    for (int j = 0; j < 3; ++j) {
+      EXPECT_LE(std::abs(v.back()[j]), (double) settings.joint_velocity_max[j] * 1.05)
+        << "interval " << k << " joint " << j;
+      ratio = std::max(ratio, std::abs(v.back()[j]) / 
+        (double) settings.joint_velocity_max[j]);
+    }
+  }
+  for (size_t k = 1; k < v.size(); ++k) {
+    Eigen::Vector3d a = (v[k] - v[k - 1]) / ((dt[k] + dt[k - 1]) / 2);
+    for (int j = 0; j < 3; ++j) {
+      EXPECT_LE(std::abs(a[j]), (double) settings.joint_acceleration_max[j] * 1.1)
+        << "sample " << k << " joint " << j;
+      ratio = std::max(ratio, std::abs(a[j]) / 
+        (double) settings.joint_acceleration_max[j]);
+    }
+  }
+  // and the fastest: a limit is reached
+  EXPECT_GT(ratio, 0.9);
+}
+
+TEST(Retiming, scaling)
+{
+  // twice the speeds and four times the accelerations: half the time
+  auto settings = retimingSettings();
+  RobotT<double> robot;
+  robot.setSettings(settings);
+  auto waypoints = retimingInput();
+  auto path = retime(waypoints, robot, settings);
+  for (int j = 0; j < 3; ++j) {
+    settings.joint_velocity_max[j] *= 2;
+    settings.joint_acceleration_max[j] *= 4;
+  }
+  auto fast = retime(waypoints, robot, settings);
+  ASSERT_TRUE(path.solved && fast.solved);
+  EXPECT_NEAR(fast.duration, path.duration / 2, 1e-9 * path.duration);
+  EXPECT_NEAR(fast.input_velocity_ratio, path.input_velocity_ratio / 2, 
+    1e-9 * path.input_velocity_ratio);
+}
+
+TEST(Retiming, input)
+{
+  auto settings = retimingSettings();
+  RobotT<double> robot;
+  robot.setSettings(settings);
+  auto waypoints = retimingInput();
+  auto path = retime(waypoints, robot, settings);
+  ASSERT_TRUE(path.solved);
+  EXPECT_GT(path.input_velocity_ratio, 0);
+
+  // too slow joints for the input timestamps
+  for (int j = 0; j < 3; ++j) {
+    settings.joint_velocity_max[j] = 0.01f;
+  }
+  path = retime(waypoints, robot, settings);
+  ASSERT_TRUE(path.solved);
+  EXPECT_GT(path.input_velocity_ratio, 1);
+  EXPECT_GT(path.duration, path.input_duration);
+
+  // off, or without limits
+  settings.joint_acceleration_max[1] = 0;
+  EXPECT_FALSE(retime(waypoints, robot, settings).solved);
+  settings = retimingSettings();
+  settings.retiming_step = 0;
+  EXPECT_FALSE(retime(waypoints, robot, settings).solved);
+}
+
+TEST(Retiming, control)
+{
+  std::string input = std::string(TEST_DIR) + std::string("/input.in");
+  Control control(input);
+  EXPECT_FALSE(control.getRetiming().solved);
+  EXPECT_EQ(control.getWaypoints().size(), 7);
+
+  control.setRobotSettings(retimingSettings());
+  ASSERT_TRUE(control.getRetiming().solved);
+  EXPECT_EQ(control.getWaypoints().back()[3], control.getRetiming().duration);
+  EXPECT_GT(control.getWaypoints().size(), 7);
+
+  // the input is kept
+  control.setRobotSettings(RemyRobotSettings());
+  EXPECT_FALSE(control.getRetiming().solved);
+  EXPECT_EQ(control.getWaypoints().back()[3], 10);
+}
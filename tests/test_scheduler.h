@@ -0,0 +1,164 @@
+#pragma once
+
+#include <gtest/gtest.h>
+#include <scheduler.h>
+#include <control.h>
+#include <robot_system.h>
+#include <settings.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace remy_robot_control;
+
+/** It logs its id every period, n times */
+class PeriodicTask : public ScheduledTask {
+  int id;
+  std::chrono::microseconds period;
+  int remaining;
+  std::vector<int>& log;
+
+  public:
+    PeriodicTask(int i, std::chrono::microseconds p, int n, 
+      std::vector<int>& l) : id(i), period(p), remaining(n), log(l) {}
+
+    Clock::time_point resume(Clock::time_point now) override {
+      log.push_back(id);
+      return (--remaining > 0) ? now + period : finished();
+    }
+};
+
+TEST(Scheduler, order)
+{
+  Scheduler scheduler;
+  std::vector<int> log;
+  auto now = ScheduledTask::Clock::now();
+  PeriodicTask a(1, std::chrono::microseconds(0), 1, log);
+  PeriodicTask b(2, std::chrono::microseconds(0), 1, log);
+  PeriodicTask c(3, std::chrono::microseconds(0), 1, log);
+  scheduler.add(&a, now + std::chrono::milliseconds(2));
+  scheduler.add(&b, now);
+  scheduler.add(&c, now);
+  EXPECT_EQ(scheduler.size(), 3u);
+  // by time, then in the order they were added
+  EXPECT_EQ(scheduler.runUntil(now + std::chrono::milliseconds(50)), 3u);
+  EXPECT_EQ(log, std::vector<int>({2, 3, 1}));
+  // they finished
+  EXPECT_EQ(scheduler.size(), 0u);
+  EXPECT_FALSE(scheduler.remove(&a));
+}
+
+TEST(Scheduler, periodic)
+{
+  Scheduler scheduler;
+  std::vector<int> log;
+  PeriodicTask fast(1, std::chrono::milliseconds(1), 10, log);
+  PeriodicTask slow(2, std::chrono::milliseconds(4), 3, log);
+  scheduler.add(&fast);
+  scheduler.add(&slow);
+  auto start = ScheduledTask::Clock::now();
+  scheduler.runUntil(start + std::chrono::milliseconds(200));
+  EXPECT_EQ(std::count(log.begin(), log.end(), 1), 10);
+  EXPECT_EQ(std::count(log.begin(), log.end(), 2), 3);
+  // it slept between the periods
+  EXPECT_GE(ScheduledTask::Clock::now() - start, 
+    std::chrono::milliseconds(9));
+  EXPECT_EQ(scheduler.resumes(), 13u);
+}
+
+TEST(Scheduler, remove)
+{
+  Scheduler scheduler;
+  std::vector<int> log;
+  PeriodicTask a(1, std::chrono::milliseconds(1), 1000000, log);
+  scheduler.add(&a);
+  scheduler.start();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  // from another thread, while it may be running
+  EXPECT_TRUE(scheduler.remove(&a));
+  size_t n = log.size();
+  EXPECT_GT(n, 0u);
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_EQ(log.size(), n);
+  EXPECT_EQ(scheduler.size(), 0u);
+  scheduler.stop();
+}
+
+TEST(Scheduler, wake)
+{
+  Scheduler scheduler;
+  std::vector<int> log;
+  PeriodicTask a(1, std::chrono::milliseconds(0), 1, log);
+  auto now = ScheduledTask::Clock::now();
+  scheduler.add(&a, now + std::chrono::seconds(10));
+  EXPECT_TRUE(scheduler.wake(&a));
+  scheduler.runUntil(now + std::chrono::milliseconds(50));
+  EXPECT_EQ(log.size(), 1u);
+  // it finished
+  EXPECT_FALSE(scheduler.wake(&a));
+}
+
+TEST(Scheduler, controlWaits)
+{
+  // the controller waits for the joints of a slow plant without polling
+  std::string input = std::string(TEST_DIR) + std::string("/input.in");
+  Control control(input);
+  RobotSystem system;
+  RemySystemSettings settings;
+  settings.frequency = 10;
+  settings.save_output = false;
+  system.setSettings(settings);
+  Scheduler scheduler;
+  system.start(control.connection, scheduler);
+  control.start(system.connection, scheduler);
+  scheduler.runUntil(ScheduledTask::Clock::now() + 
+    std::chrono::milliseconds(500));
+  control.stop();
+  system.stop();
+  // it acts on the joints of every plant tick, woken up by them, and it
+  // resumes on its deadlines only in between
+  EXPECT_GE(control.connection->sequence(), 4u);
+  EXPECT_LT(scheduler.resumes(), 60u);
+}
+
+TEST(Scheduler, arms)
+{
+  // several controller/plant pairs on a single thread
+  std::string input = std::string(TEST_DIR) + std::string("/input.in");
+  const size_t arms = 4;
+  std::vector<std::unique_ptr<Control>> controls;
+  std::vector<std::unique_ptr<RobotSystem>> systems;
+  Scheduler scheduler;
+  for (size_t i = 0; i < arms; ++i) {
+    controls.push_back(std::make_unique<Control>(input));
+    systems.push_back(std::make_unique<RobotSystem>());
+    RemySystemSettings settings;
+    settings.frequency = 1000;
+    settings.recorder_seconds = 10;
+    settings.recorder_prefix = testing::TempDir() + "remy_scheduler_" + 
+      std::to_string(i);
+    systems.back()->setSettings(settings);
+    systems.back()->save_run = false;
+    systems.back()->start(controls.back()->connection, scheduler);
+    controls.back()->start(systems.back()->connection, scheduler);
+  }
+  EXPECT_EQ(scheduler.size(), 2 * arms);
+  scheduler.start();
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+  for (size_t i = 0; i < arms; ++i) {
+    controls[i]->stop();
+    systems[i]->stop();
+  }
+  EXPECT_EQ(scheduler.size(), 0u);
+  scheduler.stop();
+
+  for (size_t i = 0; i < arms; ++i) {
+    // the plant runs at 1 kHz and the controller moves it
+    EXPECT_GT(systems[i]->recorder->recorded(), 500u);
+    EXPECT_GT(controls[i]->getControlSignal().norm(), 0);
+    EXPECT_LT(controls[i]->getStaleCount(), 5u);
+    EXPECT_FALSE(systems[i]->connection->isOpened());
+    std::remove(systems[i]->recorder->lastDump().c_str());
+  }
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <gtest/gtest.h>
+#include <trace.h>
+
+#include <sstream>
+#include <thread>
+
+using namespace remy_robot_control;
+
+static size_t countOf(const std::string& s, const std::string& what) {
+  size_t n = 0;
+  for (size_t p = s.find(what); p != std::string::npos;
+      p = s.find(what, p + what.size()))
+    ++n;
+  return n;
+}
+
+TEST(Trace, zones)
+{
+  Tracer& tracer = Tracer::instance();
+  tracer.clear();
+
+  // disabled, nothing is recorded
+  tracer.enable(false);
+  { TraceZone zone("disabled"); }
+  EXPECT_EQ(tracer.events(), 0u);
+
+  tracer.enable();
+  auto work = [](const char* thread, int n) {
+    Tracer::instance().setThreadName(thread);
+    for (int i = 0; i < n; ++i) {
+      TraceZone outer("outer");
+      TraceZone inner("inner");
+    }
+  };
+  std::thread a(work, "thread_a", 10), b(work, "thread_b", 5);
+  a.join();
+  b.join();
+  tracer.enable(false);
+  EXPECT_EQ(tracer.events(), 30u);
+  EXPECT_EQ(tracer.dropped(), 0u);
+
+  std::stringstream ss;
+  ASSERT_TRUE(tracer.exportChrome(ss));
+  std::string json = ss.str();
+  const std::string header = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  EXPECT_EQ(json.compare(0, header.size(), header), 0);
+  EXPECT_EQ(countOf(json, "\"name\":\"outer\""), 15u);
+  EXPECT_EQ(countOf(json, "\"name\":\"inner\""), 15u);
+  EXPECT_EQ(countOf(json, "\"ph\":\"X\""), 30u);
+  EXPECT_EQ(countOf(json, "\"args\":{\"name\":\"thread_a\"}"), 1u);
+  EXPECT_EQ(countOf(json, "\"args\":{\"name\":\"thread_b\"}"), 1u);
+  EXPECT_EQ(json.substr(json.size() - 4), "\n]}\n");
+
+  tracer.clear();
+  EXPECT_EQ(tracer.events(), 0u);
+}
+
+TEST(Trace, dropped)
+{
+  Tracer& tracer = Tracer::instance();
+  tracer.clear();
+  tracer.setCapacity(4);
+  tracer.enable();
+  // a new thread gets a buffer of the new capacity
+  std::thread t([] {
+    for (int i = 0; i < 10; ++i)
+      TraceZone zone("zone");
+  });
+  t.join();
+  tracer.enable(false);
+  tracer.setCapacity(1 << 16);
+  EXPECT_EQ(tracer.events(), 4u);
+  EXPECT_EQ(tracer.dropped(), 6u);
+  tracer.clear();
+}
+
+TEST(Trace, reuse)
+{
+  Tracer& tracer = Tracer::instance();
+  tracer.enable();
+  auto run = [] {
+    std::thread t([] { TraceZone zone("zone"); });
+    t.join();
+  };
+  // the events of finished threads are kept until clear()
+  tracer.clear();
+  run();
+  run();
+  EXPECT_EQ(tracer.events(), 2u);
+  tracer.clear();
+
+  // then their buffers are reused
+  const size_t buffers = tracer.bufferCount();
+  for (int i = 0; i < 10; ++i) {
+    run();
+    EXPECT_EQ(tracer.events(), 1u);
+    tracer.clear();
+  }
+  EXPECT_EQ(tracer.bufferCount(), buffers);
+  tracer.enable(false);
+}
+
+#ifdef REMY_ENABLE_TRACING
+TEST(Trace, macros)
+{
+  Tracer& tracer = Tracer::instance();
+  tracer.clear();
+  tracer.enable();
+  std::thread t([] {
+    REMY_TRACE_THREAD("macros");
+    REMY_TRACE_ZONE("first");
+    REMY_TRACE_ZONE("second");
+  });
+  t.join();
+  tracer.enable(false);
+  EXPECT_EQ(tracer.events(), 2u);
+  std::stringstream ss;
+  tracer.exportChrome(ss);
+  EXPECT_EQ(countOf(ss.str(), "\"args\":{\"name\":\"macros\"}"), 1u);
+  tracer.clear();
+}
+#endif
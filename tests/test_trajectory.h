@@ -2,6 +2,10 @@
 
 #include <gtest/gtest.h> 
 #include <types.h>
+#include <aligned_allocator.h>
+
+#include <random>
+#include <cstdint>
 
 using namespace remy_robot_control;
 
@@ -74,4 +78,69 @@ TEST(Trajectory, update)
   ASSERT_FLOAT_EQ(traj.v[0], 5);
   ASSERT_FLOAT_EQ(traj.v[1], -1.5);
   ASSERT_FLOAT_EQ(traj.v[2], 1.5);
-}
\ No newline at end of file
+}
+TEST(Trajectory, index)
+{
+  // many segments of very uneven durations (some of them empty), and the
+  // reference lookup: a binary search of all the segments
+  std::mt19937 gen(3);
+  std::uniform_real_distribution<double> unit(0, 1);
+  std::vector<Eigen::Vector4d> waypoints;
+  double t = 0;
+  for (size_t k = 0; k < 100000; ++k) {
+    const double u = unit(gen);
+    t += (u < 0.1) ? 0 : (u < 0.9) ? u * 1e-3 : u * 10;
+    waypoints.push_back(Eigen::Vector4d(unit(gen), unit(gen), unit(gen), t));
+  }
+  Trajectoryd traj(waypoints);
+  ASSERT_EQ(traj.size(), waypoints.size());
+  ASSERT_EQ(traj.getWaypoints(), waypoints);
+
+  std::vector<double> times;
+  for (const auto& w : waypoints) {
+    times.push_back(w[3]);
+  }
+  auto expectMatches = [&](double t) {
+    auto it = std::lower_bound(times.begin(), times.end(), t);
+    if (it == times.end()) {
+      EXPECT_FALSE(traj.update(t));
+      return;
+    }
+    ASSERT_TRUE(traj.update(t)) << t;
+    size_t k = it - times.begin();
+    Eigen::Vector3d x0 = (k == 0) ? Eigen::Vector3d::Zero() : 
+      Eigen::Vector3d(waypoints[k - 1].head<3>());
+    Eigen::Vector3d xf = waypoints[k].head<3>();
+    double t0 = (k == 0) ? 0 : times[k - 1];
+    Eigen::Vector3d v = (times[k] == t0) ? Eigen::Vector3d::Zero() :
+      Eigen::Vector3d((xf - x0) / (times[k] - t0));
+    Eigen::Vector3d x = (times[k] == t0) ? xf : Eigen::Vector3d(x0 + v * 
+      (t - t0));
+    EXPECT_LE((traj.v - v).norm(), 1e-9 * std::max(1., v.norm())) << t;
+    EXPECT_LE((traj.x - x).norm(), 1e-6) << t;
+  };
+  // random seeks, and the waypoints themselves, forward and back
+  for (int i = 0; i < 100000; ++i) {
+    expectMatches(unit(gen) * t * 1.01 - 1);
+  }
+  for (size_t k = 0; k < times.size(); k += 7) {
+    expectMatches(times[k]);
+    expectMatches(times[times.size() - 1 - k]);
+  }
+}
+
+TEST(Trajectory, aligned)
+{
+  std::vector<float, AlignedAllocator<float>> a(3);
+  std::vector<double, AlignedAllocator<double>> b(1000);
+  EXPECT_EQ((uintptr_t) a.data() % kCacheLine, 0u);
+  EXPECT_EQ((uintptr_t) b.data() % kCacheLine, 0u);
+
+  // a single waypoint, and none
+  Trajectory one({Eigen::Vector4f(1, 2, 3, 0)});
+  ASSERT_TRUE(one.update(0));
+  EXPECT_EQ(one.x, Eigen::Vector3f(1, 2, 3));
+  EXPECT_FALSE(one.update(1));
+  Trajectory none({});
+  EXPECT_FALSE(none.update(0));
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <gtest/gtest.h> 
+#include <workspace.h>
+
+using namespace remy_robot_control;
+
+TEST(Workspace, sweep) 
+{
+  RemyRobotSettings settings;
+  ThreadPool pool(2);
+  auto cartesian = sweepCartesianGrid(settings, 1, pool);
+  auto joint = sweepJointGrid(settings, 1, 200, pool);
+  ASSERT_EQ(cartesian->size(), joint->size());
+
+  for (auto map : {cartesian.get(), joint.get()}) {
+    EXPECT_TRUE(map->isReachable(15, 0, 0));
+    EXPECT_TRUE(map->isReachable(-12, 5, 3));
+    EXPECT_FALSE(map->isReachable(0, 0, 0));
+    EXPECT_FALSE(map->isReachable(25, 0, 0));
+    EXPECT_FALSE(map->isReachable(0, 0, 50));
+    EXPECT_GT(map->manipulability(15, 0, 0), 0);
+  }
+
+  size_t agree = 0;
+  for (size_t i = 0; i < cartesian->size(); ++i) {
+    agree += (cartesian->data()[i] != 0) == (joint->data()[i] != 0);
+  }
+  EXPECT_GT(agree, 0.95 * cartesian->size());
+
+  const std::vector<Eigen::Vector4f> waypoints = {
+    Eigen::Vector4f(20.0, 0.0, 0.0, 0.0),
+    Eigen::Vector4f(15.0, 1.5, 1.5, 3.5),
+    Eigen::Vector4f(0.0, 0.0, 0.0, 5.0),
+    Eigen::Vector4f(15.0, -1.5, -1.5, 7.0)
+  };
+  auto unreachable = unreachableWaypoints(*cartesian, waypoints);
+  ASSERT_EQ(unreachable.size(), 1);
+  ASSERT_EQ(unreachable[0], 2);
+}
+
+TEST(Workspace, saveLoad) 
+{
+  RemyRobotSettings settings;
+  ThreadPool pool(2);
+  auto map = sweepCartesianGrid(settings, 0.5, pool);
+  std::string path = testing::TempDir() + "remy_workspace.map";
+  ASSERT_TRUE(map->save(path));
+  auto loaded = ReachabilityMap::load(path);
+  ASSERT_NE(loaded, nullptr);
+  ASSERT_EQ(loaded->size(), map->size());
+  ASSERT_EQ(loaded->reachableCount(), map->reachableCount());
+  EXPECT_EQ(loaded->value(15, 1, 2), map->value(15, 1, 2));
+  EXPECT_EQ(ReachabilityMap::load(path + ".missing"), nullptr);
+}
@@ -0,0 +1,55 @@
+// remy
+#include <fleet.h>
+
+// std
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace remy_robot_control;
+
+/** It simulates a fleet of cells (controller and plant pairs) on a pool of
+ * workers and reports the throughput. Each line of the fleet file describes
+ * one or more identical cells: <path_to_input> <path_to_config> [copies].
+ * Usage:
+ * ./RemyRobotControl_Fleet <path_to_fleet> [seconds] [threads]
+ */
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    std::cerr << "usage: " << argv[0] << " <path_to_fleet> [seconds]"
+      " [threads]\n";
+    return 1;
+  }
+  double seconds = (argc > 2) ? std::stod(argv[2]) : 11;
+  size_t threads = (argc > 3) ? std::stoul(argv[3]) : 0;
+
+  ThreadPool pool(threads);
+  Fleet fleet(pool);
+  std::ifstream file(argv[1]);
+  std::string line;
+  while (std::getline(file, line)) {
+    std::istringstream iss(line);
+    std::string input, config;
+    size_t copies = 1;
+    if (!(iss >> input >> config)) { continue; }
+    iss >> copies;
+    for (size_t i = 0; i < copies; ++i) {
+      fleet.add(input, config);
+    }
+  }
+  if (fleet.size() == 0) {
+    std::cerr << "no cells in " << argv[1] << "\n";
+    return 1;
+  }
+
+  auto report = fleet.run(seconds);
+  std::cout << "arms: " << report.arms << " on " << pool.size()
+    << " threads\n"
+    << "simulated: " << report.simulated_seconds << " s per arm ("
+    << report.plant_steps << " plant steps, " << report.control_steps
+    << " control steps)\n"
+    << "wall: " << report.wall_seconds << " s\n"
+    << "throughput: " << report.armSecondsPerWallSecond()
+    << " arm-s per wall-s\n";
+}
@@ -0,0 +1,79 @@
+// remy
+#include <gain_sweep.h>
+#include <control.h>
+#include <utils.h>
+
+// std
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+// 3rdparty
+#include <json.hpp>
+
+using namespace remy_robot_control;
+using json = nlohmann::json;
+
+/** It searches the feedforward control gains (kp, q0dot, damping_w0,
+ * damping_alpha0) with deterministic simulations of the configuration, in 
+ * parallel, and prints the best ones by tracking error (plus effort_weight 
+ * times the control effort). Usage:
+ * ./RemyRobotControl_GainSweep <path_to_input> <path_to_config> [grid|random]
+ *   [steps_or_samples] [effort_weight] [threads]
+ */
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    std::cerr << "usage: " << argv[0] << " <path_to_input> <path_to_config>"
+      " [grid|random] [steps_or_samples] [effort_weight] [threads]\n";
+    return 1;
+  }
+  std::string mode = (argc > 3) ? argv[3] : "random";
+  size_t n = (argc > 4) ? std::stoul(argv[4]) : 256;
+  double effort_weight = (argc > 5) ? std::stod(argv[5]) : 0;
+  size_t threads = (argc > 6) ? std::stoul(argv[6]) : 0;
+
+  std::ifstream i(argv[2]);
+  json j;
+  i >> j;
+  SimulationCase simulation;
+  simulation.robot = parseRobotSetting(j);
+  simulation.control = parseControlSetting(j);
+  simulation.system = parseSystemSetting(j);
+  auto waypoints = Control(argv[1]).getWaypoints();
+  if (!waypoints.empty())
+    simulation.seconds = waypoints.back()[3] + 1;
+
+  GainSpace space;
+  std::vector<RemyControlSettings> candidates;
+  if (mode == "grid")
+    candidates = gainGrid(simulation.control, space, (int) n);
+  else if (mode == "random")
+    candidates = randomGains(simulation.control, space, n, 42);
+  else {
+    std::cerr << "unknown mode: " << mode << "\n";
+    return 1;
+  }
+
+  ThreadPool pool(threads);
+  auto start = std::chrono::steady_clock::now();
+  auto entries = sweepGains(waypoints, simulation, candidates, pool, 
+    effort_weight);
+  std::chrono::duration<double> elapsed = 
+    std::chrono::steady_clock::now() - start;
+
+  std::cout << candidates.size() << " simulations in " << elapsed.count()
+    << " s on " << pool.size() << " threads\n\n"
+    << "  rank        kp     q0dot        w0    alpha0  rms error  max error"
+       "     effort  pareto\n";
+  for (size_t k = 0; k < std::min<size_t>(entries.size(), 10); ++k) {
+    const auto& e = entries[k];
+    std::cout << std::setw(6) << k + 1 << std::setprecision(4)
+      << std::setw(10) << e.control.kp << std::setw(10) << e.control.q0dot[0]
+      << std::setw(10) << e.control.damping_w0 << std::setw(10)
+      << e.control.damping_alpha0 << std::setw(11) << e.result.rms_error
+      << std::setw(11) << e.result.max_error << std::setw(11) 
+      << e.result.effort << std::setw(8) << (e.pareto ? "*" : "") << "\n";
+  }
+}
@@ -0,0 +1,81 @@
+// remy
+#include <monte_carlo.h>
+#include <control.h>
+#include <utils.h>
+
+// std
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <string>
+
+// 3rdparty
+#include <json.hpp>
+
+using namespace remy_robot_control;
+using json = nlohmann::json;
+
+static void print(const std::string& name, const StreamingStats& stats) {
+  std::cout << std::setw(14) << name << std::setprecision(4) << std::setw(11)
+    << stats.mean() << std::setw(11) << stats.stddev() << std::setw(11) 
+    << stats.min();
+  for (const auto& q : stats.quantiles()) {
+    std::cout << std::setw(11) << q.value();
+  }
+  std::cout << std::setw(11) << stats.max() << "\n";
+}
+
+/** It runs a seeded Monte Carlo campaign around a configuration: encoder
+ * resolution, control frequency, timing jitter, initial joints and waypoint
+ * noise are perturbed (\sa MonteCarloSettings). It prints the streaming
+ * summary and, optionally, writes one CSV line per run. Usage:
+ * ./RemyRobotControl_MonteCarlo <path_to_input> <path_to_config> [runs]
+ *   [seed] [threads] [path_to_csv]
+ */
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    std::cerr << "usage: " << argv[0] << " <path_to_input> <path_to_config>"
+      " [runs] [seed] [threads] [path_to_csv]\n";
+    return 1;
+  }
+  MonteCarloSettings settings;
+  settings.runs = (argc > 3) ? std::stoul(argv[3]) : 1000;
+  settings.seed = (argc > 4) ? (uint32_t) std::stoul(argv[4]) : 0;
+  size_t threads = (argc > 5) ? std::stoul(argv[5]) : 0;
+  std::unique_ptr<std::ofstream> csv;
+  if (argc > 6) {
+    csv = std::make_unique<std::ofstream>(argv[6]);
+    if (!*csv) {
+      std::cerr << "cannot write " << argv[6] << "\n";
+      return 1;
+    }
+  }
+
+  std::ifstream i(argv[2]);
+  json j;
+  i >> j;
+  SimulationCase base;
+  base.robot = parseRobotSetting(j);
+  base.control = parseControlSetting(j);
+  base.system = parseSystemSetting(j);
+  auto waypoints = Control(argv[1]).getWaypoints();
+  if (!waypoints.empty())
+    base.seconds = waypoints.back()[3] + 1;
+
+  ThreadPool pool(threads);
+  auto start = std::chrono::steady_clock::now();
+  auto summary = runMonteCarlo(waypoints, base, settings, pool, csv.get());
+  std::chrono::duration<double> elapsed = 
+    std::chrono::steady_clock::now() - start;
+
+  std::cout << summary.runs << " runs in " << elapsed.count() << " s on "
+    << pool.size() << " threads (" << summary.diverged << " diverged, "
+    << summary.saturated << " with saturation)\n\n"
+    << "                     mean     stddev        min        p50        p90"
+       "        p99        max\n";
+  print("rms error", summary.rms_error);
+  print("max error", summary.max_error);
+  print("saturations", summary.saturations);
+}
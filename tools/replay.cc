@@ -0,0 +1,75 @@
+// remy
+#include <replay.h>
+#include <control.h>
+#include <utils.h>
+
+// std
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <string>
+
+// 3rdparty
+#include <json.hpp>
+
+using namespace remy_robot_control;
+using json = nlohmann::json;
+
+/** It replays a recorded joint stream (out.csv, or a flight recorder dump)
+ * through the controller of a configuration, as fast as possible, and it
+ * diffs the control signals against the recorded ones (\sa replay). The
+ * joints are quantized with the encoder resolution of the configuration.
+ * It exits with 2 if a difference exceeds the tolerance, so it can gate
+ * controller changes. Usage:
+ * ./RemyRobotControl_Replay <path_to_input> <path_to_config> <path_to_log>
+ *   [on_change|every] [tolerance] [path_to_diff_csv]
+ */
+int main(int argc, char **argv) {
+  if (argc < 4) {
+    std::cerr << "usage: " << argv[0] << " <path_to_input> <path_to_config>"
+      " <path_to_log> [on_change|every] [tolerance] [path_to_diff_csv]\n";
+    return 1;
+  }
+  LogReader log(argv[3]);
+  if (log.format() == LogFormat::unknown) {
+    std::cerr << "unknown log format: " << argv[3] << "\n";
+    return 1;
+  }
+
+  std::ifstream i(argv[2]);
+  json j;
+  i >> j;
+  Control control(argv[1]);
+  control.setSettings(parseControlSetting(j));
+  control.setRobotSettings(parseRobotSetting(j));
+
+  ReplaySettings settings;
+  settings.encoder_resolution = parseSystemSetting(j).encoder_resolution;
+  if (argc > 4 && std::string(argv[4]) == "every")
+    settings.mode = ReplayMode::every;
+  if (argc > 5)
+    settings.tolerance = std::stof(argv[5]);
+  std::unique_ptr<std::ofstream> csv;
+  if (argc > 6) {
+    csv = std::make_unique<std::ofstream>(argv[6]);
+    if (!*csv) {
+      std::cerr << "cannot write " << argv[6] << "\n";
+      return 1;
+    }
+  }
+
+  auto result = replay(log, control, settings, csv.get());
+  const auto& d = result.difference;
+  std::cout << result.samples << " samples, " << result.replayed
+    << " replayed in " << result.wall_seconds << " s ("
+    << std::setprecision(4) << result.replayed / std::max(result.wall_seconds,
+      1e-9) << " per s)\n"
+    << "difference: mean " << d.mean() << ", p99 " << d.quantiles().back().value()
+    << ", max " << d.max() << "\n"
+    << result.mismatches << " mismatches above " << settings.tolerance;
+  if (result.mismatches > 0)
+    std::cout << ", the first at t = " << result.first_mismatch << " s";
+  std::cout << "\n";
+  return (result.mismatches > 0) ? 2 : 0;
+}
@@ -0,0 +1,64 @@
+// remy
+#include <workspace.h>
+#include <utils.h>
+
+// std
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+// 3rdparty
+#include <json.hpp>
+
+using namespace remy_robot_control;
+using json = nlohmann::json;
+
+/** It builds the reachability map of the arm for the joint limits of a 
+ * configuration file and saves it (to be memory-mapped by RemyRobotControl).
+ * Usage: 
+ * ./RemyRobotControl_Workspace <path_to_config> <path_to_map> [resolution] 
+ *   [joint|cartesian] [samples_per_joint] [threads]
+ */
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    std::cerr << "usage: " << argv[0] << " <path_to_config> <path_to_map>"
+      " [resolution] [joint|cartesian] [samples_per_joint] [threads]\n";
+    return 1;
+  }
+  float resolution = (argc > 3) ? std::stof(argv[3]) : 0.25f;
+  std::string mode = (argc > 4) ? argv[4] : "cartesian";
+  int samples = (argc > 5) ? std::stoi(argv[5]) : 256;
+  size_t threads = (argc > 6) ? std::stoul(argv[6]) : 0;
+
+  std::ifstream i(argv[1]);
+  json j;
+  i >> j;
+  auto settings = parseRobotSetting(j);
+
+  ThreadPool pool(threads);
+  auto start = std::chrono::steady_clock::now();
+  std::unique_ptr<ReachabilityMap> map;
+  if (mode == "joint")
+    map = sweepJointGrid(settings, resolution, samples, pool);
+  else if (mode == "cartesian")
+    map = sweepCartesianGrid(settings, resolution, pool);
+  else {
+    std::cerr << "unknown mode: " << mode << "\n";
+    return 1;
+  }
+  std::chrono::duration<double> elapsed = 
+    std::chrono::steady_clock::now() - start;
+
+  if (!map->save(argv[2])) {
+    std::cerr << "cannot write " << argv[2] << "\n";
+    return 1;
+  }
+  auto reachable = map->reachableCount();
+  const auto& h = map->header();
+  std::cout << "voxels: " << h.dims[0] << "x" << h.dims[1] << "x" << h.dims[2]
+    << " (" << map->size() << "), reachable: " << reachable << " ("
+    << reachable * h.resolution * h.resolution * h.resolution << " u^3)\n"
+    << "sweep: " << elapsed.count() << " s on " << pool.size() 
+    << " threads\n";
+}